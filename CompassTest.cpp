@@ -53,6 +53,9 @@ SOFTWARE.
 // #define USE_MCP2221 // default is now FT232H
 
 #include "MMC5983MA.hpp"
+#include "MMC5983MA_Acquisition.hpp"
+#include "MMC5983MA_Calibration.hpp"
+#include "MMC5983MA_Statistics.hpp"
 
 #include "CompassTest.h"
 
@@ -71,6 +74,24 @@ SOFTWARE.
   } compass;
 #endif
 
+// Measurements run on their own thread (see StartStopClicked), queuing results for the GUI
+typedef MMC5983MA_Acquisition_C<MMC5983MA_C_local> Acquisition_C;
+static Acquisition_C acquisition(compass);
+
+// Register-IO trace is recorded while measuring, and shown in the log afterwards, with the following #define:
+// #define MMC5983MA_PRINT_DETAILED_LOG
+#ifdef MMC5983MA_PRINT_DETAILED_LOG
+  static MMC5983MA_Trace_C registerTrace;
+  static void LogRegisterTrace() {
+      registerTrace.Drain([](const MMC5983MA_TraceRecord_T &r) {
+          char line[120];
+          MMC5983MA_C_local::FormatTraceRecord(line, sizeof(line), r);
+          wxLogMessage("%s", line);
+      });
+      if(registerTrace.Dropped()) wxLogMessage("(%u trace records dropped)", registerTrace.Dropped());
+  }
+#endif
+
 
 // ----------------------------------------------------------------------------
 // MyApp
@@ -113,6 +134,7 @@ MyFrame::MyFrame(const wxString& title)
 MyFrame::~MyFrame()
 {
     m_timer_TakeCompassReading.Stop();
+    acquisition.Stop();
     delete wxLog::SetActiveTarget(m_logOld);
  }
 
@@ -130,50 +152,113 @@ void MyFrame::OnAbout(wxCommandEvent& WXUNUSED(event))
 }
 
 void MyFrame::StartStopClicked(wxCommandEvent&) {
-    if (!compass.initialized) {
-        // Init:
-        // - locate and open an MCP2221 USB-to-Qwiic device
-        // - resets, verifies compass product ID over I2C bus, throws on failure
-        try {
-            compass.Init();
-        } catch(const std::exception& e) {
-            wxMessageDialog dialog(this, e.what(), "Error connecting to compass");
-            dialog.ShowModal();
-            return;
-        }
+    if (acquisition.GetState() == Acquisition_C::Running ||
+        acquisition.GetState() == Acquisition_C::Starting) {
+        acquisition.Stop();
+        m_timer_TakeCompassReading.Stop();
+        Display_Samples(); // anything measured before the worker stopped
+        MMC5983MA_PeriodicScheduler_C::Statistics_T st = acquisition.ScheduleStatistics();
+        wxLogMessage("Schedule: %u cycles, lateness mean %.0fus, jitter %.0fus, min %lldus, max %lldus; %u overruns (%u periods skipped)",
+            st.cycles, st.MeanLateness_us(), st.Jitter_us(), (long long)st.minLateness_us, (long long)st.maxLateness_us,
+            st.overruns, st.skippedPeriods);
+        return;
+    }
+    // The acquisition thread owns the compass from here until Stop:
+    // - first time, Init locates and opens the USB-to-Qwiic adapter,
+    //   resets, verifies compass product ID over I2C bus (throws on failure)
+    // - then measures every samplePeriod_us (on deadlines, not timer messages), queuing results for Display_Samples
+    #ifdef MMC5983MA_PRINT_DETAILED_LOG
+      compass.registerTrace = &registerTrace;
+    #endif
+    bool wasInitialized = compass.initialized;
+    Acquisition_C::Plan_T plan = acquisition.Start(samplePeriod_us);
+    if (!wasInitialized) wxLogMessage("Initializing compass...");
+    wxLogMessage("Sampling every %uus: %s, bandwidth code %d, estimated %uus per sample%s",
+        samplePeriod_us, Acquisition_C::ModeName(plan.mode), (int)plan.bandwidth, plan.estimated_us,
+        plan.fits ? "" : " (period too short!)");
+    m_timer_TakeCompassReading.Start(displayPeriod_ms);
+}
+
+// Runs on the GUI thread at display rate: show whatever the acquisition thread has measured
+void MyFrame::Display_Samples() {
+    if (acquisition.GetState() == Acquisition_C::Failed) {
+        m_timer_TakeCompassReading.Stop();
+        wxMessageDialog dialog(this, acquisition.ErrorText(), "Error connecting to compass");
+        dialog.ShowModal();
+        acquisition.Stop(); // join the finished thread
+        return;
+    }
+    if (!announcedInit && acquisition.GetState() == Acquisition_C::Running) { // Init completed on the acquisition thread
+        announcedInit = true;
         #ifdef USE_MCP2221
           wxLogMessage("%d MCP2221s found connected to this PC; first one opened OK.", compass.GetMCP2221().connectedDevices);
         #endif
-        assert(compass.initialized);
         wxLogMessage("Compass initialized AOK");
         wxLogMessage("=======================================");
-    };
-    if (m_timer_TakeCompassReading.IsRunning()) {
-        m_timer_TakeCompassReading.Stop();
-    } else {
-        m_timer_TakeCompassReading.Start(1000);
     }
+    // At high sample rates, show only the newest sample each display period;
+    // every sample feeds the calibration fit and the noise statistics (the acquisition thread corrects each one)
+    MMC5983MA_AcquiredSample_T sample;
+    uint32_t count = 0;
+    while (acquisition.samples.Pop(sample)) {
+        count++;
+        if (sample.result != 0) continue;
+        double field_mG[3];
+        FieldToMilliGauss(sample.field, field_mG);
+        calibration.Add(field_mG);
+        // continuous mode free-runs with Auto-SR; cached-offset samples are SET conversions with a RESET/SET offset
+        if (sample.mode == Acquisition_C::AutoSR || sample.mode == Acquisition_C::Continuous)
+            fieldStatistics[AutoSR].Add(field_mG);
+        else
+            fieldStatistics[CommandedSR].Add(field_mG);
+        if (sample.mode == Acquisition_C::ResetSetAndAutoSR) {
+            FieldToMilliGauss(sample.fieldAutoSR, field_mG);
+            fieldStatistics[AutoSR].Add(field_mG);
+        }
+    }
+    if (count > 0) { // refit once per display period, here rather than on the acquisition thread
+        correction = calibration.Solve();
+        acquisition.SetCorrection(correction);
+    }
+    if (count > 1) wxLogMessage("(%u samples since last display)", count);
+    if (count > 0) Show_Sample(sample);
+    if (acquisition.samples.Overruns() != reportedOverruns) {
+        reportedOverruns = acquisition.samples.Overruns();
+        wxLogMessage("Display fell behind: %u samples dropped so far", reportedOverruns);
+    }
+    #ifdef MMC5983MA_PRINT_DETAILED_LOG
+      LogRegisterTrace();
+    #endif
 }
 
 const double nominalFieldmG = 512.63; // ~ strength of Earth's field at Dave's desk; see below.
-void MyFrame::Make_A_Measurement() {
-    wxLogMessage("Measure_XYZ_Field_WithResetSet...");
-    compass.Measure_XYZ_Field_WithResetSet();
+void MyFrame::FieldToMilliGauss(const int32_t (&field)[3], double (&field_mG)[3]) {
+    for (int i = 0; i < 3; i++)
+        field_mG[i] = (double)field[i] / ((double)MMC5983MA_C_local::CountsPerGauss/1000.0); // ie 16.384
+}
+void MyFrame::Show_Sample(const MMC5983MA_AcquiredSample_T &sample) {
+    wxLogMessage("%s (sample %u, %lldus after deadline)...", Acquisition_C::ModeName(sample.mode), sample.sequence,
+        (long long)(sample.time_us - sample.deadline_us));
+    if (sample.result != 0) wxLogMessage("Measurement failed (%d)", sample.result);
     wxLogMessage("-----------");
-    wxLogMessage("Compass: SET/RESET offsets (zero-point, nominal 0x20000): x%05lx, x%05lx, x%05lx", compass.offset[0], compass.offset[1], compass.offset[2]);
-    wxLogMessage("Compass: sensors (adjusted for offset): x%05lx, x%05lx, x%05lx", compass.field[0], compass.field[1], compass.field[2]);
+    wxLogMessage("Compass: SET/RESET offsets (zero-point, nominal 0x20000): x%05lx, x%05lx, x%05lx", sample.offset[0], sample.offset[1], sample.offset[2]);
+    wxLogMessage("Compass: sensors (adjusted for offset): x%05lx, x%05lx, x%05lx", sample.field[0], sample.field[1], sample.field[2]);
     //
-    // WAG as to sign and X vs. Y orientation
-    double heading = 180.0 - atan2(-compass.field[0], -compass.field[1]) * 180 / M_PI;
+    // WAG as to sign and X vs. Y orientation; calibrated if the acquisition thread corrected this sample
+    double field_mG[3];
+    FieldToMilliGauss(sample.field, field_mG);
+    bool calibrated = sample.calibration != MMC5983MA_EllipsoidCalibration_C::None;
+    const double (&headingField_mG)[3] = calibrated ? sample.calibrated_mG : field_mG;
+    double heading = 180.0 - atan2(-headingField_mG[0], -headingField_mG[1]) * 180 / M_PI;
     wxString report_Heading;
-    report_Heading.Printf("Compass: %6.2f", heading);
+    report_Heading.Printf("Compass: %6.2f%s", heading, calibrated ? " (calibrated)" : "");
     m_CompassResult_staticText->SetLabelText(report_Heading);
     wxLogMessage(report_Heading);
     //
     // Detail into m_CompassOffsets_staticText
     double offset_mG[3]; double averageOffset_mG = 0.0;
     for (int i = 0; i < 3; i++) {
-        offset_mG[i] = (double)(((int)compass.offset[i])-0x20000) / 16.384;
+        offset_mG[i] = (double)(((int)sample.offset[i])-0x20000) / 16.384;
         averageOffset_mG += abs(offset_mG[i])/3;
     };
     wxString report_offset;
@@ -190,11 +275,9 @@ void MyFrame::Make_A_Measurement() {
      *      Total   Horizontal       North       East     Vertical  Declination  Inclination
      *  51,263 nT    20,728 nT   20,104 nT   -5047 nT    46,885 nT      -14.09       66.15
      */
-    double sensors_mG[3]; double totalField_mG = 0.0;
-    auto Report_Field_mG = [this, &sensors_mG, &totalField_mG] (const char* pContextString) {
+    auto Report_Field_mG = [this] (const char* pContextString, const double (&sensors_mG)[3]) {
+        double totalField_mG = 0.0;
         for (int i = 0; i < 3; i++) {
-            sensors_mG[i] = (double)compass.field[i] /
-                ((double)MMC5983MA_C_local::CountsPerGauss/1000.0); // ie 16.384
             totalField_mG += pow(sensors_mG[i],2);
         };
         totalField_mG = sqrt(totalField_mG);
@@ -207,27 +290,54 @@ void MyFrame::Make_A_Measurement() {
         report_FieldStrength.Replace("%", "%%"); // so wxLog doesn't expand percentage as a printf-style format specifier
         wxLogMessage(report_FieldStrength);
     };
-    Report_Field_mG("cmd  SR");
+    Report_Field_mG(sample.mode == Acquisition_C::AutoSR ? "Auto-SR" : sample.mode == Acquisition_C::Continuous ? "contin." :
+                    sample.mode == Acquisition_C::CachedOffset ? "cached " : "cmd  SR",
+        field_mG);
+    if (sample.mode == Acquisition_C::ResetSetAndAutoSR) {
+        double fieldAutoSR_mG[3];
+        FieldToMilliGauss(sample.fieldAutoSR, fieldAutoSR_mG);
+        Report_Field_mG("Auto-SR", fieldAutoSR_mG);
+    }
     //
-    static double minReadings_mG[3] = { 0.0, 0.0, 0.0 }, maxReadings_mG[3] = {0.0, 0.0, 0.0}, avgReadings_mG[3] = { 0.0, 0.0, 0.0 };
-    for (int i = 0; i < 3; i++) {
-        if (sensors_mG[i] < minReadings_mG[i]) minReadings_mG[i] = sensors_mG[i];
-        if (sensors_mG[i] > maxReadings_mG[i]) maxReadings_mG[i] = sensors_mG[i];
-        avgReadings_mG[i] = (minReadings_mG[i] + maxReadings_mG[i]) / 2;
-    };
-    wxString report_MinMax;
-    report_MinMax.Printf("XYZ mG [Min,Max]: [%6.2f,%6.2f] [%6.2f,%6.2f] [%6.2f,%6.2f]",
-        minReadings_mG[0], maxReadings_mG[0], minReadings_mG[1], maxReadings_mG[1], minReadings_mG[2], maxReadings_mG[2]);
-    m_CompassMinMax_staticText->SetLabel(report_MinMax);
-    wxLogMessage(report_MinMax);
+    // Hard/soft-iron calibration: ellipsoid fit over every sample so far (replaces per-axis min/max midpoints,
+    // which can't see soft iron or gain differences between axes). Rotate and tilt the sensor to build it up.
+    wxString report_Calibration;
+    report_Calibration.Printf("Calibration (%s, %u samples, fit error %4.2f%%): bias mG %6.2f, %6.2f, %6.2f; field %6.2fmG",
+        MMC5983MA_EllipsoidCalibration_C::ModelName(correction.model), correction.samples, 100.0 * correction.fitError,
+        correction.bias_mG[0], correction.bias_mG[1], correction.bias_mG[2], correction.radius_mG);
+    m_CompassMinMax_staticText->SetLabel(report_Calibration);
+    report_Calibration.Replace("%", "%%"); // so wxLog doesn't expand percentage as a printf-style format specifier
+    wxLogMessage(report_Calibration);
     //
-    wxString report_AvgMinMax;
-    report_AvgMinMax.Printf("XYZ averageMinMax mG (observed additional offset): %6.2f, %6.2f, %6.2f", avgReadings_mG[0], avgReadings_mG[1], avgReadings_mG[2]);
-    m_ObservedCompassOffsets_staticText->SetLabel(report_AvgMinMax);
-    wxLogMessage(report_AvgMinMax);
+    wxString report_SoftIron;
+    report_SoftIron.Printf("Soft-iron correction: [%6.3f %6.3f %6.3f] [%6.3f %6.3f %6.3f] [%6.3f %6.3f %6.3f]",
+        correction.matrix[0][0], correction.matrix[0][1], correction.matrix[0][2],
+        correction.matrix[1][0], correction.matrix[1][1], correction.matrix[1][2],
+        correction.matrix[2][0], correction.matrix[2][1], correction.matrix[2][2]);
+    m_ObservedCompassOffsets_staticText->SetLabel(report_SoftIron);
+    wxLogMessage(report_SoftIron);
+    if (calibrated) Report_Field_mG("calibr.", sample.calibrated_mG);
     //
-    compass.Measure_XYZ_Field_WithAutoSR();
-    Report_Field_mG("Auto-SR");
+    // Mean and noise (standard deviation) of each stream, session and recent windows, to compare the modes
+    typedef MMC5983MA_FieldStatistics_C<> FieldStatistics_C;
+    auto Report_Noise_mG = [] (const char* pContextString, const char* pViewString, const FieldStatistics_C::View_T &v) {
+        if (v.Count() < 2) return;
+        wxLogMessage("Noise mG(%s, %s, %u samples): X=%5.3f, Y=%5.3f, Z=%5.3f, Total=%5.3f (mean %6.2f, range %6.2f)",
+            pContextString, pViewString, v.Count(),
+            v.channel[FieldStatistics_C::X].StdDev(), v.channel[FieldStatistics_C::Y].StdDev(), v.channel[FieldStatistics_C::Z].StdDev(),
+            v.channel[FieldStatistics_C::Magnitude].StdDev(), v.channel[FieldStatistics_C::Magnitude].mean,
+            v.channel[FieldStatistics_C::Magnitude].max - v.channel[FieldStatistics_C::Magnitude].min);
+    };
+    static const char *streamNames[FieldStreams] = { "cmd  SR", "Auto-SR" };
+    for (int stream = 0; stream < FieldStreams; stream++) {
+        const FieldStatistics_C &stats = fieldStatistics[stream];
+        Report_Noise_mG(streamNames[stream], "session", stats.Session());
+        for (int w = 0; w < FieldStatistics_C::Windows; w++) {
+            char window[24];
+            snprintf(window, sizeof(window), "last %u", stats.WindowLength(w));
+            Report_Noise_mG(streamNames[stream], window, stats.Window(w));
+        }
+    }
 
 
 
@@ -34,6 +34,9 @@ SOFTWARE.
 
 #include "LayoutGeneratedFiles/CompassLayout_Base_Classes.h"
 #include "MMC5983MA.hpp"
+#include "MMC5983MA_Acquisition.hpp"
+#include "MMC5983MA_Calibration.hpp"
+#include "MMC5983MA_Statistics.hpp"
 
 // Define my application type
 class MyApp: public wxApp
@@ -60,11 +63,22 @@ protected:
 
     // Start, stop, and execute timer callback
     virtual void StartStopClicked(wxCommandEvent& event) override;
-    virtual void OnTimer(wxTimerEvent& WXUNUSED(event)) override { Make_A_Measurement(); };
+    /// Display timer: measurements are taken by the acquisition thread, not here
+    virtual void OnTimer(wxTimerEvent& WXUNUSED(event)) override { Display_Samples(); };
 
 private:
     wxLog *m_logOld = 0;
-    void Make_A_Measurement();
+    static const int displayPeriod_ms = 100;
+    static const uint32_t samplePeriod_us = 1000000; ///< 1Hz; try 10000 (100Hz) down to 1000 (1kHz, continuous mode)
+    bool announcedInit = false;
+    uint32_t reportedOverruns = 0;
+    MMC5983MA_EllipsoidCalibration_C calibration; ///< fed every sample (Display_Samples)
+    MMC5983MA_EllipsoidCalibration_C::Correction_T correction; ///< refit each display period, published to the acquisition thread
+    enum { CommandedSR, AutoSR, FieldStreams }; ///< fieldStatistics index: RESET/SET (and cached-offset) vs. Auto-SR (and continuous) measurements
+    MMC5983MA_FieldStatistics_C<> fieldStatistics[FieldStreams]; ///< mean and noise of every sample of each stream
+    void Display_Samples();
+    static void FieldToMilliGauss(const int32_t (&field)[3], double (&field_mG)[3]);
+    void Show_Sample(const MMC5983MA_AcquiredSample_T &sample);
 
     wxDECLARE_NO_COPY_CLASS(MyFrame);
 };
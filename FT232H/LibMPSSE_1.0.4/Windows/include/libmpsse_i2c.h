@@ -24,6 +24,10 @@
  * 0.2 - 20110708 - added macro I2C_DISABLE_3PHASE_CLOCKING
  * 0.3 - 20200428 - removed unnecessary files and directory structure
  *                  type of bool changed to unsigned int match WinTypes.h
+ * 0.4 - 20261017 - added I2C_Batch functions (several transfers and delays in one USB transfer)
+ *                  added I2C_DeviceWriteRead
+ *                  added I2C_GetTransferStatistics, I2C_SetLegacyTransfers
+ *                  added I2C_BatchQueueWaitGPIOL1 (wait for a device's interrupt/data-ready line)
  */
 
 #ifndef FTDI_I2C_H
@@ -188,6 +192,44 @@ typedef struct ChannelConfig_t
 								/* BIT15 -BIT8:   Current values of the pins	*/
 } ChannelConfig;
 
+/* Maximum number of reads and acknowledge bits that one I2C_Batch can return */
+#define I2C_BATCH_MAX_READS		16
+#define I2C_BATCH_MAX_ACKS		64
+
+/* Sequence of I2C transfers and delays, compiled into a single MPSSE command buffer
+and executed with one write and one read of the USB channel (see I2C_BatchBegin).
+Members are private to the library; the caller only provides storage. */
+typedef struct I2C_Batch_t
+{
+	UCHAR		*cmdBuffer;		/* caller-provided buffer for MPSSE commands (also receives the response) */
+	DWORD		cmdBufferSize;
+	DWORD		cmdLength;		/* bytes of MPSSE commands queued so far */
+	DWORD		responseLength;	/* bytes the MPSSE will return (ACK bits and read data) */
+	DWORD		clockRate;		/* I2C clock rate in Hz, converts delays into clock cycles */
+	FT_STATUS	status;			/* first error encountered while queuing */
+	DWORD		numReads;
+	struct {
+		UCHAR	*buffer;		/* where read data is copied by I2C_BatchFlush */
+		DWORD	size;
+		DWORD	responseOffset;
+	} reads[I2C_BATCH_MAX_READS];
+	DWORD		numAcks;
+	struct {
+		DWORD	responseOffset;
+		UCHAR	isAddress;		/* address byte (nAck => FT_DEVICE_NOT_FOUND) or data byte */
+	} acks[I2C_BATCH_MAX_ACKS];
+} I2C_Batch;
+
+/* Per-channel transfer counters (see I2C_GetTransferStatistics) */
+typedef struct I2C_TransferStatistics_t
+{
+	DWORD	transfers;			/* I2C_DeviceRead/I2C_DeviceWrite/I2C_BatchFlush calls */
+	DWORD	failures;			/* ...of which did not return FT_OK */
+	DWORD	purges;				/* USB buffer purges (only before a transfer following a failure, unless legacy) */
+	DWORD	arenaUses;			/* command buffers taken from the channel's preallocated arena */
+	DWORD	heapAllocations;	/* command buffers allocated because the arena was too small (or legacy) */
+} I2C_TransferStatistics;
+
 /******************************************************************************/
 /*								External variables							  */
 /******************************************************************************/
@@ -355,6 +397,31 @@ FTDIMPSSE_API FT_STATUS I2C_DeviceRead(FT_HANDLE handle, UCHAR deviceAddress,
 FTDIMPSSE_API FT_STATUS I2C_DeviceWrite(FT_HANDLE handle, UCHAR deviceAddress,
 	DWORD sizeToTransfer, UCHAR *buffer, LPDWORD sizeTransfered, DWORD options);
 
+/*!
+ * \brief Writes then reads an I2C slave using a repeated start (ie register address, then register data)
+ *
+ * This function generates START, address+W, data written, repeated START, address+R,
+ * data read (last byte nAcked), STOP as one MPSSE command buffer, and collects all ACK bits
+ * and read data with a single read-back: one USB round trip, where I2C_DeviceWrite followed
+ * by I2C_DeviceRead costs one or more round trips per byte.
+ *
+ * \param[in] handle Handle of the channel
+ * \param[in] deviceAddress Address of the I2C slave
+ * \param[in] sizeToWrite Number of bytes to be written (at most I2C_BATCH_MAX_ACKS-2)
+ * \param[in] writeBuffer Pointer to the buffer from where data is to be written
+ * \param[in] sizeToRead Number of bytes to be read
+ * \param[out] readBuffer Pointer to the buffer where data is to be read
+ * \param[out] sizeTransferred Pointer to variable containing the number of bytes read
+ * \return Returns status code of type FT_STATUS(see D2XX Programmer's Guide).
+ *		FT_DEVICE_NOT_FOUND if the slave did not ack its address
+ * \sa I2C_BatchQueueWriteRead
+ * \note
+ * \warning
+ */
+FTDIMPSSE_API FT_STATUS I2C_DeviceWriteRead(FT_HANDLE handle, UCHAR deviceAddress,
+	DWORD sizeToWrite, UCHAR *writeBuffer, DWORD sizeToRead, UCHAR *readBuffer,
+	LPDWORD sizeTransferred);
+
 /*!
  * \brief Get the I2C device ID
  *
@@ -373,6 +440,148 @@ FTDIMPSSE_API FT_STATUS I2C_DeviceWrite(FT_HANDLE handle, UCHAR deviceAddress,
 FTDIMPSSE_API FT_STATUS I2C_GetDeviceID(FT_HANDLE handle, UCHAR deviceAddress,
 	UCHAR *deviceID);
 
+/*!
+ * \brief Starts building a batch of I2C transfers and delays
+ *
+ * Each unbatched I2C_DeviceRead/I2C_DeviceWrite costs several USB round trips. A batch
+ * collects complete transfers (START..STOP) and delays into one MPSSE command buffer,
+ * which I2C_BatchFlush sends with a single write followed by a single read.
+ *
+ * \param[out] batch Batch to initialize
+ * \param[in] cmdBuffer Buffer for MPSSE commands; about 220 bytes per queued register write
+ * \param[in] cmdBufferSize Size of cmdBuffer in bytes
+ * \param[in] clockRate I2C clock rate the channel was initialized with (ChannelConfig.ClockRate)
+ * \return Returns status code of type FT_STATUS(see D2XX Programmer's Guide)
+ * \sa I2C_BatchQueueWrite, I2C_BatchQueueWriteRead, I2C_BatchQueueDelay, I2C_BatchQueueWaitGPIOL1,
+ *		I2C_BatchFlush
+ * \note Queuing functions record the first error (ie buffer overflow) in the batch, which
+ *		I2C_BatchFlush then returns without touching the bus.
+ * \warning
+ */
+FTDIMPSSE_API FT_STATUS I2C_BatchBegin(I2C_Batch *batch, UCHAR *cmdBuffer,
+	DWORD cmdBufferSize, DWORD clockRate);
+
+/*!
+ * \brief Queues a complete write transfer (START, address, data, STOP)
+ *
+ * \param[in] batch Batch being built
+ * \param[in] deviceAddress Address of the I2C slave
+ * \param[in] sizeToTransfer Number of bytes to be written
+ * \param[in] buffer Data to be written; copied into the batch immediately
+ * \return Returns status code of type FT_STATUS(see D2XX Programmer's Guide)
+ * \sa
+ * \note
+ * \warning
+ */
+FTDIMPSSE_API FT_STATUS I2C_BatchQueueWrite(I2C_Batch *batch, UCHAR deviceAddress,
+	DWORD sizeToTransfer, const UCHAR *buffer);
+
+/*!
+ * \brief Queues a combined write-then-read transfer (START, address, data, RESTART, address, read, STOP)
+ *
+ * Typically used to write a register address, then read one or more registers.
+ * The last byte read is nAcked.
+ *
+ * \param[in] batch Batch being built
+ * \param[in] deviceAddress Address of the I2C slave
+ * \param[in] sizeToWrite Number of bytes to be written before the repeated start
+ * \param[in] writeBuffer Data to be written; copied into the batch immediately
+ * \param[in] sizeToRead Number of bytes to be read
+ * \param[out] readBuffer Buffer receiving the read data; filled by I2C_BatchFlush
+ * \return Returns status code of type FT_STATUS(see D2XX Programmer's Guide)
+ * \sa
+ * \note
+ * \warning readBuffer must remain valid until I2C_BatchFlush returns
+ */
+FTDIMPSSE_API FT_STATUS I2C_BatchQueueWriteRead(I2C_Batch *batch, UCHAR deviceAddress,
+	DWORD sizeToWrite, const UCHAR *writeBuffer, DWORD sizeToRead, UCHAR *readBuffer);
+
+/*!
+ * \brief Queues a delay, executed by the MPSSE between transfers
+ *
+ * The SCL/SDA pins are released (tristated) and the MPSSE clocks for the required number of
+ * cycles with no data transfer, so the delay is timed by the FT232H rather than the host.
+ *
+ * \param[in] batch Batch being built
+ * \param[in] microseconds Delay required
+ * \return Returns status code of type FT_STATUS(see D2XX Programmer's Guide)
+ * \sa
+ * \note Delay resolution is one I2C clock period
+ * \warning
+ */
+FTDIMPSSE_API FT_STATUS I2C_BatchQueueDelay(I2C_Batch *batch, DWORD microseconds);
+
+/*!
+ * \brief Queues a wait for GPIOL1 (ADBUS5), ie a device's interrupt or data-ready output
+ *
+ * The MPSSE clocks with SCL/SDA released (as I2C_BatchQueueDelay) until GPIOL1 reaches the
+ * requested level or the timeout expires, so the following transfers start as soon as the
+ * device signals, with no host involvement.
+ *
+ * \param[in] batch Batch being built
+ * \param[in] high Wait for GPIOL1 high (TRUE) or low (FALSE)
+ * \param[in] timeoutMicroseconds Longest wait
+ * \param[out] pinsAfter If not NULL, receives the ADBUS pin levels after the wait (bit 5 is
+ *		GPIOL1, so a timeout can be told from the signal); filled by I2C_BatchFlush
+ * \return Returns status code of type FT_STATUS(see D2XX Programmer's Guide)
+ * \sa
+ * \note Uses the FT232H "clock or until GPIOL1" commands (0x9C/0x9D), which never wait
+ *		longer than the timeout, rather than "wait on I/O" (0x88/0x89), which waits forever.
+ *		GPIOL1 must be an input (libMPSSE I2C leaves it so).
+ * \warning pinsAfter must remain valid until I2C_BatchFlush returns
+ */
+FTDIMPSSE_API FT_STATUS I2C_BatchQueueWaitGPIOL1(I2C_Batch *batch, BOOL high,
+	DWORD timeoutMicroseconds, UCHAR *pinsAfter);
+
+/*!
+ * \brief Executes a batch: one USB write of all commands, one USB read of all responses
+ *
+ * \param[in] handle Handle of the channel
+ * \param[in] batch Batch to execute
+ * \return Returns status code of type FT_STATUS(see D2XX Programmer's Guide).
+ *		FT_DEVICE_NOT_FOUND if a slave did not ack its address,
+ *		FT_FAILED_TO_WRITE_DEVICE if a slave did not ack a data byte
+ * \sa
+ * \note Read buffers are filled only if all transfers were acknowledged
+ * \warning
+ */
+FTDIMPSSE_API FT_STATUS I2C_BatchFlush(FT_HANDLE handle, I2C_Batch *batch);
+
+/*!
+ * \brief Gets the transfer counters of a channel
+ *
+ * I2C_InitChannel preallocates a command/response buffer for the channel, so steady-state
+ * transfers make no heap allocations, and the USB buffers are purged only after a failed
+ * transfer. These counters show whether that holds for the application's transfers.
+ *
+ * \param[in] handle Handle of the channel
+ * \param[out] stats Counters since I2C_InitChannel
+ * \return Returns status code of type FT_STATUS(see D2XX Programmer's Guide).
+ *		FT_INVALID_HANDLE if the channel was not initialized with I2C_InitChannel
+ * \sa
+ * \note
+ * \warning
+ */
+FTDIMPSSE_API FT_STATUS I2C_GetTransferStatistics(FT_HANDLE handle,
+	I2C_TransferStatistics *stats);
+
+/*!
+ * \brief Selects the old (0.4) transfer behavior for a channel, to measure what the arena saves
+ *
+ * With legacy set, every command buffer is allocated from the heap and freed again, and
+ * I2C_DeviceWrite purges the USB buffers before every transfer. I2C_GetTransferStatistics
+ * counts the allocations and purges either way.
+ *
+ * \param[in] handle Handle of the channel
+ * \param[in] legacy TRUE: allocate and purge as before; FALSE (default): arena, purge after failure
+ * \return Returns status code of type FT_STATUS(see D2XX Programmer's Guide).
+ *		FT_INVALID_HANDLE if the channel was not initialized with I2C_InitChannel
+ * \sa
+ * \note
+ * \warning
+ */
+FTDIMPSSE_API FT_STATUS I2C_SetLegacyTransfers(FT_HANDLE handle, bool legacy);
+
 /*!
  * \brief Writes to the 8 GPIO lines
  *
@@ -73,6 +73,12 @@ Implement the lock/unlock only if really required, otherwise keep as placeholder
 #define MPSSE_CMD_GET_DATA_BITS_HIGHBYTE	0x83
 
 #define MPSSE_CMD_SEND_IMMEDIATE			0x87
+#define MPSSE_CMD_CLOCK_BITS				0x8E	/* clock 1-8 cycles, no data transfer */
+#define MPSSE_CMD_CLOCK_BYTES				0x8F	/* clock 8*(1-65536) cycles, no data transfer */
+#define MPSSE_CMD_WAIT_ON_IO_HIGH			0x88	/* wait until GPIOL1 (ADBUS5) is high */
+#define MPSSE_CMD_WAIT_ON_IO_LOW			0x89	/* wait until GPIOL1 (ADBUS5) is low */
+#define MPSSE_CMD_CLOCK_BYTES_OR_IO_HIGH	0x9C	/* clock 8*(1-65536) cycles, or until GPIOL1 is high (FT232H) */
+#define MPSSE_CMD_CLOCK_BYTES_OR_IO_LOW		0x9D	/* clock 8*(1-65536) cycles, or until GPIOL1 is low (FT232H) */
 #define MPSSE_CMD_ENABLE_3PHASE_CLOCKING	0x8C
 #define MPSSE_CMD_DISABLE_3PHASE_CLOCKING	0x8D
 #define MPSSE_CMD_ENABLE_DRIVE_ONLY_ZERO	0x9E
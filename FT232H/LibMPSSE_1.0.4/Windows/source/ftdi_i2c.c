@@ -27,6 +27,14 @@
  * 				  Returns FT_DEVICE_NOT_FOUND if addressed slave doesn't respond
  *				  Adjustment to clock rate if 3-phase-clocking is enabled
   * 0.4 - 20200428 - removed unnecessary files and directory structure
+ * 0.5 - 20261017 - Added I2C_Batch functions: complete transfers and delays compiled into
+ *				  one MPSSE command buffer, executed with one USB write and one USB read
+ *				  Added I2C_DeviceWriteRead (repeated-start register read in one round trip)
+ *				  Per-channel command buffer arena allocated by I2C_InitChannel (no heap
+ *				  allocation per transfer); purge only after a failed transfer
+ *				  I2C_SetLegacyTransfers restores the old behavior, for comparison
+ *				  I2C_BatchFlush no longer rejects a batch that exactly fills its buffer
+ *				  Added I2C_BatchQueueWaitGPIOL1 (wait for GPIOL1 within a batch)
 */
 
 /******************************************************************************/
@@ -68,6 +76,20 @@
 #define I2C_ADDRESS_READ_MASK	0x01	/*LSB 1 = Read*/
 #define I2C_ADDRESS_WRITE_MASK	0xFE	/*LSB 0 = Write*/
 
+/* Size of the command buffer preallocated for each channel; larger transfers use the heap */
+#define I2C_ARENA_SIZE			4096
+
+/* This structure associates per-channel state with a handle, stored as a linked list */
+typedef struct I2C_ChannelContext_t
+{
+	FT_HANDLE				handle;
+	uint8					*arena;			/* reusable MPSSE command/response buffer */
+	bool					purgeNeeded;	/* set while a transfer is in progress or after it failed */
+	bool					legacy;			/* I2C_SetLegacyTransfers: heap buffers, purge every write */
+	I2C_TransferStatistics	stats;
+	struct I2C_ChannelContext_t *next;
+} I2C_ChannelContext;
+
 #ifdef I2C_CMD_GETDEVICEID_SUPPORTED
 
 /* This enum lists the supported I2C modes*/
@@ -289,11 +311,91 @@ static FT_STATUS I2C_FastRead(FT_HANDLE handle, UCHAR deviceAddress,
 			DWORD bitsToTransfer, UCHAR *buffer, UCHAR *ack, LPDWORD bytesTransferred,
 			uint32 options);
 
+/*!
+ * \brief Reserves space for MPSSE commands at the end of a batch
+ *
+ * \param[in] batch Batch being built
+ * \param[in] size Number of command bytes required
+ * \return Pointer to the reserved space, or NULL (and batch->status set) if the
+ *		command buffer is full or the batch already failed
+ * \sa
+ * \note
+ * \warning
+ */
+static uint8 *I2C_BatchReserve(I2C_Batch *batch, uint32 size);
+
+/*!
+ * \brief Appends the same START, STOP, byte write and byte read command sequences
+ *		used by I2C_Start, I2C_Stop, I2C_Write8bitsAndGetAck and I2C_Read8bitsAndGiveAck
+ *
+ * Each byte write returns one ACK bit and each byte read returns one data byte; their
+ * offsets in the response are recorded in the batch so I2C_BatchFlush can check and
+ * scatter them.
+ *
+ * \param[in] batch Batch being built
+ * \return Returns status code of type FT_STATUS(see D2XX Programmer's Guide)
+ * \sa
+ * \note
+ * \warning
+ */
+static FT_STATUS I2C_BatchAddStart(I2C_Batch *batch);
+static FT_STATUS I2C_BatchAddStop(I2C_Batch *batch);
+static FT_STATUS I2C_BatchAddWrite8bitsAndGetAck(I2C_Batch *batch, uint8 data,
+			bool isAddress);
+static FT_STATUS I2C_BatchAddRead8bitsAndGiveAck(I2C_Batch *batch, bool ack);
+
+/*!
+ * \brief Creates, finds and deletes the per-channel context (arena, purge state, counters)
+ *
+ * \param[in] handle Handle of the channel
+ * \return Returns status code of type FT_STATUS(see D2XX Programmer's Guide), or the context
+ *		(NULL if the channel has none)
+ * \sa
+ * \note
+ * \warning
+ */
+static FT_STATUS I2C_AddChannelContext(FT_HANDLE handle);
+static I2C_ChannelContext *I2C_FindChannelContext(FT_HANDLE handle);
+static void I2C_DeleteChannelContext(FT_HANDLE handle);
+
+/*!
+ * \brief Gets a command buffer: the channel's arena if large enough, else heap memory
+ *
+ * \param[in] handle Handle of the channel
+ * \param[in] size Number of bytes required
+ * \return Pointer to the buffer, NULL if out of memory. Release with I2C_FreeCmdBuffer.
+ * \sa
+ * \note
+ * \warning
+ */
+static uint8 *I2C_AllocCmdBuffer(FT_HANDLE handle, uint32 size);
+static void I2C_FreeCmdBuffer(FT_HANDLE handle, uint8 *buffer);
+
+/*!
+ * \brief Bracket each transfer: purge stale data only if the previous transfer did not
+ *		complete successfully, and count transfers
+ *
+ * Transfers that return early on error never reach I2C_TransferEnd, so the channel
+ * stays marked for a purge before its next transfer.
+ *
+ * \param[in] handle Handle of the channel
+ * \param[in] legacyPurge The transfer purged unconditionally before 0.5 (I2C_DeviceWrite)
+ * \param[in] status Result of the transfer
+ * \sa
+ * \note
+ * \warning
+ */
+static void I2C_TransferBegin(FT_HANDLE handle, bool legacyPurge);
+static void I2C_TransferEnd(FT_HANDLE handle, FT_STATUS status);
+
 
 /******************************************************************************/
 /*								Global variables							  */
 /******************************************************************************/
 
+/*Root of the linked list that holds per-channel contexts*/
+static I2C_ChannelContext *I2C_ListHead = NULL;
+
 #ifdef I2C_CMD_GETDEVICEID_SUPPORTED
 /*!
  * \brief I2C bus condition timings table
@@ -415,6 +517,9 @@ FTDIMPSSE_API FT_STATUS I2C_InitChannel(FT_HANDLE handle, ChannelConfig *config)
 	/*Save the channel's config data for later use*/
 	status = I2C_SaveChannelConfig(handle, config);
 	CHECK_STATUS(status);
+	/*Preallocate the channel's command buffer*/
+	status = I2C_AddChannelContext(handle);
+	CHECK_STATUS(status);
 	FN_EXIT;
 	return status;
 }
@@ -426,6 +531,7 @@ FTDIMPSSE_API FT_STATUS I2C_CloseChannel(FT_HANDLE handle)
 #ifdef ENABLE_PARAMETER_CHECKING
 		CHECK_NULL_RET(handle);
 #endif // ENABLE_PARAMETER_CHECKING
+	I2C_DeleteChannelContext(handle);
 	status = FT_CloseChannel(I2C, handle);
 	CHECK_STATUS(status);
 	FN_EXIT;
@@ -454,6 +560,7 @@ FTDIMPSSE_API FT_STATUS I2C_DeviceRead(FT_HANDLE handle, UCHAR deviceAddress,
 #endif // ENABLE_PARAMETER_CHECKING
 
 	LOCK_CHANNEL(handle);
+	I2C_TransferBegin(handle, FALSE);
 	if (options & I2C_TRANSFER_OPTIONS_FAST_TRANSFER)
 	{
 		status = I2C_FastRead (handle, deviceAddress, sizeToTransfer, 
@@ -525,6 +632,7 @@ FTDIMPSSE_API FT_STATUS I2C_DeviceRead(FT_HANDLE handle, UCHAR deviceAddress,
 			status = FT_DEVICE_NOT_FOUND;
 		}
 	}
+	I2C_TransferEnd(handle, status);
 	UNLOCK_CHANNEL(handle);
 	FN_EXIT;
 	return status;
@@ -552,7 +660,7 @@ FTDIMPSSE_API FT_STATUS I2C_DeviceWrite(FT_HANDLE handle, UCHAR deviceAddress,
 		(unsigned)sizeToTransfer, (unsigned)options);
 
 	LOCK_CHANNEL(handle);
-	Mid_PurgeDevice(handle);
+	I2C_TransferBegin(handle, TRUE); /* was Mid_PurgeDevice on every write: now only after a failure */
 
 	if (options & I2C_TRANSFER_OPTIONS_FAST_TRANSFER)
 	{
@@ -649,11 +757,54 @@ FTDIMPSSE_API FT_STATUS I2C_DeviceWrite(FT_HANDLE handle, UCHAR deviceAddress,
 			/* old code: status = FT_IO_ERROR; */
 		}
 	}
+	I2C_TransferEnd(handle, status);
 	UNLOCK_CHANNEL(handle);
 	FN_EXIT;
 	return status;
 }
 
+FTDIMPSSE_API FT_STATUS I2C_DeviceWriteRead(FT_HANDLE handle, UCHAR deviceAddress,
+	DWORD sizeToWrite, UCHAR *writeBuffer, DWORD sizeToRead, UCHAR *readBuffer,
+	LPDWORD sizeTransferred)
+{
+	FT_STATUS status = FT_OK;
+	I2C_Batch batch;
+	uint8 *cmdBuffer;
+	uint32 sizeTotal;
+	FN_ENTER;
+#ifdef ENABLE_PARAMETER_CHECKING
+	CHECK_NULL_RET(handle);
+	CHECK_NULL_RET(writeBuffer);
+	CHECK_NULL_RET(readBuffer);
+	CHECK_NULL_RET(sizeTransferred);
+#endif // ENABLE_PARAMETER_CHECKING
+	DBG(MSG_DEBUG,"handle = 0x%x deviceAddress = 0x%x sizeToWrite=%u sizeToRead=%u\n",
+		(unsigned)handle, (unsigned)deviceAddress,
+		(unsigned)sizeToWrite, (unsigned)sizeToRead);
+	*sizeTransferred = 0;
+
+	/* START, address+W, data, SDA release, START, address+R, data read, STOP, SEND_IMMEDIATE */
+	sizeTotal = ((START_DURATION_1+START_DURATION_2+1)*3)*2 + 3
+		+ (sizeToWrite+2)*11 + sizeToRead*14
+		+ (STOP_DURATION_1+STOP_DURATION_2+STOP_DURATION_3+1)*3 + 1;
+	cmdBuffer = I2C_AllocCmdBuffer(handle, sizeTotal);
+	if (NULL == cmdBuffer)
+	{
+		return FT_INSUFFICIENT_RESOURCES;
+	}
+	status = I2C_BatchBegin(&batch, cmdBuffer, sizeTotal, 0);
+	if (FT_OK == status)
+		status = I2C_BatchQueueWriteRead(&batch, deviceAddress, sizeToWrite, writeBuffer,
+			sizeToRead, readBuffer);
+	if (FT_OK == status)
+		status = I2C_BatchFlush(handle, &batch);
+	if (FT_OK == status)
+		*sizeTransferred = sizeToRead;
+	I2C_FreeCmdBuffer(handle, cmdBuffer);
+	FN_EXIT;
+	return status;
+}
+
 FTDIMPSSE_API FT_STATUS I2C_GetDeviceID(FT_HANDLE handle, uint8 deviceAddress,
 	uint8* deviceID)
 {
@@ -706,6 +857,350 @@ FTDIMPSSE_API FT_STATUS I2C_GetDeviceID(FT_HANDLE handle, uint8 deviceAddress,
 	return status;
 }
 
+FTDIMPSSE_API FT_STATUS I2C_BatchBegin(I2C_Batch *batch, UCHAR *cmdBuffer,
+	DWORD cmdBufferSize, DWORD clockRate)
+{
+	FT_STATUS status = FT_OK;
+	FN_ENTER;
+#ifdef ENABLE_PARAMETER_CHECKING
+	CHECK_NULL_RET(batch);
+	CHECK_NULL_RET(cmdBuffer);
+#endif // ENABLE_PARAMETER_CHECKING
+	batch->cmdBuffer = cmdBuffer;
+	batch->cmdBufferSize = cmdBufferSize;
+	batch->cmdLength = 0;
+	batch->responseLength = 0;
+	batch->clockRate = clockRate;
+	batch->status = FT_OK;
+	batch->numReads = 0;
+	batch->numAcks = 0;
+	FN_EXIT;
+	return status;
+}
+
+FTDIMPSSE_API FT_STATUS I2C_BatchQueueWrite(I2C_Batch *batch, UCHAR deviceAddress,
+	DWORD sizeToTransfer, const UCHAR *buffer)
+{
+	FT_STATUS status;
+	uint32 i;
+	FN_ENTER;
+#ifdef ENABLE_PARAMETER_CHECKING
+	CHECK_NULL_RET(batch);
+	CHECK_NULL_RET(buffer);
+	if (deviceAddress > 127)
+	{
+		DBG(MSG_WARN,"deviceAddress(0x%x) is greater than 127\n",
+			(unsigned)deviceAddress);
+		return FT_INVALID_PARAMETER;
+	}
+#endif // ENABLE_PARAMETER_CHECKING
+
+	status = I2C_BatchAddStart(batch);
+	CHECK_STATUS(status);
+	status = I2C_BatchAddWrite8bitsAndGetAck(batch,
+		(uint8)((deviceAddress << 1) & I2C_ADDRESS_WRITE_MASK), TRUE);
+	CHECK_STATUS(status);
+	for (i = 0; i < sizeToTransfer; i++)
+	{
+		status = I2C_BatchAddWrite8bitsAndGetAck(batch, (uint8)buffer[i], FALSE);
+		CHECK_STATUS(status);
+	}
+	status = I2C_BatchAddStop(batch);
+	FN_EXIT;
+	return status;
+}
+
+FTDIMPSSE_API FT_STATUS I2C_BatchQueueWriteRead(I2C_Batch *batch, UCHAR deviceAddress,
+	DWORD sizeToWrite, const UCHAR *writeBuffer, DWORD sizeToRead, UCHAR *readBuffer)
+{
+	FT_STATUS status;
+	uint8 *cmd;
+	uint32 i;
+	DWORD firstReadOffset;
+	FN_ENTER;
+#ifdef ENABLE_PARAMETER_CHECKING
+	CHECK_NULL_RET(batch);
+	CHECK_NULL_RET(writeBuffer);
+	CHECK_NULL_RET(readBuffer);
+	if (deviceAddress > 127)
+	{
+		DBG(MSG_WARN,"deviceAddress(0x%x) is greater than 127\n",
+			(unsigned)deviceAddress);
+		return FT_INVALID_PARAMETER;
+	}
+#endif // ENABLE_PARAMETER_CHECKING
+	if (batch->numReads >= I2C_BATCH_MAX_READS)
+	{
+		DBG(MSG_ERR,"more than %d reads in one batch\n", I2C_BATCH_MAX_READS);
+		batch->status = FT_INSUFFICIENT_RESOURCES;
+	}
+	CHECK_STATUS(batch->status);
+
+	status = I2C_BatchAddStart(batch);
+	CHECK_STATUS(status);
+	status = I2C_BatchAddWrite8bitsAndGetAck(batch,
+		(uint8)((deviceAddress << 1) & I2C_ADDRESS_WRITE_MASK), TRUE);
+	CHECK_STATUS(status);
+	for (i = 0; i < sizeToWrite; i++)
+	{
+		status = I2C_BatchAddWrite8bitsAndGetAck(batch, (uint8)writeBuffer[i], FALSE);
+		CHECK_STATUS(status);
+	}
+
+	/* Repeated start: release SDA while SCL is low, then the usual START sequence */
+	cmd = I2C_BatchReserve(batch, 3);
+	if (NULL == cmd)
+		return batch->status;
+	cmd[0] = MPSSE_CMD_SET_DATA_BITS_LOWBYTE;
+	cmd[1] = VALUE_SCLLOW_SDAHIGH;
+	cmd[2] = DIRECTION_SCLOUT_SDAOUT;
+	status = I2C_BatchAddStart(batch);
+	CHECK_STATUS(status);
+	status = I2C_BatchAddWrite8bitsAndGetAck(batch,
+		(uint8)((deviceAddress << 1) | I2C_ADDRESS_READ_MASK), TRUE);
+	CHECK_STATUS(status);
+
+	firstReadOffset = batch->responseLength;
+	for (i = 0; i < sizeToRead; i++)
+	{/* nAck the last byte so the slave releases SDA for STOP */
+		status = I2C_BatchAddRead8bitsAndGiveAck(batch, (bool)(i+1 < sizeToRead));
+		CHECK_STATUS(status);
+	}
+	status = I2C_BatchAddStop(batch);
+	CHECK_STATUS(status);
+
+	batch->reads[batch->numReads].buffer = readBuffer;
+	batch->reads[batch->numReads].size = sizeToRead;
+	batch->reads[batch->numReads].responseOffset = firstReadOffset;
+	batch->numReads++;
+	FN_EXIT;
+	return status;
+}
+
+FTDIMPSSE_API FT_STATUS I2C_BatchQueueDelay(I2C_Batch *batch, DWORD microseconds)
+{
+	FT_STATUS status = FT_OK;
+	uint8 *cmd;
+	uint64 cycles;
+	uint32 chunk;
+	FN_ENTER;
+#ifdef ENABLE_PARAMETER_CHECKING
+	CHECK_NULL_RET(batch);
+#endif // ENABLE_PARAMETER_CHECKING
+	CHECK_STATUS(batch->status);
+
+	/* Round up: a delay may be longer than requested but never shorter */
+	cycles = ((uint64)microseconds * batch->clockRate + 999999) / 1000000;
+	if (0 == cycles)
+		return FT_OK;
+
+	/* Release SCL and SDA so clocking without data is not seen on the bus */
+	cmd = I2C_BatchReserve(batch, 3);
+	if (NULL == cmd)
+		return batch->status;
+	cmd[0] = MPSSE_CMD_SET_DATA_BITS_LOWBYTE;
+	cmd[1] = VALUE_SCLHIGH_SDAHIGH;
+	cmd[2] = DIRECTION_SCLIN_SDAIN;
+
+	while (cycles >= 8)
+	{/* Clock-bytes command runs 8*(length+1) cycles, length is 16 bits */
+		chunk = (cycles/8 > 65536) ? 65536 : (uint32)(cycles/8);
+		cmd = I2C_BatchReserve(batch, 3);
+		if (NULL == cmd)
+			return batch->status;
+		cmd[0] = MPSSE_CMD_CLOCK_BYTES;
+		cmd[1] = (uint8)((chunk-1) & 0xFF);
+		cmd[2] = (uint8)(((chunk-1) >> 8) & 0xFF);
+		cycles -= (uint64)chunk * 8;
+	}
+	if (cycles > 0)
+	{/* Clock-bits command runs length+1 cycles */
+		cmd = I2C_BatchReserve(batch, 2);
+		if (NULL == cmd)
+			return batch->status;
+		cmd[0] = MPSSE_CMD_CLOCK_BITS;
+		cmd[1] = (uint8)(cycles-1);
+	}
+	FN_EXIT;
+	return status;
+}
+
+FTDIMPSSE_API FT_STATUS I2C_BatchQueueWaitGPIOL1(I2C_Batch *batch, BOOL high,
+	DWORD timeoutMicroseconds, UCHAR *pinsAfter)
+{
+	FT_STATUS status = FT_OK;
+	uint8 *cmd;
+	uint64 cycles;
+	uint32 chunk;
+	FN_ENTER;
+#ifdef ENABLE_PARAMETER_CHECKING
+	CHECK_NULL_RET(batch);
+#endif // ENABLE_PARAMETER_CHECKING
+	if ((NULL != pinsAfter) && (batch->numReads >= I2C_BATCH_MAX_READS))
+	{
+		DBG(MSG_ERR,"more than %d reads in one batch\n", I2C_BATCH_MAX_READS);
+		batch->status = FT_INSUFFICIENT_RESOURCES;
+	}
+	CHECK_STATUS(batch->status);
+
+	/* Release SCL and SDA so clocking without data is not seen on the bus */
+	cmd = I2C_BatchReserve(batch, 3);
+	if (NULL == cmd)
+		return batch->status;
+	cmd[0] = MPSSE_CMD_SET_DATA_BITS_LOWBYTE;
+	cmd[1] = VALUE_SCLHIGH_SDAHIGH;
+	cmd[2] = DIRECTION_SCLIN_SDAIN;
+
+	/* Each command ends early once GPIOL1 is at the level, so later ones then end at once */
+	cycles = ((uint64)timeoutMicroseconds * batch->clockRate + 999999) / 1000000;
+	do
+	{
+		chunk = (cycles/8 > 65536) ? 65536 : (uint32)(cycles/8);
+		if (0 == chunk)
+			chunk = 1;
+		cmd = I2C_BatchReserve(batch, 3);
+		if (NULL == cmd)
+			return batch->status;
+		cmd[0] = high ? MPSSE_CMD_CLOCK_BYTES_OR_IO_HIGH : MPSSE_CMD_CLOCK_BYTES_OR_IO_LOW;
+		cmd[1] = (uint8)((chunk-1) & 0xFF);
+		cmd[2] = (uint8)(((chunk-1) >> 8) & 0xFF);
+		cycles = (cycles > (uint64)chunk * 8) ? cycles - (uint64)chunk * 8 : 0;
+	} while (cycles > 0);
+
+	if (NULL != pinsAfter)
+	{
+		cmd = I2C_BatchReserve(batch, 1);
+		if (NULL == cmd)
+			return batch->status;
+		cmd[0] = MPSSE_CMD_GET_DATA_BITS_LOWBYTE;
+		batch->reads[batch->numReads].buffer = pinsAfter;
+		batch->reads[batch->numReads].size = 1;
+		batch->reads[batch->numReads].responseOffset = batch->responseLength;
+		batch->numReads++;
+		batch->responseLength++;
+	}
+	FN_EXIT;
+	return status;
+}
+
+FTDIMPSSE_API FT_STATUS I2C_BatchFlush(FT_HANDLE handle, I2C_Batch *batch)
+{
+	FT_STATUS status;
+	DWORD noOfBytesTransferred = 0;
+	uint32 i;
+	FN_ENTER;
+#ifdef ENABLE_PARAMETER_CHECKING
+	CHECK_NULL_RET(handle);
+	CHECK_NULL_RET(batch);
+#endif // ENABLE_PARAMETER_CHECKING
+	CHECK_STATUS(batch->status);
+	if (0 == batch->cmdLength)
+		return FT_OK;
+
+	/* I2C_BatchReserve always leaves room for this byte */
+	batch->cmdBuffer[batch->cmdLength++] = MPSSE_CMD_SEND_IMMEDIATE;
+
+	LOCK_CHANNEL(handle);
+	I2C_TransferBegin(handle, FALSE);
+	status = FT_Channel_Write(I2C, handle, batch->cmdLength, batch->cmdBuffer,
+		&noOfBytesTransferred);
+	if ((FT_OK == status) && (noOfBytesTransferred != batch->cmdLength))
+	{
+		DBG(MSG_ERR, "Requested to send %u bytes, no. of bytes sent is %u bytes",
+			(unsigned)batch->cmdLength, (unsigned)noOfBytesTransferred);
+		status = FT_IO_ERROR;
+	}
+	if ((FT_OK == status) && (batch->responseLength > 0))
+	{/* commands have been sent, reuse the command buffer for the response */
+		noOfBytesTransferred = 0;
+		status = FT_Channel_Read(I2C, handle, batch->responseLength, batch->cmdBuffer,
+			&noOfBytesTransferred);
+		if ((FT_OK == status) && (noOfBytesTransferred != batch->responseLength))
+		{
+			DBG(MSG_ERR, "Requested to read %u bytes, no. of bytes read is %u bytes",
+				(unsigned)batch->responseLength, (unsigned)noOfBytesTransferred);
+			status = FT_IO_ERROR;
+		}
+	}
+	for (i = 0; (FT_OK == status) && (i < batch->numAcks); i++)
+	{
+		if (batch->cmdBuffer[batch->acks[i].responseOffset] & 0x01)
+		{/* nAck */
+			DBG(MSG_ERR, "I2C_BatchFlush: nAck for byte %u\n", (unsigned)i);
+			status = batch->acks[i].isAddress ?
+				FT_DEVICE_NOT_FOUND : FT_FAILED_TO_WRITE_DEVICE;
+		}
+	}
+	if (FT_OK == status)
+	{
+		for (i = 0; i < batch->numReads; i++)
+		{
+			memcpy(batch->reads[i].buffer,
+				&batch->cmdBuffer[batch->reads[i].responseOffset], batch->reads[i].size);
+		}
+	}
+	else
+	{
+		Infra_DbgPrintStatus(status);
+	}
+	I2C_TransferEnd(handle, status);
+	UNLOCK_CHANNEL(handle);
+
+	/* Ready for the next sequence */
+	batch->cmdLength = 0;
+	batch->responseLength = 0;
+	batch->numReads = 0;
+	batch->numAcks = 0;
+	FN_EXIT;
+	return status;
+}
+
+FTDIMPSSE_API FT_STATUS I2C_GetTransferStatistics(FT_HANDLE handle,
+	I2C_TransferStatistics *stats)
+{
+	FT_STATUS status = FT_OK;
+	I2C_ChannelContext *context;
+	FN_ENTER;
+#ifdef ENABLE_PARAMETER_CHECKING
+	CHECK_NULL_RET(handle);
+	CHECK_NULL_RET(stats);
+#endif // ENABLE_PARAMETER_CHECKING
+	context = I2C_FindChannelContext(handle);
+	if (NULL == context)
+	{
+		DBG(MSG_ERR,"handle 0x%x was not initialized by I2C_InitChannel\n", (unsigned)handle);
+		status = FT_INVALID_HANDLE;
+	}
+	else
+	{
+		*stats = context->stats;
+	}
+	FN_EXIT;
+	return status;
+}
+
+FTDIMPSSE_API FT_STATUS I2C_SetLegacyTransfers(FT_HANDLE handle, bool legacy)
+{
+	FT_STATUS status = FT_OK;
+	I2C_ChannelContext *context;
+	FN_ENTER;
+#ifdef ENABLE_PARAMETER_CHECKING
+	CHECK_NULL_RET(handle);
+#endif // ENABLE_PARAMETER_CHECKING
+	context = I2C_FindChannelContext(handle);
+	if (NULL == context)
+	{
+		DBG(MSG_ERR,"handle 0x%x was not initialized by I2C_InitChannel\n", (unsigned)handle);
+		status = FT_INVALID_HANDLE;
+	}
+	else
+	{
+		context->legacy = legacy;
+	}
+	FN_EXIT;
+	return status;
+}
+
 /******************************************************************************/
 /*						Local function definitions						  */
 /******************************************************************************/
@@ -1056,8 +1551,8 @@ static FT_STATUS I2C_FastWrite(FT_HANDLE handle, UCHAR deviceAddress,
 	sizeOverhead = sizeTotal - bytesToTransfer;
 	(void)sizeOverhead; /* NB Not used */
 	
-	/* Allocate buffers */
-	outBuffer = (uint8*) INFRA_MALLOC(sizeTotal);
+	/* Get command buffer (preallocated unless the transfer is very large) */
+	outBuffer = I2C_AllocCmdBuffer(handle, sizeTotal);
 	if (NULL == outBuffer)
 	{
 		return FT_INSUFFICIENT_RESOURCES;
@@ -1203,21 +1698,17 @@ static FT_STATUS I2C_FastWrite(FT_HANDLE handle, UCHAR deviceAddress,
 	/* if byte mode: read 1bit ack after each 8bits written */
 	if (options & I2C_TRANSFER_OPTIONS_FAST_TRANSFER_BYTES)
 	{
-		inBuffer = INFRA_MALLOC(bytesToTransfer);
-		if (NULL != inBuffer)
-		{
-			status = FT_Channel_Read(I2C, handle, sizeToTransfer, inBuffer, 
-				&bytesRead);
-			CHECK_STATUS(status);
-			if (ack)
-			{/* Copy the ack bits into the ack buffer if provided */
-				INFRA_MEMCPY(ack, inBuffer, bytesRead);
-			}
-			INFRA_FREE(inBuffer);
+		inBuffer = outBuffer; /* commands already sent; reuse for the ack bits */
+		status = FT_Channel_Read(I2C, handle, sizeToTransfer, inBuffer,
+			&bytesRead);
+		CHECK_STATUS(status);
+		if (ack)
+		{/* Copy the ack bits into the ack buffer if provided */
+			INFRA_MEMCPY(ack, inBuffer, bytesRead);
 		}
 	}
 #endif
-	INFRA_FREE(outBuffer);
+	I2C_FreeCmdBuffer(handle, outBuffer);
 	FN_EXIT;
 	return status;
 }
@@ -1261,8 +1752,8 @@ static FT_STATUS I2C_FastRead(FT_HANDLE handle, UCHAR deviceAddress,
 	sizeOverhead = sizeTotal - bytesToTransfer;
 	(void)sizeOverhead; /* NB Not used */
 	
-	/* Allocate buffers */
-	outBuffer = (uint8*) INFRA_MALLOC(sizeTotal);
+	/* Get command buffer (preallocated unless the transfer is very large) */
+	outBuffer = I2C_AllocCmdBuffer(handle, sizeTotal);
 	if (NULL == outBuffer)
 	{
 		return FT_INSUFFICIENT_RESOURCES;
@@ -1404,7 +1895,7 @@ static FT_STATUS I2C_FastRead(FT_HANDLE handle, UCHAR deviceAddress,
 		status = FT_Channel_Read(I2C, handle, bytesToTransfer+1, buffer, &bytesRead);
 	CHECK_STATUS(status);
 
-	INFRA_FREE(outBuffer);
+	I2C_FreeCmdBuffer(handle, outBuffer);
 	
 	FN_EXIT;
 	return status;
@@ -1546,3 +2037,259 @@ static FT_STATUS I2C_Stop(FT_HANDLE handle)
 }
 
 
+
+static uint8 *I2C_BatchReserve(I2C_Batch *batch, uint32 size)
+{
+	uint8 *cmd;
+	if (FT_OK != batch->status)
+		return NULL;
+	/* keep one byte for the SEND_IMMEDIATE added by I2C_BatchFlush */
+	if (batch->cmdLength + size + 1 > batch->cmdBufferSize)
+	{
+		DBG(MSG_ERR, "I2C_Batch command buffer (%u bytes) is full\n",
+			(unsigned)batch->cmdBufferSize);
+		batch->status = FT_INSUFFICIENT_RESOURCES;
+		return NULL;
+	}
+	cmd = &batch->cmdBuffer[batch->cmdLength];
+	batch->cmdLength += size;
+	return cmd;
+}
+
+static FT_STATUS I2C_BatchAddStart(I2C_Batch *batch)
+{
+	uint8 *cmd = I2C_BatchReserve(batch, (START_DURATION_1+START_DURATION_2+1)*3);
+	uint32 i = 0, j = 0;
+	if (NULL == cmd)
+		return batch->status;
+
+	/* SCL high, SDA high */
+	for (j = 0; j < START_DURATION_1; j++)
+	{
+		cmd[i++] = MPSSE_CMD_SET_DATA_BITS_LOWBYTE;
+		cmd[i++] = VALUE_SCLHIGH_SDAHIGH;
+		cmd[i++] = DIRECTION_SCLOUT_SDAOUT;
+	}
+	/* SCL high, SDA low */
+	for (j = 0; j < START_DURATION_2; j++)
+	{
+		cmd[i++] = MPSSE_CMD_SET_DATA_BITS_LOWBYTE;
+		cmd[i++] = VALUE_SCLHIGH_SDALOW;
+		cmd[i++] = DIRECTION_SCLOUT_SDAOUT;
+	}
+	/*SCL low, SDA low */
+	cmd[i++] = MPSSE_CMD_SET_DATA_BITS_LOWBYTE;
+	cmd[i++] = VALUE_SCLLOW_SDALOW;
+	cmd[i++] = DIRECTION_SCLOUT_SDAOUT;
+	return FT_OK;
+}
+
+static FT_STATUS I2C_BatchAddStop(I2C_Batch *batch)
+{
+	uint8 *cmd = I2C_BatchReserve(batch,
+		(STOP_DURATION_1+STOP_DURATION_2+STOP_DURATION_3+1)*3);
+	uint32 i = 0, j = 0;
+	if (NULL == cmd)
+		return batch->status;
+
+	/* SCL low, SDA low */
+	for (j = 0; j < STOP_DURATION_1; j++)
+	{
+		cmd[i++] = MPSSE_CMD_SET_DATA_BITS_LOWBYTE;
+		cmd[i++] = VALUE_SCLLOW_SDALOW;
+		cmd[i++] = DIRECTION_SCLOUT_SDAOUT;
+	}
+	/* SCL high, SDA low */
+	for (j = 0; j < STOP_DURATION_2; j++)
+	{
+		cmd[i++] = MPSSE_CMD_SET_DATA_BITS_LOWBYTE;
+		cmd[i++] = VALUE_SCLHIGH_SDALOW;
+		cmd[i++] = DIRECTION_SCLOUT_SDAOUT;
+	}
+	/* SCL high, SDA high */
+	for (j = 0; j < STOP_DURATION_3; j++)
+	{
+		cmd[i++] = MPSSE_CMD_SET_DATA_BITS_LOWBYTE;
+		cmd[i++] = VALUE_SCLHIGH_SDAHIGH;
+		cmd[i++] = DIRECTION_SCLOUT_SDAOUT;
+	}
+	cmd[i++] = MPSSE_CMD_SET_DATA_BITS_LOWBYTE;
+	cmd[i++] = VALUE_SCLHIGH_SDAHIGH;
+	cmd[i++] = DIRECTION_SCLIN_SDAIN; /* Tristate the SCL & SDA pins */
+	return FT_OK;
+}
+
+static FT_STATUS I2C_BatchAddWrite8bitsAndGetAck(I2C_Batch *batch, uint8 data,
+	bool isAddress)
+{
+	uint8 *cmd;
+	uint32 i = 0;
+	if (batch->numAcks >= I2C_BATCH_MAX_ACKS)
+	{
+		DBG(MSG_ERR,"more than %d bytes written in one batch\n", I2C_BATCH_MAX_ACKS);
+		batch->status = FT_INSUFFICIENT_RESOURCES;
+	}
+	cmd = I2C_BatchReserve(batch, 11);
+	if (NULL == cmd)
+		return batch->status;
+
+	/*set direction*/
+	cmd[i++] = MPSSE_CMD_SET_DATA_BITS_LOWBYTE;/* MPSSE command */
+	cmd[i++] = VALUE_SCLLOW_SDAHIGH; /*Value*/
+	cmd[i++] = DIRECTION_SCLOUT_SDAOUT; /*Direction*/
+
+	/* Command to write 8bits */
+	cmd[i++] = MPSSE_CMD_DATA_OUT_BITS_NEG_EDGE;/* MPSSE command */
+	cmd[i++] = DATA_SIZE_8BITS;
+	cmd[i++] = data;
+
+	/* Set SDA to input mode before reading ACK bit */
+	cmd[i++] = MPSSE_CMD_SET_DATA_BITS_LOWBYTE;/* MPSSE command */
+	cmd[i++] = VALUE_SCLLOW_SDALOW; /*Value*/
+	cmd[i++] = DIRECTION_SCLOUT_SDAIN; /*Direction*/
+
+	/* Command to get ACK bit */
+	cmd[i++] = MPSSE_CMD_DATA_IN_BITS_POS_EDGE;/* MPSSE command */
+	cmd[i++] = DATA_SIZE_1BIT; /*Read only one bit */
+
+	batch->acks[batch->numAcks].responseOffset = batch->responseLength++;
+	batch->acks[batch->numAcks].isAddress = (UCHAR)isAddress;
+	batch->numAcks++;
+	return FT_OK;
+}
+
+static FT_STATUS I2C_BatchAddRead8bitsAndGiveAck(I2C_Batch *batch, bool ack)
+{
+	uint8 *cmd = I2C_BatchReserve(batch, 14);
+	uint32 i = 0;
+	if (NULL == cmd)
+		return batch->status;
+
+	/*set direction*/
+	cmd[i++] = MPSSE_CMD_SET_DATA_BITS_LOWBYTE;/* MPSSE command */
+	cmd[i++] = VALUE_SCLLOW_SDALOW; /*Value*/
+	cmd[i++] = DIRECTION_SCLOUT_SDAIN; /*Direction*/
+
+	/*Command to read 8 bits*/
+	cmd[i++] = MPSSE_CMD_DATA_IN_BITS_POS_EDGE;
+	cmd[i++] = DATA_SIZE_8BITS;/*0x00 = 1bit; 0x07 = 8bits*/
+
+	/* Drive the ACK bit low, or release SDA so the nACK bit floats high */
+	cmd[i++] = MPSSE_CMD_SET_DATA_BITS_LOWBYTE;
+	cmd[i++] = VALUE_SCLLOW_SDALOW;
+	cmd[i++] = ack ? DIRECTION_SCLOUT_SDAOUT : DIRECTION_SCLOUT_SDAIN;
+	cmd[i++] = MPSSE_CMD_DATA_OUT_BITS_NEG_EDGE;
+	cmd[i++] = DATA_SIZE_1BIT;
+	cmd[i++] = ack ? SEND_ACK : SEND_NACK;
+
+	/* Back to Idle */
+	cmd[i++] = MPSSE_CMD_SET_DATA_BITS_LOWBYTE;
+	cmd[i++] = VALUE_SCLLOW_SDALOW;
+	cmd[i++] = DIRECTION_SCLOUT_SDAIN;
+
+	batch->responseLength++;
+	return FT_OK;
+}
+
+static FT_STATUS I2C_AddChannelContext(FT_HANDLE handle)
+{
+	I2C_ChannelContext *context = I2C_FindChannelContext(handle);
+	if (NULL == context)
+	{
+		context = (I2C_ChannelContext *) INFRA_MALLOC(sizeof(I2C_ChannelContext));
+		if (NULL == context)
+			return FT_INSUFFICIENT_RESOURCES;
+		context->arena = (uint8 *) INFRA_MALLOC(I2C_ARENA_SIZE);
+		if (NULL == context->arena)
+		{
+			INFRA_FREE(context);
+			return FT_INSUFFICIENT_RESOURCES;
+		}
+		context->handle = handle;
+		context->next = I2C_ListHead;
+		I2C_ListHead = context;
+	}
+	/* Re-initializing a channel restarts its counters; FT_InitChannel just purged */
+	context->purgeNeeded = FALSE;
+	context->legacy = FALSE;
+	memset(&context->stats, 0, sizeof(context->stats));
+	return FT_OK;
+}
+
+static I2C_ChannelContext *I2C_FindChannelContext(FT_HANDLE handle)
+{
+	I2C_ChannelContext *context;
+	for (context = I2C_ListHead; NULL != context; context = context->next)
+	{
+		if (context->handle == handle)
+			return context;
+	}
+	return NULL;
+}
+
+static void I2C_DeleteChannelContext(FT_HANDLE handle)
+{
+	I2C_ChannelContext **link;
+	I2C_ChannelContext *context;
+	for (link = &I2C_ListHead; NULL != *link; link = &(*link)->next)
+	{
+		if ((*link)->handle == handle)
+		{
+			context = *link;
+			*link = context->next;
+			INFRA_FREE(context->arena);
+			INFRA_FREE(context);
+			return;
+		}
+	}
+}
+
+static uint8 *I2C_AllocCmdBuffer(FT_HANDLE handle, uint32 size)
+{
+	I2C_ChannelContext *context = I2C_FindChannelContext(handle);
+	if ((NULL != context) && (!context->legacy) && (size <= I2C_ARENA_SIZE))
+	{
+		context->stats.arenaUses++;
+		return context->arena;
+	}
+	if (NULL != context)
+		context->stats.heapAllocations++;
+	return (uint8 *) INFRA_MALLOC(size);
+}
+
+static void I2C_FreeCmdBuffer(FT_HANDLE handle, uint8 *buffer)
+{
+	I2C_ChannelContext *context = I2C_FindChannelContext(handle);
+	if ((NULL == context) || (buffer != context->arena))
+	{
+		INFRA_FREE(buffer);
+	}
+}
+
+static void I2C_TransferBegin(FT_HANDLE handle, bool legacyPurge)
+{
+	I2C_ChannelContext *context = I2C_FindChannelContext(handle);
+	if (NULL == context)
+	{/* channel not initialized by I2C_InitChannel: original behavior */
+		Mid_PurgeDevice(handle);
+		return;
+	}
+	context->stats.transfers++;
+	if (context->purgeNeeded || (context->legacy && legacyPurge))
+	{/* previous transfer failed part-way (or legacy): discard leftover commands and responses */
+		Mid_PurgeDevice(handle);
+		context->stats.purges++;
+	}
+	context->purgeNeeded = TRUE;
+}
+
+static void I2C_TransferEnd(FT_HANDLE handle, FT_STATUS status)
+{
+	I2C_ChannelContext *context = I2C_FindChannelContext(handle);
+	if (NULL == context)
+		return;
+	if (FT_OK == status)
+		context->purgeNeeded = FALSE;
+	else
+		context->stats.failures++;
+}
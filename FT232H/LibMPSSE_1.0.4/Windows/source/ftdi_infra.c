@@ -235,6 +235,7 @@ FTDIMPSSE_API void Init_libMPSSE(void)
 	if (!hdll_d2xx) 
 	{ 
 		fprintf(stderr, "dlopen failed: %s\n", dlerror()); 
+		return; // DRN: runs from the library constructor; leave varFunctionPtrLst to the application (emulated FT232H) instead of exit
 	}
 #else // _WIN32
 	hdll_d2xx = LoadLibrary(L"ftd2xx.dll"); // DRN: L"xx" forces Unicode so we don't need to use LoadLibraryA
@@ -328,7 +329,8 @@ FTDIMPSSE_API void Cleanup_libMPSSE(void)
 
 #else // _WIN32
 
-    dlclose(hdll_d2xx);
+	if (NULL != hdll_d2xx) // DRN: not loaded when an emulated FT232H supplied varFunctionPtrLst
+		dlclose(hdll_d2xx);
 
 #endif // _WIN32
 
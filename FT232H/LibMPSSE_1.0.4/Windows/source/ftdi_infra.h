@@ -190,7 +190,7 @@ typedef signed long long int64;
 
 #ifndef __cplusplus   // DRN: bool is defined already in C++
   typedef BOOL	bool; // DRN: bool is defined already in C++
-  static_assert(sizeof(BOOL) == sizeof(bool));
+  _Static_assert(sizeof(BOOL) == sizeof(bool), "BOOL must match bool"); // DRN: C11 keyword, static_assert needs <assert.h>
 #endif                // DRN: bool is defined already in C++
 
 typedef unsigned int   uint32;
@@ -0,0 +1,596 @@
+// FT232H_Emulator.hpp - software FT232H (MPSSE command-stream emulator) behind libMPSSE's D2XX function table
+
+/*
+MIT License
+
+Copyright (c) 2023-2025 Dave Nadler
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef FT232H_Emulator_HPP_INCLUDED
+#define FT232H_Emulator_HPP_INCLUDED
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <deque>
+#include <vector>
+
+#include "MMC5983MA_IO_Simulator.hpp"
+extern "C" { // antique FTDI headers lack this
+    #include "ftdi_infra.h"  // varFunctionPtrLst and the D2XX function pointer types
+    #include "ftdi_common.h" // MPSSE opcodes
+    #include "ftd2xx.h"
+}
+
+/// Software FT232H standing in for the D2XX driver: libMPSSE reaches hardware only through
+/// varFunctionPtrLst, so Install() points that table here and the unmodified libMPSSE I2C/SPI code runs
+/// without an adapter. The MPSSE command stream is decoded into pin changes and clocked bits, which drive
+/// an I2C or SPI slave in front of the MMC5983MA_IO_Simulator_C register model. <BR>
+/// Pins: ADBUS0 SCL/SCK, ADBUS1 SDA out/MOSI, ADBUS2 SDA in/MISO (ADBUS1 and 2 wired together for I2C),
+/// ADBUS3 SPI chip select (active low), ADBUS5 (GPIOL1) the sensor's INT output. <BR>
+/// Time is virtual and shared with the sensor model. USB costs follow the FTDI behavior that matters for batching:
+/// each transfer waits for the next high-speed microframe and pays per byte, and read data not pushed with
+/// SEND_IMMEDIATE sits in the chip until the latency timer expires. The statistics therefore show
+/// USB round-trips, bytes, and wire time per sample for any libMPSSE change. <BR>
+/// Not modeled: SCL edges made with SET_DATA_BITS are not data clocks (libMPSSE only uses them for START/STOP),
+/// SPI clock polarity/phase, JTAG/TMS commands. Not thread-safe; use one emulated device per thread.
+class FT232H_Emulator_C {
+public:
+    typedef enum { I2C, SPI } Bus_T;
+    FT232H_Emulator_C(Bus_T bus_ = I2C) :
+        sensor(bus_==SPI ? MMC5983MA_IO_base_C::SPI : MMC5983MA_IO_base_C::I2C), bus(bus_) {};
+    ~FT232H_Emulator_C() { Uninstall(); };
+
+    static const int MaxDevices = 8; ///< devices the emulated USB bus holds
+    /// Add this device to the emulated USB bus and point varFunctionPtrLst at the emulator
+    /// (use instead of Init_libMPSSE, which loads the real D2XX library).
+    void Install() {
+        if(DeviceIndex() < 0) {
+            assert(deviceCount < MaxDevices);
+            devices[deviceCount++] = this;
+        }
+        varFunctionPtrLst.p_FT_GetLibraryVersion = Emu_GetLibraryVersion;
+        varFunctionPtrLst.p_FT_GetNumChannel     = Emu_CreateDeviceInfoList;
+        varFunctionPtrLst.p_FT_GetDeviceInfoList = Emu_GetDeviceInfoList;
+        varFunctionPtrLst.p_FT_Open              = Emu_Open;
+        varFunctionPtrLst.p_FT_Close             = Emu_Close;
+        varFunctionPtrLst.p_FT_ResetDevice       = Emu_ResetDevice;
+        varFunctionPtrLst.p_FT_Purge             = Emu_Purge;
+        varFunctionPtrLst.p_FT_SetUSBParameters  = Emu_SetUSBParameters;
+        varFunctionPtrLst.p_FT_SetChars          = Emu_SetChars;
+        varFunctionPtrLst.p_FT_SetTimeouts       = Emu_SetTimeouts;
+        varFunctionPtrLst.p_FT_SetLatencyTimer   = Emu_SetLatencyTimer;
+        varFunctionPtrLst.p_FT_GetLatencyTimer   = Emu_GetLatencyTimer;
+        varFunctionPtrLst.p_FT_SetBitmode        = Emu_SetBitmode;
+        varFunctionPtrLst.p_FT_GetQueueStatus    = Emu_GetQueueStatus;
+        varFunctionPtrLst.p_FT_Read              = Emu_Read;
+        varFunctionPtrLst.p_FT_Write             = Emu_Write;
+        varFunctionPtrLst.p_FT_GetDeviceInfo     = Emu_GetDeviceInfo;
+    };
+    /// Unplug this device from the emulated USB bus (later devices move down one index)
+    void Uninstall() {
+        int idx = DeviceIndex();
+        if(idx < 0) return;
+        for(int i=idx; i<deviceCount-1; i++) devices[i] = devices[i+1];
+        devices[--deviceCount] = nullptr;
+    };
+
+    // ==========  Emulated hardware  ==========
+    MMC5983MA_IO_Simulator_C sensor; ///< Register model behind the bus; set field_mG etc. here
+    uint8_t i2cAddress = 0x30;       ///< 7-bit I2C address the sensor answers
+    uint8_t spiChipSelectMask = 0x08; ///< ADBUS pin used as SPI CS (libMPSSE SPI_CONFIG_OPTION_CS_DBUS3)
+    uint8_t gpioHighInputs = 0xFF;   ///< Levels seen on ACBUS pins configured as inputs
+    uint8_t intPinMask = 0x20;       ///< ADBUS pin wired to the sensor's INT output (0x20 = GPIOL1; 0 = not wired, pulled up)
+
+    /// Virtual time, shared with the sensor model
+    void Delay_us(uint32_t uSecs) { sensor.delay_us(uSecs); };
+    uint64_t Now_us() { return sensor.time_us(); };
+
+    // ==========  Cost model (high-speed USB FT232H defaults)  ==========
+    uint32_t usbMicroframe_ns = 125000; ///< a USB transfer (or FT_Purge control request) starts at the next 125us microframe
+    uint32_t usbByte_ns = 20;           ///< bulk payload transfer cost per byte (~50MB/s)
+    uint32_t mpsseCommand_ns = 67;      ///< MPSSE engine time for a command that does not clock the bus
+    uint8_t latencyTimer_ms = 16;       ///< D2XX default; libMPSSE sets ChannelConfig.LatencyTimer via FT_SetLatencyTimer
+    uint32_t readTimeout_ms = 5000;     ///< FT_Read waits this long for missing bytes (FT_SetTimeouts)
+
+    struct Statistics_T {
+        uint32_t usbWrites;          ///< FT_Write calls (USB OUT transfers)
+        uint32_t usbReads;           ///< FT_Read calls (USB IN transfers, each one a round-trip)
+        uint32_t queueStatusPolls;   ///< FT_GetQueueStatus calls
+        uint32_t purges;             ///< FT_Purge calls
+        uint64_t bytesToDevice;      ///< payload written (MPSSE commands)
+        uint64_t bytesFromDevice;    ///< payload read (responses)
+        uint32_t packetsToDevice;    ///< 512-byte bulk OUT packets
+        uint32_t packetsFromDevice;  ///< 512-byte bulk IN packets (each has 2 modem status bytes)
+        uint32_t latencyTimerWaits;  ///< responses delivered by latency timer expiry instead of SEND_IMMEDIATE
+        uint32_t readTimeouts;       ///< FT_Read asked for more bytes than the commands produced
+        uint32_t badCommands;        ///< 0xFA replies (includes libMPSSE's deliberate sync echoes)
+        uint32_t gpioWaits;          ///< wait-for-GPIOL1 commands (0x88/0x89/0x9C/0x9D)
+        uint32_t gpioWaitTimeouts;   ///< ...that ended without GPIOL1 reaching the level
+        uint32_t i2cStarts, i2cStops, i2cBytes, i2cNacks;
+        uint32_t spiFrames, spiBytes;
+        uint64_t usbTime_ns;         ///< microframe waits and payload transfer time
+        uint64_t latencyWait_ns;     ///< time spent waiting for latency timer expiry
+        uint64_t busTime_ns;         ///< MPSSE command execution and bus clocking
+    };
+    Statistics_T stats = {};
+    void ResetStatistics() { stats = {}; };
+    /// Totals, and per sample if samples>0 (e.g. the number of Make_A_Measurement calls)
+    void PrintStatistics(FILE *f, uint32_t samples = 0) const {
+        const Statistics_T &s = stats;
+        fprintf(f, "USB: %u writes, %u reads, %u queue polls, %u purges; %llu bytes out (%u packets), %llu bytes in (%u packets)\n",
+            s.usbWrites, s.usbReads, s.queueStatusPolls, s.purges,
+            (unsigned long long)s.bytesToDevice, s.packetsToDevice, (unsigned long long)s.bytesFromDevice, s.packetsFromDevice);
+        fprintf(f, "     %u latency timer waits, %u read timeouts, %u bad commands, %u GPIOL1 waits (%u timed out)\n",
+            s.latencyTimerWaits, s.readTimeouts, s.badCommands, s.gpioWaits, s.gpioWaitTimeouts);
+        if(bus == I2C) fprintf(f, "I2C: %u starts, %u stops, %u bytes, %u NACKs\n", s.i2cStarts, s.i2cStops, s.i2cBytes, s.i2cNacks);
+        else           fprintf(f, "SPI: %u frames, %u bytes\n", s.spiFrames, s.spiBytes);
+        fprintf(f, "Time: USB %.3f ms, latency timer %.3f ms, MPSSE/bus %.3f ms\n",
+            s.usbTime_ns/1e6, s.latencyWait_ns/1e6, s.busTime_ns/1e6);
+        if(samples == 0) return;
+        fprintf(f, "Per sample: %.2f round-trips, %.1f bytes out, %.1f bytes in, %.3f ms USB+latency, %.3f ms bus\n",
+            (double)s.usbReads/samples, (double)s.bytesToDevice/samples, (double)s.bytesFromDevice/samples,
+            (s.usbTime_ns+s.latencyWait_ns)/1e6/samples, s.busTime_ns/1e6/samples);
+    };
+
+protected:
+    Bus_T bus;
+    // USB and MPSSE engine state
+    bool opened = false;
+    bool mpsseMode = false;
+    std::vector<uint8_t> pendingCommands; ///< bytes of an MPSSE command split across FT_Write calls
+    std::deque<uint8_t> rx;               ///< responses not yet read by the host
+    bool rxPushed = false;                ///< SEND_IMMEDIATE (or an error reply) since rx was last drained
+    bool rxAtHost = false;                ///< transfer cost for current rx content already paid
+    double pending_ns = 0;                ///< virtual time not yet moved into the sensor model
+    uint16_t clockDivisor = 0;
+    bool divideBy5 = true;                ///< power-on state: 12MHz base clock
+    bool threePhase = false;
+    bool loopback = false;
+    uint8_t lowValue = 0, lowDir = 0, highValue = 0, highDir = 0;
+    // I2C slave
+    enum { I2C_Idle, I2C_Address, I2C_AddressAck, I2C_WriteData, I2C_WriteAck, I2C_ReadData, I2C_ReadAck } i2cState = I2C_Idle;
+    uint8_t i2cShift = 0, i2cBits = 0, i2cTx = 0, i2cRegister = 0;
+    bool i2cAck = false, i2cReading = false, i2cFirstWriteByte = false;
+    // SPI slave
+    bool spiSelected = false, spiRead = false;
+    uint8_t spiShift = 0, spiTx = 0, spiBits = 0, spiRegister = 0;
+    uint32_t spiByteIdx = 0;
+
+    void Spend_ns(double ns, uint64_t &bucket) {
+        bucket += (uint64_t)ns;
+        pending_ns += ns;
+        if(pending_ns >= 1000) {
+            uint32_t us = (uint32_t)(pending_ns / 1000);
+            sensor.delay_us(us);
+            pending_ns -= us*1000.0;
+        }
+    }
+    double BitPeriod_ns() const {
+        double hz = (divideBy5 ? 12e6 : 60e6) / ((1.0+clockDivisor)*2);
+        return (threePhase ? 1.5e9 : 1e9) / hz;
+    }
+    static uint32_t Packets(size_t bytes, size_t payloadPerPacket) { return (uint32_t)((bytes + payloadPerPacket-1) / payloadPerPacket); };
+    void Respond(uint8_t b) { rx.push_back(b); rxAtHost = false; };
+    /// Pay for getting the current responses to the host: next microframe if pushed, else latency timer expiry
+    void DeliverResponses() {
+        if(rxAtHost || rx.empty()) return;
+        if(rxPushed) {
+            Spend_ns(usbMicroframe_ns, stats.usbTime_ns);
+        } else {
+            stats.latencyTimerWaits++;
+            Spend_ns(latencyTimer_ms*1e6, stats.latencyWait_ns);
+        }
+        rxAtHost = true;
+    }
+
+    // ==========  Pins and bus lines  ==========
+    bool SclLine() const { return !(lowDir & 0x01) || (lowValue & 0x01); }; // open drain with pull-up
+    bool SdaMaster() const { return !(lowDir & 0x02) || (lowValue & 0x02); };
+    bool SdaLine() const { return SdaMaster() && I2cSlaveSda(); };
+    uint8_t GetPins(bool highByte) {
+        if(highByte) return (highValue & highDir) | (gpioHighInputs & ~highDir);
+        uint8_t levels = 0xF8 | (SclLine() ? 0x01 : 0);
+        if(intPinMask && !sensor.InterruptPin()) levels &= ~intPinMask;
+        if(bus == I2C) levels |= SdaLine() ? 0x06 : 0;
+        else           levels |= (SdaMaster() ? 0x02 : 0) | ((spiTx & (0x80>>spiBits)) ? 0x04 : 0);
+        return (lowValue & lowDir) | (levels & ~lowDir);
+    }
+    void SetPins(bool highByte, uint8_t value, uint8_t direction) {
+        if(highByte) { highValue = value; highDir = direction; return; }
+        bool sclWas = SclLine(), sdaWas = SdaLine();
+        lowValue = value; lowDir = direction;
+        if(bus == I2C) {
+            if(sclWas && SclLine() && sdaWas != SdaLine()) { // SDA changes while SCL high
+                if(!SdaLine()) I2cStart(); else I2cStop();
+            }
+        } else {
+            bool selected = (lowDir & spiChipSelectMask) && !(lowValue & spiChipSelectMask);
+            if(selected && !spiSelected) SpiBeginFrame();
+            spiSelected = selected;
+        }
+    }
+    /// One bus clock with the current pin state; returns the level sampled on ADBUS2
+    bool ClockBit() {
+        if(loopback) return SdaMaster();
+        if(bus == I2C) {
+            if(!(lowDir & 0x01)) return SdaLine(); // SCL tristated: MPSSE clocks do not reach the bus
+            bool sda = SdaLine();
+            I2cClock(sda);
+            return sda;
+        }
+        if(!spiSelected) return true;
+        return SpiClock(SdaMaster());
+    }
+    uint8_t ShiftBits(uint8_t out, uint32_t nBits, bool writes, bool lsbFirst) {
+        uint8_t in = 0;
+        for(uint32_t b=0; b<nBits; b++) {
+            if(writes) {
+                bool outBit = lsbFirst ? (out >> b) & 1 : (out >> (7-b)) & 1;
+                lowValue = outBit ? (lowValue | 0x02) : (lowValue & ~0x02); // TDI holds the last bit written
+            }
+            bool inBit = ClockBit();
+            in = lsbFirst ? (uint8_t)((in >> 1) | (inBit << 7)) : (uint8_t)((in << 1) | inBit);
+        }
+        Spend_ns(nBits*BitPeriod_ns(), stats.busTime_ns);
+        return in;
+    }
+    void ClockWithoutData(uint32_t nBits) {
+        for(uint32_t b=0; b<nBits; b++) ClockBit();
+        Spend_ns(nBits*BitPeriod_ns(), stats.busTime_ns);
+    }
+    bool GPIOL1() { return (GetPins(false) & 0x20) != 0; };
+    /// Clock up to nBits (0: no limit) until GPIOL1 reaches level. A real FT232H waits forever for
+    /// "wait on I/O"; here that gives up after the read timeout, when the host would have.
+    void ClockUntilGPIOL1(bool level, uint32_t nBits) {
+        stats.gpioWaits++;
+        uint64_t limit = nBits ? nBits : (uint64_t)(readTimeout_ms*1e6/BitPeriod_ns());
+        uint64_t clocked = 0;
+        while(clocked < limit && GPIOL1() != level) {
+            ClockWithoutData(1);
+            clocked++;
+        }
+        if(GPIOL1() != level) stats.gpioWaitTimeouts++;
+    }
+
+    // ==========  I2C slave (MMC5983MA: register pointer auto-increments)  ==========
+    bool I2cSlaveSda() const {
+        switch(i2cState) {
+          case I2C_AddressAck:
+          case I2C_WriteAck: return !i2cAck;
+          case I2C_ReadData: return (i2cTx >> (7-i2cBits)) & 1;
+          default:           return true;
+        }
+    }
+    void I2cStart() { stats.i2cStarts++; i2cState = I2C_Address; i2cShift = 0; i2cBits = 0; };
+    void I2cStop()  { stats.i2cStops++;  i2cState = I2C_Idle; };
+    void I2cClock(bool sda) {
+        switch(i2cState) {
+          case I2C_Idle:
+            break;
+          case I2C_Address:
+          case I2C_WriteData:
+            i2cShift = (uint8_t)((i2cShift << 1) | sda);
+            if(++i2cBits < 8) break;
+            stats.i2cBytes++;
+            if(i2cState == I2C_Address) {
+                i2cAck = (i2cShift >> 1) == i2cAddress;
+                i2cReading = i2cShift & 0x01;
+                i2cState = I2C_AddressAck;
+            } else {
+                if(i2cFirstWriteByte) i2cRegister = i2cShift;
+                else sensor.BusWriteRegister(i2cRegister++, i2cShift);
+                i2cFirstWriteByte = false;
+                i2cAck = true;
+                i2cState = I2C_WriteAck;
+            }
+            if(!i2cAck) stats.i2cNacks++;
+            break;
+          case I2C_AddressAck:
+            if(!i2cAck) { i2cState = I2C_Idle; break; }
+            i2cBits = 0; i2cShift = 0;
+            if(i2cReading) {
+                i2cTx = sensor.BusReadRegister(i2cRegister++);
+                i2cState = I2C_ReadData;
+            } else {
+                i2cFirstWriteByte = true;
+                i2cState = I2C_WriteData;
+            }
+            break;
+          case I2C_WriteAck:
+            i2cBits = 0; i2cShift = 0;
+            i2cState = I2C_WriteData;
+            break;
+          case I2C_ReadData:
+            if(++i2cBits == 8) { stats.i2cBytes++; i2cState = I2C_ReadAck; }
+            break;
+          case I2C_ReadAck:
+            if(sda) { i2cState = I2C_Idle; break; } // master NACK: last byte, STOP follows
+            i2cBits = 0;
+            i2cTx = sensor.BusReadRegister(i2cRegister++);
+            i2cState = I2C_ReadData;
+            break;
+        }
+    }
+    // ==========  SPI slave (MMC5983MA: first byte is R/W bit 7 and address, then data, address auto-increments)  ==========
+    void SpiBeginFrame() { stats.spiFrames++; spiBits = 0; spiByteIdx = 0; spiTx = 0; spiShift = 0; };
+    bool SpiClock(bool mosi) {
+        bool miso = (spiTx >> (7-spiBits)) & 1;
+        spiShift = (uint8_t)((spiShift << 1) | mosi);
+        if(++spiBits == 8) {
+            spiBits = 0;
+            if(spiByteIdx++ == 0) {
+                spiRead = spiShift & 0x80;
+                spiRegister = spiShift & 0x3F;
+            } else {
+                stats.spiBytes++;
+                if(!spiRead) sensor.BusWriteRegister(spiRegister++, spiShift);
+            }
+            spiTx = spiRead ? sensor.BusReadRegister(spiRegister++) : 0;
+        }
+        return miso;
+    }
+
+    // ==========  MPSSE command decoder  ==========
+    /// Execute one command from the start of cmd; returns bytes consumed, or 0 if the command is incomplete
+    size_t ExecuteCommand(const uint8_t *cmd, size_t avail) {
+        uint8_t op = cmd[0];
+        if((op & 0xC0) == 0 && (op & 0x30)) { // data shifting: 0x10 write, 0x20 read, 0x02 bits, 0x08 LSB first
+            bool bitMode = op & 0x02, writes = op & 0x10, reads = op & 0x20, lsbFirst = op & 0x08;
+            size_t header = bitMode ? 2 : 3;
+            if(avail < header) return 0;
+            uint32_t len = bitMode ? cmd[1]+1u : (cmd[1] | (cmd[2] << 8)) + 1u; // bits or bytes
+            size_t dataBytes = writes ? (bitMode ? 1 : len) : 0;
+            if(avail < header+dataBytes) return 0;
+            if(bitMode) {
+                uint8_t in = ShiftBits(writes ? cmd[header] : 0, len, writes, lsbFirst);
+                if(reads) Respond(in);
+            } else {
+                for(uint32_t i=0; i<len; i++) {
+                    uint8_t in = ShiftBits(writes ? cmd[header+i] : 0, 8, writes, lsbFirst);
+                    if(reads) Respond(in);
+                }
+            }
+            return header+dataBytes;
+        }
+        Spend_ns(mpsseCommand_ns, stats.busTime_ns);
+        switch(op) {
+          case MPSSE_CMD_SET_DATA_BITS_LOWBYTE:
+          case MPSSE_CMD_SET_DATA_BITS_HIGHBYTE:
+            if(avail < 3) return 0;
+            SetPins(op == MPSSE_CMD_SET_DATA_BITS_HIGHBYTE, cmd[1], cmd[2]);
+            return 3;
+          case MPSSE_CMD_GET_DATA_BITS_LOWBYTE:
+          case MPSSE_CMD_GET_DATA_BITS_HIGHBYTE:
+            Respond(GetPins(op == MPSSE_CMD_GET_DATA_BITS_HIGHBYTE));
+            return 1;
+          case 0x84: loopback = true;  return 1;
+          case 0x85: loopback = false; return 1;
+          case 0x86: // clock divisor
+            if(avail < 3) return 0;
+            clockDivisor = (uint16_t)(cmd[1] | (cmd[2] << 8));
+            return 3;
+          case MPSSE_CMD_SEND_IMMEDIATE: rxPushed = true; return 1;
+          case 0x8A: divideBy5 = false; return 1;
+          case 0x8B: divideBy5 = true;  return 1;
+          case MPSSE_CMD_ENABLE_3PHASE_CLOCKING:  threePhase = true;  return 1;
+          case MPSSE_CMD_DISABLE_3PHASE_CLOCKING: threePhase = false; return 1;
+          case 0x96: case 0x97: return 1; // adaptive clocking on/off
+          case MPSSE_CMD_CLOCK_BITS:
+            if(avail < 2) return 0;
+            ClockWithoutData(cmd[1] + 1u);
+            return 2;
+          case MPSSE_CMD_CLOCK_BYTES:
+            if(avail < 3) return 0;
+            ClockWithoutData(8u * ((cmd[1] | (cmd[2] << 8)) + 1u));
+            return 3;
+          case MPSSE_CMD_WAIT_ON_IO_HIGH:
+          case MPSSE_CMD_WAIT_ON_IO_LOW:
+            ClockUntilGPIOL1(op == MPSSE_CMD_WAIT_ON_IO_HIGH, 0);
+            return 1;
+          case MPSSE_CMD_CLOCK_BYTES_OR_IO_HIGH:
+          case MPSSE_CMD_CLOCK_BYTES_OR_IO_LOW:
+            if(avail < 3) return 0;
+            ClockUntilGPIOL1(op == MPSSE_CMD_CLOCK_BYTES_OR_IO_HIGH, 8u * ((cmd[1] | (cmd[2] << 8)) + 1u));
+            return 3;
+          case MPSSE_CMD_ENABLE_DRIVE_ONLY_ZERO: // open drain is how I2C lines are modeled anyway
+            if(avail < 3) return 0;
+            return 3;
+          default: // MPSSE answers an unknown opcode with 0xFA and the opcode (libMPSSE sync uses 0xAA and 0xAB)
+            stats.badCommands++;
+            Respond(0xFA);
+            Respond(op);
+            rxPushed = true;
+            return 1;
+        }
+    }
+
+    // ==========  D2XX entry points  ==========
+    FT_STATUS Write(const uint8_t *buf, DWORD len, DWORD *written) {
+        stats.usbWrites++;
+        stats.bytesToDevice += len;
+        stats.packetsToDevice += Packets(len, 512);
+        Spend_ns(usbMicroframe_ns + (double)len*usbByte_ns, stats.usbTime_ns);
+        *written = len;
+        if(!mpsseMode) return FT_OK; // bit-bang data is not modeled
+        pendingCommands.insert(pendingCommands.end(), buf, buf+len);
+        size_t done = 0;
+        while(done < pendingCommands.size()) {
+            size_t used = ExecuteCommand(&pendingCommands[done], pendingCommands.size()-done);
+            if(used == 0) break;
+            done += used;
+        }
+        pendingCommands.erase(pendingCommands.begin(), pendingCommands.begin()+done);
+        return FT_OK;
+    }
+    FT_STATUS Read(uint8_t *buf, DWORD len, DWORD *returned) {
+        stats.usbReads++;
+        if(rx.size() < len) { // D2XX blocks until the read timeout, then returns what arrived
+            stats.readTimeouts++;
+            Spend_ns(readTimeout_ms*1e6, stats.latencyWait_ns);
+            rxAtHost = true;
+            len = (DWORD)rx.size();
+        }
+        DeliverResponses();
+        stats.bytesFromDevice += len;
+        stats.packetsFromDevice += Packets(len, 510);
+        Spend_ns((double)len*usbByte_ns, stats.usbTime_ns);
+        for(DWORD i=0; i<len; i++) { buf[i] = rx.front(); rx.pop_front(); }
+        if(rx.empty()) rxPushed = rxAtHost = false;
+        *returned = len;
+        return FT_OK;
+    }
+    FT_STATUS QueueStatus(DWORD *bytesInRxQueue) {
+        stats.queueStatusPolls++;
+        DeliverResponses();
+        *bytesInRxQueue = (DWORD)rx.size();
+        return FT_OK;
+    }
+    FT_STATUS Purge(DWORD mask) {
+        stats.purges++;
+        Spend_ns(usbMicroframe_ns, stats.usbTime_ns); // a control request to the chip
+        if(mask & FT_PURGE_RX) { rx.clear(); rxPushed = rxAtHost = false; }
+        if(mask & FT_PURGE_TX) pendingCommands.clear();
+        return FT_OK;
+    }
+    void ResetMPSSE() {
+        pendingCommands.clear();
+        rx.clear();
+        rxPushed = rxAtHost = false;
+        clockDivisor = 0; divideBy5 = true; threePhase = false; loopback = false;
+        lowValue = lowDir = highValue = highDir = 0;
+        i2cState = I2C_Idle;
+        spiSelected = false;
+    }
+
+    // Emulated USB bus: devices are enumerated in Install order, the FT_HANDLE is the emulator itself
+    static inline FT232H_Emulator_C *devices[MaxDevices] = {};
+    static inline int deviceCount = 0;
+    int DeviceIndex() const {
+        for(int i=0; i<deviceCount; i++) if(devices[i] == this) return i;
+        return -1;
+    }
+    static FT232H_Emulator_C *FromHandle(FT_HANDLE handle) {
+        for(int i=0; i<deviceCount; i++) if(devices[i] == handle && devices[i]->opened) return devices[i];
+        return nullptr;
+    }
+    static void DeviceInfo(int idx, FT_DEVICE_LIST_INFO_NODE &node) {
+        memset(&node, 0, sizeof(node));
+        node.Flags = FT_FLAGS_HISPEED | (devices[idx]->opened ? FT_FLAGS_OPENED : 0);
+        node.Type = FT_DEVICE_232H;
+        node.ID = 0x04036014; // FTDI VID, FT232H PID
+        node.LocId = 0x1000u + idx;
+        snprintf(node.SerialNumber, sizeof(node.SerialNumber), "EMU%05d", idx);
+        snprintf(node.Description, sizeof(node.Description), "Emulated FT232H");
+        node.ftHandle = devices[idx]->opened ? (FT_HANDLE)devices[idx] : nullptr;
+    }
+
+    static FT_STATUS CAL_CONV Emu_GetLibraryVersion(LPDWORD lpdwVersion) { *lpdwVersion = 0x00010000; return FT_OK; };
+    static FT_STATUS CAL_CONV Emu_CreateDeviceInfoList(LPDWORD lpdwNumDevs) { *lpdwNumDevs = (DWORD)deviceCount; return FT_OK; };
+    static FT_STATUS CAL_CONV Emu_GetDeviceInfoList(FT_DEVICE_LIST_INFO_NODE *pDest, LPDWORD lpdwNumDevs) {
+        for(int i=0; i<deviceCount && i<(int)*lpdwNumDevs; i++) DeviceInfo(i, pDest[i]);
+        *lpdwNumDevs = (DWORD)deviceCount;
+        return FT_OK;
+    };
+    static FT_STATUS CAL_CONV Emu_Open(int iDevice, FT_HANDLE *ftHandle) {
+        if(iDevice < 0 || iDevice >= deviceCount) return FT_DEVICE_NOT_FOUND;
+        if(devices[iDevice]->opened) return FT_DEVICE_NOT_OPENED;
+        devices[iDevice]->opened = true;
+        devices[iDevice]->ResetMPSSE();
+        devices[iDevice]->mpsseMode = false;
+        *ftHandle = (FT_HANDLE)devices[iDevice];
+        return FT_OK;
+    };
+    static FT_STATUS CAL_CONV Emu_Close(FT_HANDLE ftHandle) {
+        FT232H_Emulator_C *emu = FromHandle(ftHandle);
+        if(!emu) return FT_INVALID_HANDLE;
+        emu->opened = false;
+        return FT_OK;
+    };
+    static FT_STATUS CAL_CONV Emu_ResetDevice(FT_HANDLE ftHandle) {
+        FT232H_Emulator_C *emu = FromHandle(ftHandle);
+        if(!emu) return FT_INVALID_HANDLE;
+        emu->ResetMPSSE();
+        return FT_OK;
+    };
+    static FT_STATUS CAL_CONV Emu_Purge(FT_HANDLE ftHandle, DWORD dwMask) {
+        FT232H_Emulator_C *emu = FromHandle(ftHandle);
+        return emu ? emu->Purge(dwMask) : (FT_STATUS)FT_INVALID_HANDLE;
+    };
+    static FT_STATUS CAL_CONV Emu_SetUSBParameters(FT_HANDLE ftHandle, DWORD, DWORD) {
+        return FromHandle(ftHandle) ? FT_OK : FT_INVALID_HANDLE;
+    };
+    static FT_STATUS CAL_CONV Emu_SetChars(FT_HANDLE ftHandle, UCHAR, UCHAR, UCHAR, UCHAR) {
+        return FromHandle(ftHandle) ? FT_OK : FT_INVALID_HANDLE;
+    };
+    static FT_STATUS CAL_CONV Emu_SetTimeouts(FT_HANDLE ftHandle, DWORD dwReadTimeout, DWORD) {
+        FT232H_Emulator_C *emu = FromHandle(ftHandle);
+        if(!emu) return FT_INVALID_HANDLE;
+        emu->readTimeout_ms = dwReadTimeout;
+        return FT_OK;
+    };
+    static FT_STATUS CAL_CONV Emu_SetLatencyTimer(FT_HANDLE ftHandle, UCHAR ucTimer) {
+        FT232H_Emulator_C *emu = FromHandle(ftHandle);
+        if(!emu) return FT_INVALID_HANDLE;
+        emu->latencyTimer_ms = ucTimer < 1 ? 1 : ucTimer; // FT232H minimum is 1ms
+        return FT_OK;
+    };
+    static FT_STATUS CAL_CONV Emu_GetLatencyTimer(FT_HANDLE ftHandle, UCHAR *ucTimer) {
+        FT232H_Emulator_C *emu = FromHandle(ftHandle);
+        if(!emu) return FT_INVALID_HANDLE;
+        *ucTimer = emu->latencyTimer_ms;
+        return FT_OK;
+    };
+    static FT_STATUS CAL_CONV Emu_SetBitmode(FT_HANDLE ftHandle, UCHAR, UCHAR ucMode) {
+        FT232H_Emulator_C *emu = FromHandle(ftHandle);
+        if(!emu) return FT_INVALID_HANDLE;
+        emu->ResetMPSSE();
+        emu->mpsseMode = (ucMode == FT_BITMODE_MPSSE);
+        return FT_OK;
+    };
+    static FT_STATUS CAL_CONV Emu_GetQueueStatus(FT_HANDLE ftHandle, LPDWORD lpdwAmountInRxQueue) {
+        FT232H_Emulator_C *emu = FromHandle(ftHandle);
+        return emu ? emu->QueueStatus(lpdwAmountInRxQueue) : (FT_STATUS)FT_INVALID_HANDLE;
+    };
+    static FT_STATUS CAL_CONV Emu_Read(FT_HANDLE ftHandle, LPVOID lpBuffer, DWORD dwBytesToRead, LPDWORD lpdwBytesReturned) {
+        FT232H_Emulator_C *emu = FromHandle(ftHandle);
+        return emu ? emu->Read((uint8_t*)lpBuffer, dwBytesToRead, lpdwBytesReturned) : (FT_STATUS)FT_INVALID_HANDLE;
+    };
+    static FT_STATUS CAL_CONV Emu_Write(FT_HANDLE ftHandle, LPVOID lpBuffer, DWORD dwBytesToWrite, LPDWORD lpdwBytesWritten) {
+        FT232H_Emulator_C *emu = FromHandle(ftHandle);
+        return emu ? emu->Write((const uint8_t*)lpBuffer, dwBytesToWrite, lpdwBytesWritten) : (FT_STATUS)FT_INVALID_HANDLE;
+    };
+    static FT_STATUS CAL_CONV Emu_GetDeviceInfo(FT_HANDLE ftHandle, FT_DEVICE *lpftDevice, LPDWORD lpdwID,
+                                                PCHAR SerialNumber, PCHAR Description, LPVOID) {
+        FT232H_Emulator_C *emu = FromHandle(ftHandle);
+        if(!emu) return FT_INVALID_HANDLE;
+        FT_DEVICE_LIST_INFO_NODE node;
+        DeviceInfo(emu->DeviceIndex(), node);
+        if(lpftDevice) *lpftDevice = node.Type;
+        if(lpdwID) *lpdwID = node.ID;
+        if(SerialNumber) strcpy(SerialNumber, node.SerialNumber);
+        if(Description) strcpy(Description, node.Description);
+        return FT_OK;
+    };
+};
+
+#endif // FT232H_Emulator_HPP_INCLUDED
@@ -30,16 +30,29 @@ SOFTWARE.
 #endif
 #include "MCP2221.hpp"
 
-bool MCP2221::Init()
+unsigned int MCP2221::ConnectedDevices()
 {
-    const unsigned int MCP2221_VID = 0x4d8; //default VID
-    const unsigned int MCP2221_PID = 0xDD; // default PID
+    unsigned int count = 0;
+    if (Mcp2221_GetConnectedDevices(MCP2221_VID, MCP2221_PID, &count) != 0)
+        return 0;
+    return count;
+}
 
+bool MCP2221::Init()
+{
     Mcp2221_GetConnectedDevices(MCP2221_VID, MCP2221_PID, &connectedDevices);
     if (connectedDevices <= 0)
         throw std::runtime_error("No MCP2221 connected to this PC");
-    handle = Mcp2221_OpenByIndex(MCP2221_VID, MCP2221_PID, 0);
+    if (!openSerialNumber.empty()) {
+        handle = Mcp2221_OpenBySN(MCP2221_VID, MCP2221_PID, const_cast<wchar_t*>(openSerialNumber.c_str()));
+        if (handle == 0)
+            throw std::runtime_error("Mcp2221_OpenBySN failed");
+        return false;
+    }
+    if (openIndex >= connectedDevices)
+        throw std::runtime_error("Fewer MCP2221 connected to this PC than requested");
+    handle = Mcp2221_OpenByIndex(MCP2221_VID, MCP2221_PID, openIndex);
     if (handle == 0)
         throw std::runtime_error("Mcp2221_OpenByIndex failed");
     return false;
-}
\ No newline at end of file
+}
\ No newline at end of file
@@ -27,6 +27,7 @@ SOFTWARE.
 #pragma once
 #include <stdint.h>
 #include <assert.h>
+#include <string>
 #include "mcp2221_dll_um.h" // Microchip API
 
 class MCP2221
@@ -35,6 +36,11 @@ class MCP2221
 	MCP2221() {}; // real work is done in Init(), not ctor
 	bool Init();
 	unsigned int connectedDevices = 0; // How many MCP2221 attached to this PC?
+	unsigned int openIndex = 0; // Which one Init opens (0 to connectedDevices-1)...
+	std::wstring openSerialNumber; // ...or, if set, the one with this USB serial number (needs serial number enumeration enabled)
+	static unsigned int ConnectedDevices(); // How many MCP2221 attached, without opening any
+	static const unsigned int MCP2221_VID = 0x4d8; // default VID
+	static const unsigned int MCP2221_PID = 0xDD; // default PID
 	void* handle = 0;
 	bool IsOpen() { return handle != 0; };
 
@@ -27,12 +27,12 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 */
 
-// ToDo MMC5983MA: Fix haphazard return values from API, maybe factor out measurement result class.
-// ToDo MMC5983MA: Implement continuous mode? Currently 8ms delay per measurement (17ms using AutoSR).
-// #define MMC5983MA_CONTINUOUS_MODE // default as coded is one-shot
+// ToDo MMC5983MA: Fix haphazard return values from API (Measure and MMC5983MA_Sample_T are a start).
+// One-shot measurements cost 8ms delay per measurement (17ms using AutoSR) plus bus round-trips;
+// for higher throughput use continuous mode (selected at runtime, see StartContinuousMode).
+// If the sensor's INT pin is wired to the adapter, see EnableDataReadyInterrupt.
 
-// Register-IO trace is enabled with the following #define:
-// #define MMC5983MA_PRINT_DETAILED_LOG
+// Register-IO trace: attach an MMC5983MA_Trace_C to registerTrace (see MMC5983MA_Trace.hpp).
 
 // See Ten(!) YouTube videos about this part by Robert.Drees@gmx.net here:
 // https://www.youtube.com/@robertssmorgasbord/search?query=mmc
@@ -88,7 +88,8 @@ RESET/SET procedure:
 - SET/RESET does not reverse polarity of YZ (only X works) when using SPI: bug in MMC5983MA!
   See: https://electronics.stackexchange.com/questions/736609/magnetometer-memsic-mmc5983ma-set-reset-only-works-on-x-channel-when-using-spi
 - Any rotation between the two measurements (between SET and RESET measurements) creates an error!
-  Sensor must be relatively still.
+  Sensor must be relatively still, or use a motion-compensated mode (Measure_XYZ_Field_WithResetSetReset,
+  Measure_XYZ_Field_Alternating), which interpolates opposite-polarity readings to the same instant.
 - Code must wait 500uSec after RESET or SET before making a reading (AutoSR waits internally)
 
 Saturation Detection:
@@ -109,6 +110,47 @@ Chip power-on or reset does a 'SET', so chip always comes up with normal polariz
 #include <stddef.h> // size_t
 #include <assert.h>
 #include <memory.h> // memcpy
+#include <type_traits>
+
+#include "MMC5983MA_Ring.hpp"
+#include "MMC5983MA_Trace.hpp"
+
+/// One-shot measurement modes (MMC5983MA_C::Measure; StartMeasurement supports ResetSet and AutoSR)
+enum class MMC5983MA_MeasurementMode_T : uint8_t {
+    ResetSet,      ///< Measure_XYZ_Field_WithResetSet: RESET, convert, SET, convert
+    AutoSR,        ///< Measure_XYZ_Field_WithAutoSR: one Auto-SR conversion, no offset
+    CachedOffset,  ///< Measure_XYZ_Field_WithCachedOffset
+    ResetSetReset, ///< Measure_XYZ_Field_WithResetSetReset (motion-compensated)
+    Alternating,   ///< Measure_XYZ_Field_Alternating (motion-compensated, one conversion late)
+};
+
+/// One measurement as a self-contained record (MMC5983MA_C::Measure, PollMeasurement).
+/// Trivially copyable and one cache line, so it can be queued, batched, or written to a file as is,
+/// and handed to another thread without sharing the driver's field and offset members.
+struct alignas(64) MMC5983MA_Sample_T {
+    enum Flags_T : uint8_t {
+        IOFailure        = 0x01, ///< a bus transaction failed
+        NotAvailable     = 0x02, ///< not measured: not initialized, continuous mode running, or mode not supported here
+        Priming          = 0x04, ///< Alternating: no field yet (first two calls, or after a mode change)
+        DataReadyTimeout = 0x08, ///< INT did not come in time; the result was polled instead
+        NominalOffset    = 0x10, ///< offset not measured: 0 (Auto-SR), or nominal 0x20000 (SPI Y/Z, see FieldFromSetReset)
+        ConversionTimeout = 0x20, ///< a conversion never reported complete (result -1)
+    };
+    uint64_t start_us;  ///< TDEVICE time_us() when the measurement began
+    uint64_t end_us;    ///< TDEVICE time_us() when it completed (or failed)
+    uint32_t sequence;  ///< counts this driver's records, failures included
+    uint32_t raw[3];    ///< field-polarity conversion (SET, or Auto-SR), unsigned 18-bit X,Y,Z
+    int32_t field[3];   ///< offset-corrected field, as MMC5983MA_C::field
+    uint32_t offset[3]; ///< offset, as MMC5983MA_C::offset
+    int32_t fieldAt_us; ///< motion-compensated modes: instant the field represents, relative to start_us (else 0)
+    int8_t result;      ///< as the Measure_XYZ_Field_* return: 0 OK, 1 priming, -1 failure
+    uint8_t mode;       ///< MMC5983MA_MeasurementMode_T
+    uint8_t bandwidth;  ///< MMC5983MA_C::Bandwidth_T
+    uint8_t flags;      ///< Flags_T
+    bool Ok() const { return result == 0; };
+};
+static_assert(sizeof(MMC5983MA_Sample_T) == 64, "MMC5983MA_Sample_T should be one cache line");
+static_assert(std::is_trivially_copyable_v<MMC5983MA_Sample_T>, "MMC5983MA_Sample_T is copied as bytes");
 
 /// Driver for MMC5983MA 3-axis magnetometer sensor <BR>
 /// See MMC5983MA_IO.hpp for example TDEVICE class (provides platform-specific IO)
@@ -125,6 +167,25 @@ class MMC5983MA_C {
         Bandwidth_10_400Hz = 0x02, // 2msec
         Bandwidth_11_800Hz = 0x03, // .5msec
     };
+    /// Continuous mode measurement rate (Control_2 CM_freq field).
+    /// 200Hz requires bandwidth of at least 200Hz; 1000Hz requires 800Hz bandwidth.
+    enum class ContinuousRate_T : uint8_t {
+        ContinuousRate_Off    = 0x00,
+        ContinuousRate_1Hz    = 0x01,
+        ContinuousRate_10Hz   = 0x02,
+        ContinuousRate_20Hz   = 0x03,
+        ContinuousRate_50Hz   = 0x04,
+        ContinuousRate_100Hz  = 0x05,
+        ContinuousRate_200Hz  = 0x06,
+        ContinuousRate_1000Hz = 0x07,
+    };
+    /// One continuous-mode sample as queued in continuousSamples
+    struct ContinuousSample_T {
+        uint32_t sequence;     ///< Increments for every sample fetched from the sensor; a gap means the ring was full
+        uint64_t timestamp_us; ///< TDEVICE time_us() when the sample was fetched
+        uint32_t raw[3];       ///< Raw unsigned 18-bit X,Y,Z
+        int32_t  field[3];     ///< Signed X,Y,Z adjusted with offset (0x20000 for AutoSR or if no offset measured yet)
+    };
 
   protected:
     // Register addresses within MMC5983MA
@@ -151,7 +212,7 @@ class MMC5983MA_C {
         Control_2  = 0x0b, ///< Control register 2   write-only
         Control_3  = 0x0c, ///< Control register 3   write-only
     };
-    const char* RegisterName(Register reg) const {
+    static const char* RegisterName(Register reg) {
         if(reg==Register::Product_ID/*0x2f*/) return "Product ID";
         int regIdx = (int)reg;
         static const char* const names[] {
@@ -220,7 +281,7 @@ class MMC5983MA_C {
     };
     enum class Control_2_Mask : uint8_t {
         Setting_ContinuousModeRate = 0x07,  ///< 0 is Off. See table in datasheet for nominal values.
-        Setting_ContinuousModeEnable = 0x80, ///< 1 to enable, rate above must not be 0 if enabled.
+        Setting_ContinuousModeEnable = 0x08, ///< Cmm_en: 1 to enable, rate above must not be 0 if enabled.
         Setting_AutoSETrate = 0x70, ///< Controls number of measurements between automatic SET if enabled
         Setting_AutoSETenable = 0x80,  ///< 1 enables automatic periodic SET
     };
@@ -243,11 +304,40 @@ class MMC5983MA_C {
 
     /// Read the magnetic field, including a Reset/Set operation
     /// to compute offset. Place results in field and offset members.
+    /// Returns 0 on success, -1 if a bus transaction failed or a conversion never completed
+    /// (field and offset are then unchanged).
     int8_t Measure_XYZ_Field_WithResetSet();
 
     /// Read the magnetic field using poorly-documented Auto-Set-Reset feature.
+    /// Returns as Measure_XYZ_Field_WithResetSet.
     int8_t Measure_XYZ_Field_WithAutoSR();
 
+    /// Read the magnetic field with a single SET-polarity conversion corrected by the offset
+    /// from the last RESET/SET measurement, which is refreshed only when due (see offsetTracking):
+    /// nearly twice the sample rate and half the bus traffic of Measure_XYZ_Field_WithResetSet.
+    /// Places results in field and offset members.
+    int8_t Measure_XYZ_Field_WithCachedOffset();
+
+    /// Motion-compensated RESET/SET: RESET, measure, SET, measure, RESET, measure. The two RESET readings
+    /// are interpolated to the instant of the SET reading, so steady rotation during the sequence cancels
+    /// (instead of appearing as field and offset error). Places results in field, offset, and fieldTime_us.
+    int8_t Measure_XYZ_Field_WithResetSetReset();
+
+    /// Rolling alternation: each call pulses the polarity opposite to the previous call's (SET, RESET, SET...)
+    /// and makes one conversion. The previous conversion is then bracketed by opposite-polarity readings,
+    /// which are interpolated to its instant: one motion-compensated field per conversion, one conversion late
+    /// (fieldTime_us is when the previous conversion started). Call at a steady rate for best compensation.
+    /// Returns 1 while priming (first two calls, or after bandwidth/mode changes), 0 when field and offset
+    /// were updated, -1 on failure.
+    int8_t Measure_XYZ_Field_Alternating();
+
+    typedef MMC5983MA_MeasurementMode_T MeasurementMode_T;
+    /// Any of the measurements above, returned as a record (also kept as LastSample()).
+    /// The record's result is what the Measure_XYZ_Field_* function returned.
+    MMC5983MA_Sample_T Measure(MeasurementMode_T mode = MeasurementMode_T::ResetSet);
+    /// Record of the last Measure, or of the last measurement PollMeasurement completed or failed
+    const MMC5983MA_Sample_T &LastSample() const { return lastSample; };
+
     int32_t field[3] = {0}; ///< Last magnetic field reading set (X,Y,Z), signed values already adjusted with offsets.
     const static int32_t CountsPerGauss = 16384; // 2^17 / 8G full-scale when using full 18-bit resolution as we do here.
 
@@ -255,6 +345,167 @@ class MMC5983MA_C {
     /// with zero external field. Should be about mid-range for 18-bit value,
     /// ie 2^17 = 0x20000 = 131072.
     uint32_t offset[3] = {0};  ///< Last measured offset (X,Y,Z) - always included in field above.
+    uint64_t fieldTime_us = 0; ///< Motion-compensated modes: dev.time_us() of the instant field represents
+
+    /// Offset refresh policy and statistics for Measure_XYZ_Field_WithCachedOffset.
+    /// The offset drifts slowly (mostly with temperature), so a full RESET/SET is needed only every
+    /// 'interval' samples. Each refresh compares the new offset with the cached one: if any axis moved
+    /// more than driftThreshold counts, interval halves (to minInterval) and the next refresh comes sooner;
+    /// if every axis moved less than a quarter of driftThreshold, interval doubles (to maxInterval).
+    /// Changing bandwidth, Auto-SR or continuous measurements, and Init invalidate the cached offset.
+    struct OffsetTracking_T {
+        uint32_t minInterval = 4;      ///< fewest samples between refreshes
+        uint32_t maxInterval = 256;    ///< most samples between refreshes
+        uint32_t driftThreshold = 16;  ///< offset change, in counts (16 is about 1mG), that shortens the interval
+        uint32_t interval = 16;        ///< current samples between refreshes (adapts between min and max)
+        uint32_t sinceRefresh = 0;     ///< cached-offset samples since the last refresh
+        bool valid = false;            ///< false: next measurement refreshes the offset
+        uint32_t refreshes = 0;        ///< RESET/SET measurements made by Measure_XYZ_Field_WithCachedOffset
+        uint32_t cachedSamples = 0;    ///< single conversions corrected by the cached offset
+        uint32_t driftEvents = 0;      ///< refreshes that found the offset moved more than driftThreshold
+        uint32_t lastDrift = 0;        ///< largest per-axis offset change found by the last refresh, in counts
+    } offsetTracking;
+    /// Make the next Measure_XYZ_Field_WithCachedOffset do a full RESET/SET (for example, after a large field
+    /// or temperature change the application knows about)
+    void RequestOffsetRefresh() { offsetTracking.valid = false; };
+
+    /// Data-ready interrupt (TDEVICE::SupportsDataReady, with the sensor's INT pin wired to the adapter):
+    /// one-shot measurements then wait for INT, inside the batch where the adapter can, instead of sleeping
+    /// for the learned conversion time and polling Status. The result is read as soon as the conversion
+    /// really ends, with no status polls. Call after Init (its software reset disables INT).
+    /// Returns -1 if this TDEVICE or its wiring cannot see INT.
+    int8_t EnableDataReadyInterrupt(bool enable = true);
+    bool UsingDataReadyInterrupt() const {
+        return (control_settings[0] & (uint8_t)Control_0_Mask::Setting_Enable_MeasurementDoneINT) != 0;
+    }
+
+    // Split-phase one-shot measurement, for callers that do other work (for example, talk to another
+    // sensor on the same bus, see MMC5983MA_BusScheduler_C) while this one pulses or converts.
+    // Each call is one bus transaction (plus one more when Auto-SR must be switched), and none waits.
+    /// SET (set true) or RESET pulse, with Auto-SR off. Wait RequiredWaitAfterMagnetizePulse_uSec before StartConversion.
+    int8_t StartPulse(bool set);
+    /// Start a one-shot conversion (Auto-SR or plain); poll it with PollConversion after ConversionWait_us()
+    int8_t StartConversion(bool autoSR = false);
+    /// When to first poll a conversion started now: this part's learned conversion time (see ConversionTiming_T)
+    uint32_t ConversionWait_us() { return FirstPollDelay_us(); };
+    /// If PollConversion returned 0, how long to wait before polling again
+    uint32_t ConversionRetry_us() const {
+        uint32_t retry_us = (uint32_t)uSecPerMeasurement()/32;
+        return retry_us < 50 ? 50 : retry_us;
+    };
+    /// Read the conversion started by StartConversion: 1 when complete (result holds it), 0 if not yet,
+    /// -1 on IO failure or if the conversion is overdue (DataReadyTimeout_us after StartConversion)
+    int8_t PollConversion(uint32_t (&result)[3]);
+    /// Set field and offset from the RESET and SET conversions of a split-phase RESET/SET measurement
+    void SetFieldFromResetSet(const uint32_t (&resultAfter_RESET)[3], const uint32_t (&resultAfter_SET)[3]) {
+        FieldFromSetReset(resultAfter_SET, resultAfter_RESET);
+    }
+    /// Set field (offset 0) from a split-phase Auto-SR conversion
+    void SetFieldFromAutoSR(const uint32_t (&autoSR_result)[3]) { FieldFromAutoSR(autoSR_result); };
+
+    // Non-blocking measurement: the split-phase steps above as one state machine. StartMeasurement
+    // performs the first step; call PollMeasurement again at (or after) MeasurementDue_us() until it
+    // returns 1 (field, offset, and LastSample() set, as Measure would) or -1.
+    // Each call performs at most one step; called before MeasurementDue_us() it returns 0 without IO.
+    // See MMC5983MA_Async.hpp for a coroutine wrapper and event loop.
+    /// Begin a ResetSet or AutoSR measurement (abandoning any in progress): 0 if started, -1 on IO failure
+    int8_t StartMeasurement(MeasurementMode_T mode = MeasurementMode_T::ResetSet);
+    /// Advance the measurement: 1 complete, 0 still in progress, -1 on IO failure (or none started)
+    int8_t PollMeasurement();
+    bool MeasurementPending() const { return asyncStep != AsyncStep_T::Idle; };
+    /// Time (dev.time_us()) at which PollMeasurement has its next step to perform
+    uint64_t MeasurementDue_us() const { return asyncDue_us; };
+
+    /// Start continuous mode: the sensor free-runs at the given rate, and
+    /// ServiceContinuousMode() moves completed samples into continuousSamples.
+    /// Returns -1 if the rate is not supported at the given bandwidth.
+    int8_t StartContinuousMode(ContinuousRate_T rate,
+                               Bandwidth_T bw = Bandwidth_T::Bandwidth_00_100Hz,
+                               bool useAutoSR = true);
+    /// Stop continuous mode, returning to one-shot (commanded) measurements.
+    int8_t StopContinuousMode();
+    /// Fetch a completed continuous-mode sample (if any) into continuousSamples.
+    /// Call at least as often as the continuous rate (see uSecPerContinuousSample).
+    /// Returns 1 if a sample was queued, 0 if none was ready, -1 on IO failure.
+    int8_t ServiceContinuousMode();
+    /// Nominal continuous-mode sample period for the current setting, 0 if not in continuous mode.
+    uint32_t uSecPerContinuousSample() const {
+        static const uint32_t usecGivenRate[8] = { 0, 1000000, 100000, 50000, 20000, 10000, 5000, 1000 };
+        if(!InContinuousMode()) return 0;
+        return usecGivenRate[control_settings[2] & (uint8_t)Control_2_Mask::Setting_ContinuousModeRate];
+    }
+    bool InContinuousMode() const {
+        return (control_settings[2] & (uint8_t)Control_2_Mask::Setting_ContinuousModeEnable)!=0;
+    }
+
+    static const size_t ContinuousRingCapacity = 64; ///< 64ms of samples at the maximum 1000Hz rate
+    /// Continuous-mode samples waiting for the application (single producer/single consumer)
+    MMC5983MA_Ring_C<ContinuousSample_T, ContinuousRingCapacity> continuousSamples;
+    uint32_t continuousSequence = 0; ///< sequence number of the next continuous-mode sample
+
+    /// Bus traffic generated by this driver instance (all TDEVICE backends)
+    struct BusStatistics_T {
+        uint32_t readTransactions;  ///< get_regs calls (each is one addressed bus read, batched or not)
+        uint32_t writeTransactions; ///< set_regs calls
+        uint32_t bytesRead;
+        uint32_t bytesWritten;
+        uint32_t batchFlushes;      ///< Batches executed (TDEVICE::SupportsBatching only; one host round-trip each)
+        uint32_t batchFallbacks;    ///< Batched measurements redone unbatched (conversion not complete when read)
+        uint32_t dataReadyTimeouts; ///< Unbatched waits for INT that timed out (fell back to polling)
+        uint32_t ioFailures;        ///< Unbatched transactions and batch flushes that failed
+        uint32_t conversionTimeouts;///< Conversions that never reported complete (measurement failed)
+    } busStats = {0,0,0,0,0,0,0,0,0};
+    void ResetBusStatistics() { busStats = {0,0,0,0,0,0,0,0,0}; };
+
+    /// Learned one-shot conversion timing for one Bandwidth_T/AutoSR combination.
+    /// firstPoll_us tracks (approximately) the FirstPollTargetMissRatio quantile of this part's
+    /// actual completion time: each first-poll hit shortens it a little, each miss lengthens it
+    /// (FirstPollTargetMissRatio-1) times as much, so it settles where misses are that rare.
+    struct ConversionTiming_T {
+        uint32_t firstPoll_us;   ///< Current delay from TM_M to first poll (0 until first use)
+        uint32_t measurements;   ///< One-shot measurements made with this setting
+        uint32_t firstPollHits;  ///< ...of which were complete at the first poll
+        uint32_t extraPolls;     ///< Additional status polls required by misses
+        uint64_t totalLatency_us;///< Sum of TM_M-to-result latency (divide by measurements for average)
+        uint32_t maxLatency_us;  ///< Worst TM_M-to-result latency observed
+        uint32_t batchWait_us;   ///< Current in-batch wait from TM_M to the read (0 until first use; see BatchConversionWait_us)
+        uint32_t batchMisses;    ///< Batched conversions found incomplete (each redoes its measurement unbatched)
+    };
+    static const uint32_t FirstPollTargetMissRatio = 64; ///< aim for 1 in 64 first polls to find conversion incomplete
+    static const uint32_t BatchTargetMissRatio = 512;    ///< ...and far fewer batched reads, as a miss costs the whole batch
+    bool adaptiveTiming = true; ///< false: always wait the fixed datasheet time (uSecPerMeasurement)
+    const ConversionTiming_T &GetConversionTiming(Bandwidth_T bw, bool autoSR) const {
+        return conversionTiming[TimingIndex(bw, autoSR)];
+    }
+
+    /// Bandwidth for subsequent one-shot measurements (continuous mode: see StartContinuousMode)
+    void SetBandwidth(Bandwidth_T bw) {
+        if(bw != GetBandwidth()) ForgetOffset(); // offset is measured per bandwidth
+        WriteControlSetting(ControlRegister::Control_1, (uint8_t)Control_1_Mask::Setting_Bandwidth, (uint8_t)bw); // bw is low-order 2 bits
+    }
+    Bandwidth_T GetBandwidth(void) const {
+        return (Bandwidth_T)(control_settings[1] & (int)Control_1_Mask::Setting_Bandwidth); // bw is low-order 2 bits
+    };
+    bool InAutoSRmode() const {
+        return (control_settings[0] & (uint8_t)Control_0_Mask::Setting_Auto_SR_en) != 0;
+    }
+    /// Datasheet time for one conversion (Auto-SR: the pair of conversions plus SET/RESET)
+    static int NominalConversion_us(Bandwidth_T bw, bool autoSR) {
+        static const int usecGivenBandwidth[4] = { 8000, 4000, 2000, 500 }; // times for a single measurement
+        int usec = usecGivenBandwidth[(int)bw];
+        if(autoSR) {
+            usec = usec*2 +1000; // AutoSR mode makes two measurements, and needs additional 1msec for SET-RESET
+        }
+        return usec;
+    }
+
+    /// Register-IO trace: if set, every register byte read or written is recorded here
+    /// (nullptr costs one test per transaction). Drain it from another thread or write it to a file.
+    MMC5983MA_Trace_C *registerTrace = nullptr;
+    /// Render a trace record using RegisterName(), ie "get_reg 08 Device status => 11 @1234"
+    static int FormatTraceRecord(char *buf, size_t size, const MMC5983MA_TraceRecord_T &r) {
+        return MMC5983MA_Trace_C::Format(buf, size, r, [](uint8_t reg) { return RegisterName((Register)reg); });
+    }
 
   protected:
 
@@ -307,24 +558,39 @@ class MMC5983MA_C {
         // Write value to the sensor, presumably just one Action bit in the mask
         set_reg((Register)controlReg, actionMask | setting);
     }
-    void SetBandwidth(Bandwidth_T bw) {
-        WriteControlSetting(ControlRegister::Control_1, (uint8_t)Control_1_Mask::Setting_Bandwidth, (uint8_t)bw); // bw is low-order 2 bits
-    }
-    Bandwidth_T GetBandwidth(void) const {
-        return (Bandwidth_T)(control_settings[1] & (int)Control_1_Mask::Setting_Bandwidth); // bw is low-order 2 bits
+    int uSecPerMeasurement(void) const {
+        // For current mode, how much time does a measurement take (per datasheet)?
+        return NominalConversion_us(GetBandwidth(), InAutoSRmode());
     };
-    bool InAutoSRmode() const {
-        return (control_settings[0] & (uint8_t)Control_0_Mask::Setting_Auto_SR_en) != 0;
+    static int TimingIndex(Bandwidth_T bw, bool autoSR) { return (int)bw | (autoSR ? 4 : 0); };
+    ConversionTiming_T conversionTiming[8] = {}; ///< indexed by TimingIndex()
+    /// Learned (or datasheet) delay before first completion poll for the current setting
+    uint32_t FirstPollDelay_us() {
+        ConversionTiming_T &timing = conversionTiming[TimingIndex(GetBandwidth(), InAutoSRmode())];
+        if(timing.firstPoll_us == 0) timing.firstPoll_us = (uint32_t)uSecPerMeasurement(); // seed from datasheet
+        return adaptiveTiming ? timing.firstPoll_us : (uint32_t)uSecPerMeasurement();
     }
-    int uSecPerMeasurement(void) const {
-        // For current mode, how much time does a measurement take?
-        static const int usecGivenBandwidth[4] = { 8000, 4000, 2000, 500 }; // times for a single measurement
-        int usec = usecGivenBandwidth[(int)GetBandwidth()];
-        if(InAutoSRmode()) {
-            usec = usec*2 +1; // AutoSR mode makes two measurements, and needs additional 1msec for SET-RESET
+    /// Update learned timing after a one-shot measurement completed
+    /// (adapt false: completion was signalled by INT, so only record the latency)
+    void LearnConversionTiming(bool firstPollHit, uint32_t extraPolls, uint32_t latency_us, bool adapt = true) {
+        ConversionTiming_T &timing = conversionTiming[TimingIndex(GetBandwidth(), InAutoSRmode())];
+        uint32_t nominal = (uint32_t)uSecPerMeasurement();
+        timing.measurements++;
+        timing.extraPolls += extraPolls;
+        timing.totalLatency_us += latency_us;
+        if(latency_us > timing.maxLatency_us) timing.maxLatency_us = latency_us;
+        if(!adaptiveTiming || !adapt) return;
+        uint32_t step = nominal/2048 ? nominal/2048 : 1; // a miss costs 63 steps, ~3% of nominal
+        if(firstPollHit) {
+            timing.firstPollHits++;
+            timing.firstPoll_us -= step; // try a bit earlier next time
+        } else {
+            timing.firstPoll_us += step*(FirstPollTargetMissRatio-1);
         }
-        return usec;
-    };
+        // Never stray far from datasheet timing (protects against a burst of bus delays)
+        if(timing.firstPoll_us < nominal/4) timing.firstPoll_us = nominal/4;
+        if(timing.firstPoll_us > nominal*2) timing.firstPoll_us = nominal*2;
+    }
 
     /// Set Continuous mode (0 off, 1-7 per datasheet)
     void SetContinuousMode(uint8_t cm) {
@@ -333,8 +599,237 @@ class MMC5983MA_C {
         WriteControlSetting(ControlRegister::Control_2,
             (uint8_t)Control_2_Mask::Setting_ContinuousModeEnable | (uint8_t)Control_2_Mask::Setting_ContinuousModeRate, cm);
     }
-    bool InContinuousMode() const {
-        return (control_settings[2] & (uint8_t)Control_2_Mask::Setting_ContinuousModeEnable)!=0;
+
+    // Transaction batching (only if TDEVICE::SupportsBatching): while batchOpen, get_regs, set_regs,
+    // and Delay_us queue their operation; reads are filled in when FlushBatch executes the batch.
+    bool batchOpen = false;
+    /// Batched operations awaiting FlushBatch, in order, for registerTrace:
+    /// writes keep their byte, reads point to where FlushBatch leaves the data.
+    struct BatchTrace_T { uint8_t reg; uint8_t value; const uint8_t *data; uint32_t len; } batchTrace[16];
+    uint32_t batchTraceCount = 0;
+    void BeginBatch() {
+        static_assert(TDEVICE::SupportsBatching, "TDEVICE does not implement batching");
+        assert(!batchOpen);
+        dev.BeginBatch();
+        batchOpen = true;
+        batchTraceCount = 0;
+    }
+    void TraceBatched(uint8_t reg, uint8_t value, const uint8_t *readData, uint32_t len) {
+        if(registerTrace == nullptr) return;
+        assert(batchTraceCount < sizeof(batchTrace)/sizeof(batchTrace[0]));
+        if(batchTraceCount < sizeof(batchTrace)/sizeof(batchTrace[0]))
+            batchTrace[batchTraceCount++] = { reg, value, readData, len };
+    }
+    void TraceTransaction(uint8_t reg, const uint8_t *data, uint32_t len, MMC5983MA_TraceRecord_T::Direction_T dir, uint8_t status) {
+        uint64_t now_us = dev.time_us();
+        for(uint32_t idx=0; idx<len; idx++)
+            registerTrace->Record(now_us, (uint8_t)(reg+idx), data[idx], dir, status);
+    }
+    /// Execute the queued batch; returns false on IO failure
+    bool FlushBatch() {
+        assert(batchOpen);
+        batchOpen = false;
+        busStats.batchFlushes++;
+        bool ok = dev.FlushBatch();
+        if(!ok) busStats.ioFailures++;
+        if(registerTrace) {
+            uint8_t status = MMC5983MA_TraceRecord_T::Batched | (ok ? 0 : MMC5983MA_TraceRecord_T::Failed);
+            for(uint32_t i=0; i<batchTraceCount; i++) {
+                const BatchTrace_T &op = batchTrace[i];
+                if(op.data) TraceTransaction(op.reg, op.data, op.len, MMC5983MA_TraceRecord_T::Read, status);
+                else        TraceTransaction(op.reg, &op.value, 1, MMC5983MA_TraceRecord_T::Write, status);
+            }
+        }
+        return ok;
+    }
+    /// Delay, or queue the delay if a batch is open
+    void Delay_us(uint32_t uSecs) {
+        if constexpr (TDEVICE::SupportsBatching) {
+            if(batchOpen) { dev.QueueDelay_us(uSecs); return; }
+        }
+        dev.delay_us(uSecs);
+    }
+    /// Within a batch the read after the conversion wait is the only poll, and a conversion found incomplete
+    /// redoes the whole measurement unbatched (busStats.batchFallbacks), so batches wait their own learned time,
+    /// tuned like firstPoll_us but for BatchTargetMissRatio. It starts at datasheet time plus 1/16 and may
+    /// settle below datasheet time; BatchedConversionComplete learns from each batch's Status byte.
+    uint32_t BatchConversionWait_us() {
+        ConversionTiming_T &timing = conversionTiming[TimingIndex(GetBandwidth(), InAutoSRmode())];
+        uint32_t nominal = (uint32_t)uSecPerMeasurement();
+        if(timing.batchWait_us == 0) timing.batchWait_us = nominal + nominal/16; // seed from datasheet
+        return adaptiveTiming ? timing.batchWait_us : nominal + nominal/16;
+    }
+    /// How long to wait for INT before giving up on a conversion
+    uint32_t DataReadyTimeout_us() const { return (uint32_t)uSecPerMeasurement()*2 + 4000; }
+    /// Queue TM_M, conversion wait, and 9-byte result read; rawBytes valid after FlushBatch.
+    /// With the data-ready interrupt the adapter waits for INT instead of a fixed time (see WriteStartConversion).
+    /// Returns the queued wait (0 if INT ends it), for BatchedConversionComplete.
+    uint32_t QueueMeasureOneTime(uint8_t (&rawBytes)[9]) {
+        WriteStartConversion();
+        bool waitsForINT = false;
+        if constexpr (TDEVICE::SupportsDataReady) {
+            if(UsingDataReadyInterrupt()) waitsForINT = dev.QueueWaitDataReady(DataReadyTimeout_us());
+        }
+        uint32_t wait_us = waitsForINT ? 0 : BatchConversionWait_us();
+        if(!waitsForINT) Delay_us(wait_us);
+        get_regs(Register::X_out_0, rawBytes, sizeof(rawBytes)); // 0x00-0x08
+        return wait_us;
+    }
+    static bool RawMeasurementComplete(const uint8_t (&rawBytes)[9]) {
+        return (rawBytes[(int)Register::Status] & (uint8_t)StatusMask::Meas_M_Done) != 0;
+    }
+    /// Was a batched conversion complete when read? The Status byte read back is that conversion's
+    /// only poll, after wait_us (QueueMeasureOneTime), so adapt batchWait_us from it as LearnConversionTiming
+    /// adapts firstPoll_us (which batches don't use, so leave alone).
+    bool BatchedConversionComplete(const uint8_t (&rawBytes)[9], uint32_t wait_us) {
+        bool complete = RawMeasurementComplete(rawBytes);
+        if(!wait_us) return complete; // INT ended the wait
+        if(complete) LearnConversionTiming(true, 0, wait_us, false); // statistics (a miss is counted when redone)
+        ConversionTiming_T &timing = conversionTiming[TimingIndex(GetBandwidth(), InAutoSRmode())];
+        if(!complete) timing.batchMisses++;
+        if(!adaptiveTiming) return complete;
+        uint32_t nominal = (uint32_t)uSecPerMeasurement();
+        uint32_t step = nominal/4096 ? nominal/4096 : 1; // a miss costs 511 steps, ~1/8 of nominal
+        if(complete) timing.batchWait_us -= step;
+        else timing.batchWait_us += step*(BatchTargetMissRatio-1);
+        if(timing.batchWait_us < nominal/4) timing.batchWait_us = nominal/4;
+        if(timing.batchWait_us > nominal*2) timing.batchWait_us = nominal*2;
+        return complete;
+    }
+    /// RESET, measure, SET, measure as one batch. Returns 1 on success, 0 if a conversion
+    /// was not complete when read (caller must redo unbatched), -1 on IO failure.
+    int8_t MeasureResetSetBatched(uint32_t (&resultAfter_RESET)[3], uint32_t (&resultAfter_SET)[3]) {
+        uint8_t rawAfter_RESET[9], rawAfter_SET[9];
+        BeginBatch();
+        WriteControlSetting(ControlRegister::Control_0, (uint8_t)Control_0_Mask::Setting_Auto_SR_en, 0);
+        RESET();
+        uint32_t wait_us = QueueMeasureOneTime(rawAfter_RESET);
+        SET();
+        QueueMeasureOneTime(rawAfter_SET);
+        if(!FlushBatch()) return -1;
+        bool completeAfter_RESET = BatchedConversionComplete(rawAfter_RESET, wait_us);
+        bool completeAfter_SET = BatchedConversionComplete(rawAfter_SET, wait_us);
+        if(!completeAfter_RESET || !completeAfter_SET) {
+            busStats.batchFallbacks++;
+            return 0;
+        }
+        DecodeXYZ(rawAfter_RESET, resultAfter_RESET);
+        DecodeXYZ(rawAfter_SET, resultAfter_SET);
+        return 1;
+    }
+    /// Single measurement (AutoSR, or plain conversion in the present SET/RESET polarity) as one batch;
+    /// same return values as MeasureResetSetBatched.
+    int8_t MeasureOneTimeBatched(uint32_t (&result)[3], bool autoSR) {
+        uint8_t rawBytes[9];
+        BeginBatch();
+        WriteControlSetting(ControlRegister::Control_0, (uint8_t)Control_0_Mask::Setting_Auto_SR_en, autoSR ? (uint8_t)Control_0_Mask::Setting_Auto_SR_en : 0);
+        uint32_t wait_us = QueueMeasureOneTime(rawBytes);
+        if(!FlushBatch()) return -1;
+        if(!BatchedConversionComplete(rawBytes, wait_us)) {
+            busStats.batchFallbacks++;
+            return 0;
+        }
+        DecodeXYZ(rawBytes, result);
+        return 1;
+    }
+
+    /// One timestamped conversion for the motion-compensated modes
+    struct PolarityReading_T {
+        uint32_t raw[3];
+        uint64_t time_us;  ///< when TM_M was issued (dev.time_us)
+        bool afterSET;     ///< polarity: true after SET (+H + offset), false after RESET (-H + offset)
+    };
+    PolarityReading_T alternation[2];  ///< Measure_XYZ_Field_Alternating's previous two conversions, oldest first
+    uint32_t alternationCount = 0;     ///< valid entries in alternation
+    /// Discard cached offset and alternation history (bandwidth or mode changed)
+    void ForgetOffset() {
+        offsetTracking.valid = false;
+        alternationCount = 0;
+    }
+    /// Linear interpolation of readings a and b (same polarity) to time t
+    static void InterpolateReading(const PolarityReading_T &a, const PolarityReading_T &b, uint64_t t, uint32_t (&result)[3]) {
+        int64_t span = (int64_t)(b.time_us - a.time_us);
+        int64_t at = (int64_t)(t - a.time_us);
+        for(int chIdx=0; chIdx<3; chIdx++) {
+            int64_t delta = (int64_t)b.raw[chIdx] - (int64_t)a.raw[chIdx];
+            result[chIdx] = span > 0 ? (uint32_t)((int64_t)a.raw[chIdx] + (delta*at + span/2)/span)
+                                     : (uint32_t)(((int64_t)a.raw[chIdx] + (int64_t)b.raw[chIdx])/2);
+        }
+    }
+    /// Compute field member from an Auto-SR reading (offset unknown, so 0)
+    void FieldFromAutoSR(const uint32_t (&autoSR_result)[3]) {
+        ForgetOffset(); // AutoSR leaves the sensor in unknown SET/RESET polarity
+        for(int chIdx=0; chIdx<3; chIdx++) {
+            offset[chIdx] = 0; // the offset value is not available when using Auto-SR
+            // MEMSIC support re AutoSR mode function:
+            //   SET, Sample1, RESET, Sample2, Output=(Sample1-Sample2)/2.
+            // That is wrong: The 0-field value is 0x20000
+            field [chIdx] = (int32_t)autoSR_result[chIdx] - 0x20000; // Auto-SR value is centered around 0x2000
+        }
+        memcpy(lastRaw, autoSR_result, sizeof(lastRaw));
+    }
+    uint64_t splitConversionStart_us = 0; ///< StartConversion time, for PollConversion's timing statistics and timeout
+    uint32_t splitConversionPolls = 0;    ///< PollConversion misses since StartConversion
+    enum class AsyncStep_T : uint8_t { // StartMeasurement/PollMeasurement: next step to perform
+        Idle,
+        PulseRESET, ConvertRESET, PollRESET, PulseSET, ConvertSET, PollSET, // MeasurementMode_T::ResetSet
+        ConvertAutoSR, PollAutoSR,                                          // MeasurementMode_T::AutoSR
+    };
+    AsyncStep_T asyncStep = AsyncStep_T::Idle;
+    MeasurementMode_T asyncMode = MeasurementMode_T::ResetSet;
+    uint64_t asyncDue_us = 0;
+    uint64_t asyncStart_us = 0;
+    BusStatistics_T asyncBusStats = {}; ///< busStats at StartMeasurement
+    uint32_t asyncAfterRESET[3] = {};
+    MMC5983MA_Sample_T lastSample = {};
+    uint32_t sampleSequence = 0;
+    uint32_t lastRaw[3] = {};   ///< field-polarity conversion behind field (MMC5983MA_Sample_T::raw)
+    /// Fill lastSample from the measurement that began at start_us (busStats then: before) and returned rslt
+    const MMC5983MA_Sample_T &RecordSample(MeasurementMode_T mode, uint64_t start_us, int8_t rslt, const BusStatistics_T &before);
+    /// Compute field and offset members from SET and RESET readings of the same instant
+    void FieldFromSetReset(const uint32_t (&resultAfter_SET)[3], const uint32_t (&resultAfter_RESET)[3]) {
+        for(int chIdx=0; chIdx<3; chIdx++) {
+            if(chIdx>0 && dev.UsesSPI()) {
+                // Work-around MMC5983MA bug: With SPI interface, RESET only works on X channel
+                offset[chIdx] = 0x20000; // With this bug, best we can do is use nominal 0 value...
+                field [chIdx] = (int32_t)resultAfter_SET[chIdx] - 0x20000;
+            } else {
+                offset[chIdx] = (         resultAfter_SET[chIdx] +          resultAfter_RESET[chIdx])/2;
+                field [chIdx] = ((int32_t)resultAfter_SET[chIdx] - (int32_t)resultAfter_RESET[chIdx])/2;
+            }
+        }
+        memcpy(lastRaw, resultAfter_SET, sizeof(lastRaw));
+    }
+    /// SET or RESET, then one timestamped conversion (batched when possible); returns false on IO failure.
+    /// Leaves the sensor in the new polarity, so the cached offset is no longer usable.
+    bool MeasureAfterPulse(bool set, PolarityReading_T &reading) {
+        offsetTracking.valid = false;
+        reading.afterSET = set;
+        bool done = false;
+        if constexpr (TDEVICE::SupportsBatching) {
+            uint8_t rawBytes[9];
+            uint64_t start_us = dev.time_us();
+            BeginBatch();
+            WriteControlSetting(ControlRegister::Control_0, (uint8_t)Control_0_Mask::Setting_Auto_SR_en, 0);
+            if(set) SET(); else RESET();
+            uint32_t wait_us = QueueMeasureOneTime(rawBytes);
+            if(!FlushBatch()) return false;
+            if(BatchedConversionComplete(rawBytes, wait_us)) {
+                DecodeXYZ(rawBytes, reading.raw);
+                reading.time_us = start_us + RequiredWaitAfterMagnetizePulse_uSec; // TM_M follows the pulse wait
+                done = true;
+            } else {
+                busStats.batchFallbacks++;
+            }
+        }
+        if(!done) {
+            WriteControlSetting(ControlRegister::Control_0, (uint8_t)Control_0_Mask::Setting_Auto_SR_en, 0);
+            if(set) SET(); else RESET();
+            uint32_t failures = busStats.ioFailures;
+            reading.time_us = dev.time_us();
+            if(!MeasureOneTime(reading.raw) || busStats.ioFailures != failures) return false;
+        }
+        return true;
     }
 
     /// Read one or more sequential registers
@@ -360,14 +855,14 @@ class MMC5983MA_C {
     {
         assert(!InContinuousMode());
         WriteControlAction(ControlRegister::Control_0, (uint8_t)Control_0_Mask::Action_SET);
-        dev.delay_us(RequiredWaitAfterMagnetizePulse_uSec);
+        Delay_us(RequiredWaitAfterMagnetizePulse_uSec);
     }
     /// Perform RESET including required wait.
     inline void RESET(void)
     {
         assert(!InContinuousMode());
         WriteControlAction(ControlRegister::Control_0, (uint8_t)Control_0_Mask::Action_REVERSE_SET);
-        dev.delay_us(RequiredWaitAfterMagnetizePulse_uSec);
+        Delay_us(RequiredWaitAfterMagnetizePulse_uSec);
     }
 
     /// Is measurement complete?
@@ -382,6 +877,20 @@ class MMC5983MA_C {
     inline void Fetch_XYZ(uint32_t (&result)[3]) {
         uint8_t rawBytes[7];
         get_regs(Register::X_out_0, rawBytes, sizeof(rawBytes)); // 7 sequential field measurement bytes
+        DecodeXYZ(rawBytes, result);
+    }
+    /// Poll-and-fetch: read XYZ result and Status in ONE bus transaction.
+    /// Registers 0x00-0x08 (X,Y,Z,XYZ_out_2,T_out,Status) are contiguous, so a 9-byte read
+    /// replaces separate MeasurementIsComplete() and Fetch_XYZ() round-trips.
+    /// Always decodes result; returns true if Meas_M_Done was set (result is new).
+    inline bool FetchIfComplete(uint32_t (&result)[3]) {
+        uint8_t rawBytes[9];
+        get_regs(Register::X_out_0, rawBytes, sizeof(rawBytes)); // 0x00-0x08
+        DecodeXYZ(rawBytes, result);
+        return (rawBytes[(int)Register::Status] & (uint8_t)StatusMask::Meas_M_Done) != 0;
+    }
+    /// Assemble 3 unsigned 18-bit values from output registers 0x00-0x06
+    static inline void DecodeXYZ(const uint8_t (&rawBytes)[7], uint32_t (&result)[3]) {
         result[0] =  ((uint32_t)rawBytes[0] << 10) |
                      ((uint32_t)rawBytes[1] <<  2) |
                     (((uint32_t)rawBytes[6] & 0xC0u) >> 6) ;
@@ -392,27 +901,68 @@ class MMC5983MA_C {
                      ((uint32_t)rawBytes[5] <<  2) |
                     (((uint32_t)rawBytes[6] & 0x0Cu) >> 2) ;
     }
+    static inline void DecodeXYZ(const uint8_t (&rawBytes)[9], uint32_t (&result)[3]) {
+        DecodeXYZ(reinterpret_cast<const uint8_t (&)[7]>(rawBytes), result);
+    }
 
-    /// Make one measurement, then read XYZ results (returns 3 unsigned 18-bit quantities)
-    inline void MeasureOneTime(uint32_t (&result)[3])
-    {
-        #ifndef MMC5983MA_CONTINUOUS_MODE
-            assert(!InContinuousMode());
-            // Initiate Magnetic Measurement
+    /// Clear Meas_M_Done so the next completed measurement can be recognized.
+    /// Continuous mode has no TM_M, so it clears after each fetch; one-shot conversions clear in WriteStartConversion.
+    inline void ClearMeasurementComplete() {
+        set_reg(Register::Status, (uint8_t)StatusMask::Meas_M_Done); // write-1-to-clear
+    }
+    /// Start a one-shot conversion (TM_M). Waiting for INT, Meas_M_Done is cleared in the same write
+    /// (Status 0x08 and Control 0 0x09 are contiguous) so INT is low until this conversion ends, even on a
+    /// part that holds it until the clear rather than dropping it at TM_M; that costs a byte, not a transaction.
+    inline void WriteStartConversion() {
+        if(!UsingDataReadyInterrupt()) {
             WriteControlAction(ControlRegister::Control_0, (uint8_t)Control_0_Mask::Action_TM_M);
-            // Wait for measurement complete
-            int usec = uSecPerMeasurement(); // 8msec for 100Hz bandwidth, rarely measurement not complete !
-            int tries=0;
-            for(; tries<5; tries++) {
-                dev.delay_us(usec);
-                if(MeasurementIsComplete()) break; // measurement finished =>
-                usec = 1000; // wait another millisecond and try again...
-            }
-            assert(MeasurementIsComplete());
-        #else
-            #error MMC5983MA_CONTINUOUS_MODE not implemented in MeasureOneTime
-        #endif // #ifndef MMC5983MA_CONTINUOUS_MODE
-        Fetch_XYZ(result);
+            return;
+        }
+        const uint8_t clearAndStart[2] = { (uint8_t)StatusMask::Meas_M_Done, // write-1-to-clear
+            (uint8_t)((uint8_t)Control_0_Mask::Action_TM_M | GetSettingRef(ControlRegister::Control_0)) };
+        set_regs(Register::Status, clearAndStart, sizeof(clearAndStart));
+    }
+
+    /// Make one measurement, then read XYZ results (returns 3 unsigned 18-bit quantities).
+    /// Returns false if any transaction failed (not just the last: some adapters' IO_OK only reports that)
+    /// or the conversion never completed (counted in busStats.conversionTimeouts); result is then not valid.
+    inline bool MeasureOneTime(uint32_t (&result)[3])
+    {
+        assert(!InContinuousMode()); // continuous mode delivers results via ServiceContinuousMode
+        uint32_t failures = busStats.ioFailures;
+        // Initiate Magnetic Measurement
+        WriteStartConversion();
+        uint64_t start_us = dev.time_us();
+        bool onInterrupt = false;
+        if constexpr (TDEVICE::SupportsDataReady) onInterrupt = UsingDataReadyInterrupt();
+        bool complete = false;
+        if(onInterrupt) {
+            // Sensor raises INT when the conversion ends: fetch then, no sleep or status polls
+            if(dev.WaitDataReady(DataReadyTimeout_us())) complete = FetchIfComplete(result);
+            if(!complete) busStats.dataReadyTimeouts++;
+        } else {
+            // Wait for measurement complete; each poll also fetches the result (one bus transaction).
+            // First poll is scheduled just after this part's typical completion (learned, see ConversionTiming_T).
+            dev.delay_us(FirstPollDelay_us());
+            complete = FetchIfComplete(result);
+        }
+        bool firstPollHit = complete;
+        // Rarely not yet complete (but should be very close): retry in short steps,
+        // giving up after another nominal conversion time plus 4ms (or at once if the bus is failing)
+        uint32_t retry_us = ConversionRetry_us();
+        uint32_t extraPolls = 0;
+        for(uint32_t waited_us = 0; !complete && busStats.ioFailures == failures && waited_us < (uint32_t)uSecPerMeasurement()+4000; waited_us += retry_us) {
+            dev.delay_us(retry_us);
+            complete = FetchIfComplete(result); // measurement finished =>
+            extraPolls++;
+        }
+        if(busStats.ioFailures != failures) return false; // Status (or result) read back is not trustworthy
+        if(!complete) {
+            busStats.conversionTimeouts++;
+            return false;
+        }
+        LearnConversionTiming(firstPollHit, extraPolls, (uint32_t)(dev.time_us() - start_us), !onInterrupt);
+        return true;
     }
 };
 
@@ -427,28 +977,13 @@ int8_t MMC5983MA_C<TDEVICE>::Init()
         // Get chip into known state (needed when not immediately following a power-cycle) - SW reset
         WriteControlAction(ControlRegister::Control_1, (uint8_t)Control_1_Mask::Action_SW_RST);
         memset(control_settings,0,sizeof(control_settings)); // set local copy of control registers to default
-        #ifdef MMC5983MA_PRINT_DETAILED_LOG
-            dev.DiagPrintf("Wait >10mSec after reset\n");
-        #endif
         dev.delay_us(20000); // Minimum 10msec required after reset
         // Read and validate chip ID
         rslt = get_reg(Register::Product_ID, chip_id_read);
         if (rslt != 0) break;
         if (chip_id_read != Product_ID_Assigned) return -1;
         SetBandwidth(Bandwidth_T::Bandwidth_00_100Hz);
-        #ifdef MMC5983MA_CONTINUOUS_MODE
-            // Example from MEMSIC uses Auto_SR, BW00, CM_FREQ_50HZ:
-            SetBandwidth(Bandwidth_T::Bandwidth_00_100Hz);
-            WriteControlSetting(ControlRegister::Control_0, (uint8_t)Control_0_Mask::Setting_Auto_SR_en, (uint8_t)Control_0_Mask::Setting_Auto_SR_en);
-            SetContinuousMode(4/*nominal 50Hz*/);
-          #if 0 // Initial try
-            WriteControlSetting(ControlRegister::Control_2,
-                (uint8_t)Control_2_Mask::Setting_ContinuousModeRate | (uint8_t)Control_2_Mask::Setting_ContinuousModeEnable,
-                (uint8_t)0x04/*50Hz @ BW=00*/                       | (uint8_t)Control_2_Mask::Setting_ContinuousModeEnable);
-            // ??? Not required for continuous mode? Initiate Magnetic Measurement
-            WriteControlAction(ControlRegister::Control_0, (uint8_t)Control_0_Mask::Action_TM_M);
-          #endif
-        #endif
+        ForgetOffset();
         initialized = true;
     } while(0);
     return rslt;
@@ -458,86 +993,429 @@ template <typename TDEVICE>
 int8_t MMC5983MA_C<TDEVICE>::get_regs(Register reg, uint8_t (&reg_data)[], uint32_t len)
 {
     int8_t rslt = 0; // BMP5_OK;
+    busStats.readTransactions++;
+    busStats.bytesRead += len;
+    if constexpr (TDEVICE::SupportsBatching) {
+        if(batchOpen) { // data arrives when the batch is flushed
+            dev.QueueRead((uint8_t)reg, reg_data, len);
+            TraceBatched((uint8_t)reg, 0, reg_data, len);
+            return 0;
+        }
+    }
     dev.read((uint8_t)reg, reg_data, len);
-    #ifdef MMC5983MA_PRINT_DETAILED_LOG
-        for(uint8_t idx=0; idx<len; idx++) {
-            uint8_t regn = (uint8_t)reg+idx;
-            dev.DiagPrintf("get_reg %02x %s => %02x\n", regn, RegisterName((Register)regn), reg_data[idx]);
-        };
-    #endif
     if (!dev.IO_OK())
     {
         rslt = -1; // BMP5_E_COM_FAIL;
+        busStats.ioFailures++;
     }
+    if(registerTrace)
+        TraceTransaction((uint8_t)reg, reg_data, len, MMC5983MA_TraceRecord_T::Read, rslt ? MMC5983MA_TraceRecord_T::Failed : 0);
     return rslt;
 }
 
 template <typename TDEVICE>
 int8_t MMC5983MA_C<TDEVICE>::set_regs(Register reg, const uint8_t (&reg_data)[], uint32_t len)
 {
-    #ifdef MMC5983MA_PRINT_DETAILED_LOG
-        for(uint8_t idx=0; idx<len; idx++) {
-            uint8_t regn = (uint8_t)reg+idx;
-            dev.DiagPrintf("set_reg %02x %s <= %02x\n", regn, RegisterName((Register)regn), reg_data[idx]);
-        };
-    #endif
     int8_t rslt = 0; // BMP5_OK;
+    busStats.writeTransactions++;
+    busStats.bytesWritten += len;
+    if constexpr (TDEVICE::SupportsBatching) {
+        if(batchOpen) {
+            dev.QueueWrite((uint8_t)reg, reg_data, len);
+            for(uint32_t idx=0; idx<len; idx++) TraceBatched((uint8_t)((uint8_t)reg+idx), reg_data[idx], nullptr, 1);
+            return 0;
+        }
+    }
     dev.write((uint8_t)reg, reg_data, len);
     if (!dev.IO_OK())
     {
         rslt = -1; // BMP5_E_COM_FAIL;
+        busStats.ioFailures++;
     }
+    if(registerTrace)
+        TraceTransaction((uint8_t)reg, reg_data, len, MMC5983MA_TraceRecord_T::Write, rslt ? MMC5983MA_TraceRecord_T::Failed : 0);
     return rslt;
 }
 
 template <typename TDEVICE>
 int8_t MMC5983MA_C<TDEVICE>::Measure_XYZ_Field_WithResetSet()
 {
-    #ifndef MMC5983MA_CONTINUOUS_MODE // RESET-SET don't make sense in continuous mode
+    if(InContinuousMode()) return -1; // RESET-SET don't make sense in continuous mode
+    uint32_t resultAfter_SET[3] = {0}, resultAfter_RESET[3] = {0};
+    int8_t batched = 0;
+    if constexpr (TDEVICE::SupportsBatching) {
+        batched = MeasureResetSetBatched(resultAfter_RESET, resultAfter_SET); // whole sequence in one round-trip
+        if(batched < 0) return -1;
+    }
+    if(!batched) {
+        uint32_t failures = busStats.ioFailures;
         // Make sure we're not in AutoSR mode before trying explicit SET-RESET
         WriteControlSetting(ControlRegister::Control_0, (uint8_t)Control_0_Mask::Setting_Auto_SR_en, 0);
-        uint32_t resultAfter_SET[3] = {0}, resultAfter_RESET[3] = {0};
         RESET(); // includes required post-pulse delay (nominal 500us, implemented 1msec), now reading ::= -H + Offset
-        MeasureOneTime(resultAfter_RESET);
+        if(!MeasureOneTime(resultAfter_RESET)) return -1;
         SET();   // includes required post-pulse delay (nominal 500us, implemented 1msec), now reading ::= +H + Offset
-        MeasureOneTime(resultAfter_SET);
-        // Compute offset (zero field value) and signed result for each sensor
-        for(int chIdx=0; chIdx<3; chIdx++) {
-            if(chIdx>0 && dev.UsesSPI()) {
-                // Work-around MMC5983MA bug: With SPI interface, RESET only works on X channel
-                offset[chIdx] = 0x20000; // With this bug, best we can do is use nominal 0 value...
-                field [chIdx] = (int32_t)resultAfter_SET[chIdx] - 0x20000;
-            } else {
-                offset[chIdx] = (         resultAfter_SET[chIdx] +          resultAfter_RESET[chIdx])/2;
-                field [chIdx] = ((int32_t)resultAfter_SET[chIdx] - (int32_t)resultAfter_RESET[chIdx])/2;
-            }
-        }
-    #else
-        uint32_t result[3] = {0};
-        MeasureOneTime(result);
-        // Compute offset (zero field value) and signed result for each sensor
-        for(int i=0; i<3; i++) {
-            offset[i] = 0x20000; // nominal center value 2^17
-            field [i] = (int32_t)result[i] - (int32_t)offset[i];
-        }
-    #endif
+        if(!MeasureOneTime(resultAfter_SET)) return -1;
+        if(busStats.ioFailures != failures) return -1; // ie the RESET or SET pulse
+    }
+    // Compute offset (zero field value) and signed result for each sensor
+    FieldFromSetReset(resultAfter_SET, resultAfter_RESET);
     return 0;
 }
 
 template <typename TDEVICE>
 int8_t MMC5983MA_C<TDEVICE>::Measure_XYZ_Field_WithAutoSR()
 {
-    WriteControlSetting(ControlRegister::Control_0, (uint8_t)Control_0_Mask::Setting_Auto_SR_en, (uint8_t)Control_0_Mask::Setting_Auto_SR_en);
+    if(InContinuousMode()) return -1; // use ServiceContinuousMode to collect continuous-mode results
     uint32_t autoSR_result[3] = {0};
-    MeasureOneTime(autoSR_result);
+    int8_t batched = 0;
+    if constexpr (TDEVICE::SupportsBatching) {
+        batched = MeasureOneTimeBatched(autoSR_result, true);
+        if(batched < 0) return -1;
+    }
+    if(!batched) {
+        uint32_t failures = busStats.ioFailures;
+        WriteControlSetting(ControlRegister::Control_0, (uint8_t)Control_0_Mask::Setting_Auto_SR_en, (uint8_t)Control_0_Mask::Setting_Auto_SR_en);
+        if(!MeasureOneTime(autoSR_result) || busStats.ioFailures != failures) return -1;
+    }
+    FieldFromAutoSR(autoSR_result);
+    return 0;
+}
+
+template <typename TDEVICE>
+int8_t MMC5983MA_C<TDEVICE>::StartPulse(bool set)
+{
+    if(InContinuousMode()) return -1;
+    WriteControlSetting(ControlRegister::Control_0, (uint8_t)Control_0_Mask::Setting_Auto_SR_en, 0);
+    WriteControlAction(ControlRegister::Control_0, set ? (uint8_t)Control_0_Mask::Action_SET : (uint8_t)Control_0_Mask::Action_REVERSE_SET);
+    ForgetOffset(); // polarity changed behind the cached offset's back
+    return dev.IO_OK() ? 0 : -1;
+}
+
+template <typename TDEVICE>
+int8_t MMC5983MA_C<TDEVICE>::StartConversion(bool autoSR)
+{
+    if(InContinuousMode()) return -1;
+    WriteControlSetting(ControlRegister::Control_0, (uint8_t)Control_0_Mask::Setting_Auto_SR_en, autoSR ? (uint8_t)Control_0_Mask::Setting_Auto_SR_en : 0);
+    WriteStartConversion();
+    splitConversionStart_us = dev.time_us();
+    splitConversionPolls = 0;
+    return dev.IO_OK() ? 0 : -1;
+}
+
+template <typename TDEVICE>
+int8_t MMC5983MA_C<TDEVICE>::PollConversion(uint32_t (&result)[3])
+{
+    bool complete = FetchIfComplete(result); // one bus read for status and data
+    if(!dev.IO_OK()) return -1;
+    if(!complete) {
+        if(dev.time_us() - splitConversionStart_us > DataReadyTimeout_us()) {
+            busStats.conversionTimeouts++;
+            return -1;
+        }
+        splitConversionPolls++;
+        return 0;
+    }
+    LearnConversionTiming(splitConversionPolls == 0, splitConversionPolls, (uint32_t)(dev.time_us() - splitConversionStart_us));
+    return 1;
+}
+
+template <typename TDEVICE>
+int8_t MMC5983MA_C<TDEVICE>::StartMeasurement(MeasurementMode_T mode)
+{
+    asyncStart_us = dev.time_us();
+    asyncBusStats = busStats;
+    asyncMode = mode;
+    if(mode != MeasurementMode_T::ResetSet && mode != MeasurementMode_T::AutoSR) {
+        asyncStep = AsyncStep_T::Idle;
+        RecordSample(mode, asyncStart_us, -1, asyncBusStats);
+        lastSample.flags |= MMC5983MA_Sample_T::NotAvailable;
+        return -1;
+    }
+    asyncStep = mode == MeasurementMode_T::AutoSR ? AsyncStep_T::ConvertAutoSR : AsyncStep_T::PulseRESET;
+    asyncDue_us = 0; // due now
+    return PollMeasurement() < 0 ? -1 : 0;
+}
+
+template <typename TDEVICE>
+int8_t MMC5983MA_C<TDEVICE>::PollMeasurement()
+{
+    if(asyncStep == AsyncStep_T::Idle) return -1;
+    uint64_t now = dev.time_us();
+    if(now < asyncDue_us) return 0;
+    uint32_t raw[3];
+    int8_t rslt = 0;
+    switch(asyncStep) {
+      case AsyncStep_T::PulseRESET:
+      case AsyncStep_T::PulseSET:
+        rslt = StartPulse(asyncStep == AsyncStep_T::PulseSET);
+        asyncStep = asyncStep == AsyncStep_T::PulseSET ? AsyncStep_T::ConvertSET : AsyncStep_T::ConvertRESET;
+        asyncDue_us = dev.time_us() + RequiredWaitAfterMagnetizePulse_uSec;
+        break;
+      case AsyncStep_T::ConvertRESET:
+      case AsyncStep_T::ConvertSET:
+      case AsyncStep_T::ConvertAutoSR:
+        rslt = StartConversion(asyncStep == AsyncStep_T::ConvertAutoSR);
+        asyncStep = (AsyncStep_T)((uint8_t)asyncStep + 1); // the matching Poll step
+        asyncDue_us = dev.time_us() + ConversionWait_us();
+        break;
+      case AsyncStep_T::PollRESET:
+      case AsyncStep_T::PollSET:
+      case AsyncStep_T::PollAutoSR:
+        rslt = PollConversion(raw);
+        if(rslt == 0) {
+            asyncDue_us = dev.time_us() + ConversionRetry_us();
+            break;
+        }
+        if(rslt < 0) break;
+        asyncDue_us = 0;
+        if(asyncStep == AsyncStep_T::PollRESET) {
+            memcpy(asyncAfterRESET, raw, sizeof(raw));
+            asyncStep = AsyncStep_T::PulseSET;
+            rslt = 0;
+            break;
+        }
+        if(asyncStep == AsyncStep_T::PollSET) SetFieldFromResetSet(asyncAfterRESET, raw);
+        else SetFieldFromAutoSR(raw);
+        asyncStep = AsyncStep_T::Idle;
+        RecordSample(asyncMode, asyncStart_us, 0, asyncBusStats);
+        return 1;
+      default:
+        break;
+    }
+    if(rslt < 0) {
+        asyncStep = AsyncStep_T::Idle;
+        RecordSample(asyncMode, asyncStart_us, -1, asyncBusStats);
+    }
+    return rslt;
+}
+
+template <typename TDEVICE>
+int8_t MMC5983MA_C<TDEVICE>::Measure_XYZ_Field_WithCachedOffset()
+{
+    if(InContinuousMode()) return -1;
+    OffsetTracking_T &ot = offsetTracking;
+    if(!ot.valid || ot.sinceRefresh >= ot.interval) {
+        // Refresh: full RESET/SET measurement, which also leaves the sensor SET for the cached samples
+        bool hadOffset = ot.valid; // interval expired (rather than invalidated): measure the drift
+        uint32_t previous[3];
+        memcpy(previous, offset, sizeof(previous));
+        if(Measure_XYZ_Field_WithResetSet() != 0) { ot.valid = false; return -1; }
+        ot.refreshes++;
+        ot.sinceRefresh = 0;
+        if(hadOffset) { // adapt the refresh interval to the observed drift
+            ot.lastDrift = 0;
+            for(int chIdx=0; chIdx<3; chIdx++) {
+                uint32_t drift = offset[chIdx] > previous[chIdx] ? offset[chIdx]-previous[chIdx] : previous[chIdx]-offset[chIdx];
+                if(drift > ot.lastDrift) ot.lastDrift = drift;
+            }
+            if(ot.lastDrift > ot.driftThreshold) {
+                ot.driftEvents++;
+                ot.interval /= 2;
+            } else if(ot.lastDrift < ot.driftThreshold/4) {
+                ot.interval *= 2;
+            }
+            if(ot.interval < ot.minInterval) ot.interval = ot.minInterval;
+            if(ot.interval > ot.maxInterval) ot.interval = ot.maxInterval;
+        }
+        ot.valid = true;
+        return 0;
+    }
+    // Cached: sensor is still SET (from the refresh), so one conversion reads +H + offset
+    uint32_t resultAfter_SET[3] = {0};
+    int8_t batched = 0;
+    if constexpr (TDEVICE::SupportsBatching) {
+        batched = MeasureOneTimeBatched(resultAfter_SET, false);
+        if(batched < 0) return -1;
+    }
+    if(!batched) {
+        uint32_t failures = busStats.ioFailures;
+        WriteControlSetting(ControlRegister::Control_0, (uint8_t)Control_0_Mask::Setting_Auto_SR_en, 0);
+        if(!MeasureOneTime(resultAfter_SET) || busStats.ioFailures != failures) return -1;
+    }
     for(int chIdx=0; chIdx<3; chIdx++) {
-        offset[chIdx] = 0; // the offset value is not available when using Auto-SR
-        // MEMSIC support re AutoSR mode function:
-        //   SET, Sample1, RESET, Sample2, Output=(Sample1-Sample2)/2.
-        // That is wrong: The 0-field value is 0x20000
-        field [chIdx] = (int32_t)autoSR_result[chIdx] - 0x20000; // Auto-SR value is centered around 0x2000
+        field[chIdx] = (int32_t)resultAfter_SET[chIdx] - (int32_t)offset[chIdx]; // SPI Y/Z: offset is nominal 0x20000
+    }
+    memcpy(lastRaw, resultAfter_SET, sizeof(lastRaw));
+    ot.sinceRefresh++;
+    ot.cachedSamples++;
+    return 0;
+}
+
+template <typename TDEVICE>
+int8_t MMC5983MA_C<TDEVICE>::Measure_XYZ_Field_WithResetSetReset()
+{
+    if(InContinuousMode()) return -1;
+    PolarityReading_T r0, s1, r2;
+    bool batched = false;
+    if constexpr (TDEVICE::SupportsBatching) {
+        // Whole sequence in one round-trip: identical steps, so the conversions are evenly spaced
+        uint8_t raw0[9], raw1[9], raw2[9];
+        offsetTracking.valid = false;
+        uint64_t start_us = dev.time_us();
+        BeginBatch();
+        WriteControlSetting(ControlRegister::Control_0, (uint8_t)Control_0_Mask::Setting_Auto_SR_en, 0);
+        uint32_t step_us = RequiredWaitAfterMagnetizePulse_uSec + BatchConversionWait_us();
+        RESET();
+        uint32_t wait_us = QueueMeasureOneTime(raw0);
+        SET();
+        QueueMeasureOneTime(raw1);
+        RESET();
+        QueueMeasureOneTime(raw2);
+        if(!FlushBatch()) return -1;
+        bool complete0 = BatchedConversionComplete(raw0, wait_us);
+        bool complete1 = BatchedConversionComplete(raw1, wait_us);
+        bool complete2 = BatchedConversionComplete(raw2, wait_us);
+        if(complete0 && complete1 && complete2) {
+            DecodeXYZ(raw0, r0.raw);
+            DecodeXYZ(raw1, s1.raw);
+            DecodeXYZ(raw2, r2.raw);
+            r0.time_us = start_us + RequiredWaitAfterMagnetizePulse_uSec;
+            s1.time_us = r0.time_us + step_us;
+            r2.time_us = s1.time_us + step_us;
+            batched = true;
+        } else {
+            busStats.batchFallbacks++;
+        }
+    }
+    if(!batched) {
+        if(!MeasureAfterPulse(false, r0) || !MeasureAfterPulse(true, s1) || !MeasureAfterPulse(false, r2)) return -1;
+    }
+    uint32_t resultAfter_RESET[3]; // RESET readings interpolated to the SET reading's instant
+    InterpolateReading(r0, r2, s1.time_us, resultAfter_RESET);
+    FieldFromSetReset(s1.raw, resultAfter_RESET);
+    fieldTime_us = s1.time_us;
+    return 0;
+}
+
+template <typename TDEVICE>
+int8_t MMC5983MA_C<TDEVICE>::Measure_XYZ_Field_Alternating()
+{
+    if(InContinuousMode()) return -1;
+    bool set = alternationCount ? !alternation[alternationCount-1].afterSET : true;
+    PolarityReading_T now;
+    if(!MeasureAfterPulse(set, now)) {
+        alternationCount = 0;
+        return -1;
     }
+    if(alternationCount < 2) {
+        alternation[alternationCount++] = now;
+        return 1; // need a reading on each side of the middle one
+    }
+    const PolarityReading_T &middle = alternation[1];
+    uint32_t opposite[3]; // readings either side of the middle one, interpolated to its instant
+    InterpolateReading(alternation[0], now, middle.time_us, opposite);
+    if(middle.afterSET) FieldFromSetReset(middle.raw, opposite);
+    else                FieldFromSetReset(opposite, middle.raw);
+    fieldTime_us = middle.time_us;
+    alternation[0] = alternation[1];
+    alternation[1] = now;
     return 0;
 }
 
+template <typename TDEVICE>
+MMC5983MA_Sample_T MMC5983MA_C<TDEVICE>::Measure(MeasurementMode_T mode)
+{
+    uint64_t start_us = dev.time_us();
+    BusStatistics_T before = busStats;
+    int8_t rslt = -1;
+    switch(mode) {
+      case MeasurementMode_T::ResetSet:      rslt = Measure_XYZ_Field_WithResetSet();     break;
+      case MeasurementMode_T::AutoSR:        rslt = Measure_XYZ_Field_WithAutoSR();       break;
+      case MeasurementMode_T::CachedOffset:  rslt = Measure_XYZ_Field_WithCachedOffset(); break;
+      case MeasurementMode_T::ResetSetReset: rslt = Measure_XYZ_Field_WithResetSetReset(); break;
+      case MeasurementMode_T::Alternating:   rslt = Measure_XYZ_Field_Alternating();      break;
+    }
+    return RecordSample(mode, start_us, rslt, before);
+}
+
+template <typename TDEVICE>
+const MMC5983MA_Sample_T &MMC5983MA_C<TDEVICE>::RecordSample(MeasurementMode_T mode, uint64_t start_us, int8_t rslt, const BusStatistics_T &before)
+{
+    MMC5983MA_Sample_T &s = lastSample;
+    s = {};
+    s.start_us = start_us;
+    s.end_us = dev.time_us();
+    s.sequence = sampleSequence++;
+    s.result = rslt;
+    s.mode = (uint8_t)mode;
+    s.bandwidth = (uint8_t)GetBandwidth();
+    if(busStats.dataReadyTimeouts != before.dataReadyTimeouts) s.flags |= MMC5983MA_Sample_T::DataReadyTimeout;
+    if(busStats.conversionTimeouts != before.conversionTimeouts) s.flags |= MMC5983MA_Sample_T::ConversionTimeout;
+    if(rslt < 0) {
+        if(!initialized || InContinuousMode()) s.flags |= MMC5983MA_Sample_T::NotAvailable;
+        else if(busStats.ioFailures != before.ioFailures || !(s.flags & MMC5983MA_Sample_T::ConversionTimeout))
+            s.flags |= MMC5983MA_Sample_T::IOFailure;
+        return s;
+    }
+    if(rslt > 0) {
+        s.flags |= MMC5983MA_Sample_T::Priming;
+        return s;
+    }
+    memcpy(s.raw, lastRaw, sizeof(s.raw));
+    memcpy(s.field, field, sizeof(s.field));
+    memcpy(s.offset, offset, sizeof(s.offset));
+    if(mode == MeasurementMode_T::AutoSR || dev.UsesSPI()) s.flags |= MMC5983MA_Sample_T::NominalOffset;
+    if(mode == MeasurementMode_T::ResetSetReset || mode == MeasurementMode_T::Alternating)
+        s.fieldAt_us = (int32_t)((int64_t)fieldTime_us - (int64_t)start_us);
+    return s;
+}
+
+template <typename TDEVICE>
+int8_t MMC5983MA_C<TDEVICE>::StartContinuousMode(ContinuousRate_T rate, Bandwidth_T bw, bool useAutoSR)
+{
+    // Datasheet: 200Hz needs BW>=01 (200Hz), 1000Hz needs BW=11 (800Hz)
+    if(rate == ContinuousRate_T::ContinuousRate_Off) return -1; // use StopContinuousMode
+    if(rate == ContinuousRate_T::ContinuousRate_200Hz  && bw == Bandwidth_T::Bandwidth_00_100Hz) return -1;
+    if(rate == ContinuousRate_T::ContinuousRate_1000Hz && bw != Bandwidth_T::Bandwidth_11_800Hz) return -1;
+    SetContinuousMode(0); // settings below can only be changed safely while stopped
+    SetBandwidth(bw);
+    WriteControlSetting(ControlRegister::Control_0, (uint8_t)Control_0_Mask::Setting_Auto_SR_en,
+        useAutoSR ? (uint8_t)Control_0_Mask::Setting_Auto_SR_en : 0);
+    ClearMeasurementComplete(); // discard any stale one-shot result
+    continuousSamples.Clear();
+    ForgetOffset();
+    SetContinuousMode((uint8_t)rate); // sensor now free-runs; no TM_M required
+    return dev.IO_OK() ? 0 : -1;
+}
+
+template <typename TDEVICE>
+int8_t MMC5983MA_C<TDEVICE>::EnableDataReadyInterrupt(bool enable)
+{
+    if constexpr (TDEVICE::SupportsDataReady) {
+        if(enable && !dev.DataReadyInit()) return -1;
+        WriteControlSetting(ControlRegister::Control_0, (uint8_t)Control_0_Mask::Setting_Enable_MeasurementDoneINT,
+            enable ? (uint8_t)Control_0_Mask::Setting_Enable_MeasurementDoneINT : 0);
+        ClearMeasurementComplete(); // INT low until the next conversion completes
+        return dev.IO_OK() ? 0 : -1;
+    } else {
+        return enable ? -1 : 0;
+    }
+}
+
+template <typename TDEVICE>
+int8_t MMC5983MA_C<TDEVICE>::StopContinuousMode()
+{
+    SetContinuousMode(0);
+    return dev.IO_OK() ? 0 : -1;
+}
+
+template <typename TDEVICE>
+int8_t MMC5983MA_C<TDEVICE>::ServiceContinuousMode()
+{
+    assert(InContinuousMode());
+    ContinuousSample_T sample;
+    if(!FetchIfComplete(sample.raw)) return dev.IO_OK() ? 0 : -1; // one bus read for status and data
+    sample.timestamp_us = dev.time_us();
+    ClearMeasurementComplete(); // so the next sample is recognized as new
+    if(!dev.IO_OK()) return -1;
+    sample.sequence = continuousSequence++;
+    for(int chIdx=0; chIdx<3; chIdx++) {
+        // AutoSR output is centered on 0x20000; otherwise use offset from the last RESET/SET measurement, if any.
+        uint32_t zero = (InAutoSRmode() || offset[chIdx]==0) ? 0x20000 : offset[chIdx];
+        sample.field[chIdx] = (int32_t)sample.raw[chIdx] - (int32_t)zero;
+    }
+    continuousSamples.Push(sample); // if full, sample is dropped and counted in continuousSamples.Overruns()
+    return 1;
+}
+
 #endif // MMC5983A_HPP_INCLUDED
@@ -0,0 +1,264 @@
+/// MMC5983MA_Acquisition.hpp - MMC5983MA_Acquisition_C class - measure on a worker thread, queue samples for the application.
+
+/*
+MIT License
+
+Copyright (c) 2023-2025 Dave Nadler
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef MMC5983MA_ACQUISITION_HPP_INCLUDED
+#define MMC5983MA_ACQUISITION_HPP_INCLUDED
+
+#include <stdint.h>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "MMC5983MA_Calibration.hpp"
+#include "MMC5983MA_Ring.hpp"
+#include "MMC5983MA_Scheduler.hpp"
+
+/// One acquisition cycle's result
+struct MMC5983MA_AcquiredSample_T {
+    uint64_t deadline_us;     ///< scheduled start of the cycle (steady clock, see MMC5983MA_PeriodicScheduler_C)
+    uint64_t time_us;         ///< actual time of the reading: start of a one-shot cycle, or when a continuous sample was fetched
+    uint32_t sequence;        ///< counts cycles, including any dropped because the queue was full
+    int8_t result;            ///< 0 if all measurements succeeded
+    uint8_t mode;             ///< MMC5983MA_Acquisition_C::Mode_T used
+    int32_t field[3];         ///< offset-corrected field (see MMC5983MA_C::field) from the RESET/SET, Auto-SR, or continuous measurement
+    uint32_t offset[3];       ///< RESET/SET offset (see MMC5983MA_C::offset), if the cycle measured or used one
+    int32_t fieldAutoSR[3];   ///< Auto-SR field, in mode ResetSetAndAutoSR
+    uint8_t calibration;      ///< MMC5983MA_EllipsoidCalibration_C::Model_T applied to calibrated_mG (None: not calibrated)
+    double calibrated_mG[3];  ///< field in mG, corrected by the published calibration (see SetCorrection), if result is 0
+};
+
+/// Runs an MMC5983MA_C (TCOMPASS) on its own thread: Init, then one acquisition cycle per period,
+/// each published to 'samples'. While running, the worker thread owns the compass; the application
+/// must not touch it until Stop() returns. The application drains 'samples' at its own pace (for a GUI,
+/// at display rate), so slow USB round-trips never stall the application, and a slow application
+/// doesn't stall acquisition (if it falls too far behind, samples are dropped and counted by the queue).
+/// Cycles start on drift-free deadlines (MMC5983MA_PeriodicScheduler_C); ChoosePlan picks the
+/// measurement mode and bandwidth that fit the period.
+template <typename TCOMPASS, size_t CAPACITY = 256>
+class MMC5983MA_Acquisition_C {
+  public:
+    typedef enum { Stopped, Starting, Running, Failed } State_T;
+    typedef enum : uint8_t {
+        ResetSetAndAutoSR, ///< one-shot RESET/SET measurement then one-shot Auto-SR measurement
+        ResetSet,          ///< one-shot RESET/SET measurement (field and offset)
+        AutoSR,            ///< one-shot Auto-SR measurement
+        Continuous,        ///< sensor free-runs (Auto-SR) at a rate at least 1/period; each cycle fetches one sample
+        CachedOffset,      ///< one-shot SET conversion with amortized RESET/SET offset (Measure_XYZ_Field_WithCachedOffset)
+    } Mode_T;
+    typedef typename TCOMPASS::Bandwidth_T Bandwidth_T;
+    typedef typename TCOMPASS::ContinuousRate_T ContinuousRate_T;
+    struct Plan_T {
+        Mode_T mode;
+        Bandwidth_T bandwidth;
+        ContinuousRate_T rate;   ///< Continuous mode only
+        uint32_t estimated_us;   ///< estimated time per cycle (conversions plus busOverhead_us per measurement)
+        bool fits;               ///< estimated_us leaves the period's margin; if false this is the fastest possible plan
+    };
+
+    explicit MMC5983MA_Acquisition_C(TCOMPASS &compass_) : compass(compass_) {};
+    ~MMC5983MA_Acquisition_C() { Stop(); };
+
+    bool measureAutoSR = true;       ///< Prefer ResetSetAndAutoSR when the period allows (set before Start)
+    uint32_t busOverhead_us = 2000;  ///< Bus time to allow per one-shot measurement (about two USB round-trips)
+    bool amortizeOffset = false;     ///< Use CachedOffset instead of ResetSet (about twice the rate; set before Start)
+    MMC5983MA_Ring_C<MMC5983MA_AcquiredSample_T, CAPACITY> samples; ///< Worker produces, application consumes
+
+    /// Choose how to measure once per period_us: the lowest (quietest) bandwidth whose one-shot
+    /// measurement(s) fit in 7/8 of the period, preferring RESET/SET + Auto-SR, then RESET/SET, then Auto-SR;
+    /// if no one-shot fits, continuous mode at the slowest rate delivering a sample every period.
+    /// With amortizeOffset, CachedOffset replaces RESET/SET: its usual cycle is a single conversion,
+    /// and the occasional refresh cycle (a full RESET/SET) must still finish within the period.
+    static Plan_T ChoosePlan(uint32_t period_us, bool wantAutoSR, uint32_t overhead_us, bool amortizeOffset = false) {
+        const uint32_t budget_us = period_us - period_us/8;
+        for(int bw = 0; bw < 4; bw++) {
+            uint32_t one = (uint32_t)TCOMPASS::NominalConversion_us((Bandwidth_T)bw, false) + overhead_us;
+            uint32_t rs = 2*(uint32_t)TCOMPASS::NominalConversion_us((Bandwidth_T)bw, false) + overhead_us;
+            uint32_t asr = (uint32_t)TCOMPASS::NominalConversion_us((Bandwidth_T)bw, true) + overhead_us;
+            if(wantAutoSR && rs+asr <= budget_us) return { ResetSetAndAutoSR, (Bandwidth_T)bw, ContinuousRate_T::ContinuousRate_Off, rs+asr, true };
+            if(amortizeOffset && one <= budget_us && rs <= period_us)
+                                                  return { CachedOffset,      (Bandwidth_T)bw, ContinuousRate_T::ContinuousRate_Off, one,    true };
+            if(rs <= budget_us)                   return { ResetSet,          (Bandwidth_T)bw, ContinuousRate_T::ContinuousRate_Off, rs,     true };
+            if(asr <= budget_us)                  return { AutoSR,            (Bandwidth_T)bw, ContinuousRate_T::ContinuousRate_Off, asr,    true };
+        }
+        // Continuous rates (Hz) with the lowest bandwidth each allows
+        static const struct { ContinuousRate_T rate; uint32_t hz; Bandwidth_T bw; } rates[] = {
+            { ContinuousRate_T::ContinuousRate_1Hz,    1,    Bandwidth_T::Bandwidth_00_100Hz },
+            { ContinuousRate_T::ContinuousRate_10Hz,   10,   Bandwidth_T::Bandwidth_00_100Hz },
+            { ContinuousRate_T::ContinuousRate_20Hz,   20,   Bandwidth_T::Bandwidth_00_100Hz },
+            { ContinuousRate_T::ContinuousRate_50Hz,   50,   Bandwidth_T::Bandwidth_00_100Hz },
+            { ContinuousRate_T::ContinuousRate_100Hz,  100,  Bandwidth_T::Bandwidth_00_100Hz },
+            { ContinuousRate_T::ContinuousRate_200Hz,  200,  Bandwidth_T::Bandwidth_01_200Hz },
+            { ContinuousRate_T::ContinuousRate_1000Hz, 1000, Bandwidth_T::Bandwidth_11_800Hz },
+        };
+        for(const auto &r : rates) // slowest rate delivering a new sample every period
+            if(1000000/r.hz <= period_us) return { Continuous, r.bw, r.rate, 1000000/r.hz, true };
+        return { Continuous, Bandwidth_T::Bandwidth_11_800Hz, ContinuousRate_T::ContinuousRate_1000Hz, 1000, false };
+    }
+
+    /// Start the worker thread, which initializes the compass if required (Init can be slow, and for some
+    /// adapters throws), then measures every period_us. Returns immediately with the chosen plan;
+    /// watch GetState() for Running or Failed.
+    Plan_T Start(uint32_t period_us) {
+        Stop();
+        plan = ChoosePlan(period_us, measureAutoSR, busOverhead_us, amortizeOffset);
+        this->period_us = period_us;
+        stopRequested = false;
+        state = Starting;
+        worker = std::thread([this]() { Run(); });
+        return plan;
+    }
+    /// Ask the worker to finish its current cycle, without waiting (Stop waits)
+    void RequestStop() { stopRequested = true; };
+    /// Ask the worker to finish its current cycle, and wait for it
+    void Stop() {
+        stopRequested = true;
+        if(worker.joinable()) worker.join();
+        if(state != Failed) state = Stopped;
+    }
+    /// Publish a calibration for the worker to apply to every following sample (calibrated_mG).
+    /// Fit it anywhere but the worker thread (for a GUI, once per display period).
+    void SetCorrection(const MMC5983MA_EllipsoidCalibration_C::Correction_T &c) {
+        std::lock_guard<std::mutex> lock(correctionMutex);
+        publishedCorrection = c;
+        correctionPublished.store(true, std::memory_order_release);
+    }
+    State_T GetState() const { return state.load(); };
+    /// Why the worker failed (valid once GetState()==Failed)
+    const std::string &ErrorText() const { return errorText; };
+    uint32_t Cycles() const { return sequence.load(std::memory_order_relaxed); };
+    const Plan_T &GetPlan() const { return plan; };
+    /// Snapshot of the scheduler's deadline lateness (jitter) and overrun statistics
+    MMC5983MA_PeriodicScheduler_C::Statistics_T ScheduleStatistics() const {
+        std::lock_guard<std::mutex> lock(statsMutex);
+        return scheduleStats;
+    }
+    static const char *ModeName(uint8_t mode) {
+        static const char *names[] = { "RESET/SET+Auto-SR", "RESET/SET", "Auto-SR", "continuous", "cached offset" };
+        return mode < 5 ? names[mode] : "?";
+    }
+
+  protected:
+    TCOMPASS &compass;
+    std::thread worker;
+    std::atomic<bool> stopRequested {false};
+    std::atomic<State_T> state {Stopped};
+    std::atomic<uint32_t> sequence {0};
+    uint32_t period_us = 1000000;
+    Plan_T plan = {};
+    std::string errorText; ///< written by worker before state becomes Failed
+    MMC5983MA_PeriodicScheduler_C scheduler; ///< worker only
+    mutable std::mutex statsMutex;
+    MMC5983MA_PeriodicScheduler_C::Statistics_T scheduleStats = {}; ///< copy of scheduler.stats, under statsMutex
+    std::mutex correctionMutex;
+    MMC5983MA_EllipsoidCalibration_C::Correction_T publishedCorrection; ///< from SetCorrection, under correctionMutex
+    std::atomic<bool> correctionPublished {false}; ///< publishedCorrection is newer than 'correction'
+    MMC5983MA_EllipsoidCalibration_C::Correction_T correction; ///< worker only: applied to each sample
+
+    void Fail(const char *what) {
+        errorText = what;
+        state = Failed;
+    }
+    /// One one-shot cycle per plan.mode
+    void MeasureOneShot(MMC5983MA_AcquiredSample_T &s) {
+        if(plan.mode == CachedOffset) {
+            s.result = compass.Measure_XYZ_Field_WithCachedOffset();
+            for(int i = 0; i < 3; i++) { s.field[i] = compass.field[i]; s.offset[i] = compass.offset[i]; }
+            return;
+        }
+        if(plan.mode != AutoSR) {
+            s.result = compass.Measure_XYZ_Field_WithResetSet();
+            for(int i = 0; i < 3; i++) { s.field[i] = compass.field[i]; s.offset[i] = compass.offset[i]; }
+        }
+        if(plan.mode != ResetSet) {
+            s.result |= compass.Measure_XYZ_Field_WithAutoSR();
+            for(int i = 0; i < 3; i++) (plan.mode == AutoSR ? s.field : s.fieldAutoSR)[i] = compass.field[i];
+        }
+    }
+    /// Correct s.field with the newest published calibration (the lock is only taken when there is a new one)
+    void Calibrate(MMC5983MA_AcquiredSample_T &s) {
+        if(correctionPublished.exchange(false, std::memory_order_acquire)) {
+            std::lock_guard<std::mutex> lock(correctionMutex);
+            correction = publishedCorrection;
+        }
+        if(s.result != 0 || correction.model == MMC5983MA_EllipsoidCalibration_C::None) return;
+        double field_mG[3];
+        for(int i = 0; i < 3; i++) field_mG[i] = (double)s.field[i] / ((double)TCOMPASS::CountsPerGauss/1000.0);
+        correction.Apply(field_mG, s.calibrated_mG);
+        s.calibration = correction.model;
+    }
+    void Run() {
+        try {
+            if(!compass.initialized && compass.Init() != 0) {
+                Fail("Compass initialization failed (wrong Product ID or bus error)");
+                return;
+            }
+            if(plan.mode == Continuous) {
+                if(compass.StartContinuousMode(plan.rate, plan.bandwidth, true) != 0) {
+                    Fail("Could not start continuous mode");
+                    return;
+                }
+            } else {
+                if(compass.InContinuousMode()) compass.StopContinuousMode();
+                compass.SetBandwidth(plan.bandwidth);
+            }
+            state = Running;
+            scheduler.Start(period_us);
+            while(!stopRequested) {
+                uint64_t deadline = scheduler.WaitNext(&stopRequested);
+                if(deadline == 0) break; // Stop requested
+                {
+                    std::lock_guard<std::mutex> lock(statsMutex);
+                    scheduleStats = scheduler.stats;
+                }
+                MMC5983MA_AcquiredSample_T s = {};
+                s.deadline_us = deadline;
+                s.time_us = MMC5983MA_PeriodicScheduler_C::Now_us();
+                s.mode = plan.mode;
+                if(plan.mode == Continuous) {
+                    int8_t got = compass.ServiceContinuousMode(); // fetches the newest sample, if any
+                    typename TCOMPASS::ContinuousSample_T c = {};
+                    bool any = false;
+                    while(compass.continuousSamples.Pop(c)) any = true; // keep only the newest
+                    if(got < 0) s.result = -1;
+                    else if(!any) continue; // sensor has not completed a new sample yet; next deadline
+                    else for(int i = 0; i < 3; i++) s.field[i] = c.field[i];
+                    s.time_us = MMC5983MA_PeriodicScheduler_C::Now_us();
+                } else {
+                    MeasureOneShot(s);
+                }
+                Calibrate(s);
+                s.sequence = sequence.fetch_add(1, std::memory_order_relaxed);
+                samples.Push(s);
+            }
+            if(plan.mode == Continuous) compass.StopContinuousMode();
+        } catch(const std::exception &e) {
+            Fail(e.what());
+        }
+    }
+};
+
+#endif // MMC5983MA_ACQUISITION_HPP_INCLUDED
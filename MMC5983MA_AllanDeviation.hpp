@@ -0,0 +1,136 @@
+/// MMC5983MA_AllanDeviation.hpp - MMC5983MA_AllanDeviation_C class - overlapping Allan deviation of long X/Y/Z captures.
+
+/*
+MIT License
+
+Copyright (c) 2023-2025 Dave Nadler
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef MMC5983MA_ALLANDEVIATION_HPP_INCLUDED
+#define MMC5983MA_ALLANDEVIATION_HPP_INCLUDED
+
+#include <stdint.h>
+#include <math.h>
+#include <stddef.h>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+/// Overlapping Allan deviation, per axis, of evenly spaced field samples (a capture of one measurement mode
+/// and bandwidth), at log-spaced averaging times tau = m*tau0. This is the noise characterization of
+/// references/Robert_noise_summary.PNG: white noise falls as 1/sqrt(tau), the curve's minimum is the noise
+/// floor (bias instability), and drift makes it rise again.
+/// Each axis is first turned into cumulative sums S (mean removed, to keep them small), so every cluster
+/// average is (S[j+m]-S[j])/m and one tau costs a single pass over the capture, however large m is:
+///     adev(m)^2 = sum over j of (S[j+2m] - 2S[j+m] + S[j])^2 / (2 m^2 (N-2m+1))
+/// The (axis, tau) passes are independent and are shared out across threads; a few million samples
+/// take well under a second. Memory: one double per sample per axis for the cumulative sums.
+class MMC5983MA_AllanDeviation_C {
+  public:
+    static const int Axes = 3;
+    struct Point_T {
+        double tau_s;
+        uint32_t m;      ///< samples per cluster
+        double adev;     ///< in the units of the input
+        uint64_t terms;  ///< overlapping differences averaged (N-2m+1)
+    };
+    struct Result_T {
+        double tau0_s = 0;
+        size_t samples = 0;
+        std::vector<Point_T> axis[Axes];
+        /// Noise floor: the lowest point of an axis' curve (nullptr if the capture was too short)
+        const Point_T *Floor(int a) const {
+            auto it = std::min_element(axis[a].begin(), axis[a].end(),
+                [](const Point_T &x, const Point_T &y) { return x.adev < y.adev; });
+            return it == axis[a].end() ? nullptr : &*it;
+        }
+    };
+    uint32_t pointsPerDecade = 10; ///< tau spacing; m=1 is always included
+    uint32_t threads = 0;          ///< 0: one per hardware thread
+
+    /// Cluster sizes m analysed for n samples: 1, then about pointsPerDecade per decade, up to (n-1)/2
+    std::vector<uint32_t> ClusterSizes(size_t n) const {
+        std::vector<uint32_t> sizes;
+        size_t largest = n > 2 ? (n - 1) / 2 : 0;
+        for(double k = 0; ; k++) {
+            uint32_t m = (uint32_t)floor(pow(10.0, k / std::max<uint32_t>(pointsPerDecade, 1)) + 0.5);
+            if(m > largest) break;
+            if(sizes.empty() || m > sizes.back()) sizes.push_back(m);
+        }
+        return sizes;
+    }
+
+    /// x[a][i] is sample i of axis a (all three the same length), taken every tau0_s seconds
+    Result_T Compute(const std::vector<double> (&x)[Axes], double tau0_s) const {
+        Result_T r;
+        r.tau0_s = tau0_s;
+        r.samples = x[0].size();
+        for(int a = 1; a < Axes; a++) r.samples = std::min(r.samples, x[a].size());
+        const size_t n = r.samples;
+        std::vector<uint32_t> sizes = ClusterSizes(n);
+        if(sizes.empty()) return r;
+
+        uint32_t nThreads = threads ? threads : std::max(1u, std::thread::hardware_concurrency());
+        auto parallel = [nThreads](size_t items, auto work) { // work(item) for items 0..items-1, shared out
+            std::atomic<size_t> next {0};
+            auto worker = [&]() { for(size_t i; (i = next++) < items; ) work(i); };
+            std::vector<std::thread> pool;
+            for(uint32_t t = 1; t < std::min<size_t>(nThreads, items); t++) pool.emplace_back(worker);
+            worker();
+            for(std::thread &t : pool) t.join();
+        };
+
+        std::vector<double> sums[Axes];
+        parallel(Axes, [&](size_t a) {
+            double mean = 0;
+            for(size_t i = 0; i < n; i++) mean += x[a][i];
+            mean /= n;
+            std::vector<double> &s = sums[a];
+            s.resize(n + 1);
+            s[0] = 0;
+            for(size_t i = 0; i < n; i++) s[i+1] = s[i] + (x[a][i] - mean);
+        });
+
+        for(int a = 0; a < Axes; a++) r.axis[a].resize(sizes.size());
+        // Smallest m first: those passes are the longest, so the short ones fill in at the end
+        parallel(Axes * sizes.size(), [&](size_t item) {
+            int a = (int)(item % Axes);
+            size_t k = item / Axes;
+            uint32_t m = sizes[k];
+            const double *s = sums[a].data();
+            size_t terms = n - 2*(size_t)m + 1;
+            double total = 0;
+            for(size_t j = 0; j < terms; j++) {
+                double d = s[j + 2*m] - 2*s[j + m] + s[j];
+                total += d * d;
+            }
+            Point_T &p = r.axis[a][k];
+            p.tau_s = m * tau0_s;
+            p.m = m;
+            p.adev = sqrt(total / (2.0 * m * m * (double)terms));
+            p.terms = terms;
+        });
+        return r;
+    }
+};
+
+#endif // MMC5983MA_ALLANDEVIATION_HPP_INCLUDED
@@ -0,0 +1,206 @@
+/// MMC5983MA_Async.hpp - MMC5983MA_EventLoop_C class - C++20 coroutines measuring without blocking their thread.
+
+/*
+MIT License
+
+Copyright (c) 2023-2025 Dave Nadler
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#ifndef MMC5983MA_ASYNC_HPP_INCLUDED
+#define MMC5983MA_ASYNC_HPP_INCLUDED
+
+#include <stdint.h>
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <queue>
+#include <utility> // std::exchange
+#include <vector>
+#include "MMC5983MA.hpp"
+#include "MMC5983MA_Delay.hpp"
+
+/// Coroutine run by an MMC5983MA_EventLoop_C. Give it to Spawn, which owns it from then on.
+/// An exception escaping the coroutine is rethrown by MMC5983MA_EventLoop_C::Run.
+class MMC5983MA_Task_C {
+  public:
+    struct promise_type {
+        std::exception_ptr exception;
+        MMC5983MA_Task_C get_return_object() {
+            return MMC5983MA_Task_C(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; } // runs when the loop first resumes it
+        std::suspend_always final_suspend() noexcept { return {}; }   // the loop destroys it
+        void return_void() {}
+        void unhandled_exception() { exception = std::current_exception(); }
+    };
+    MMC5983MA_Task_C(MMC5983MA_Task_C &&other) noexcept : handle(std::exchange(other.handle, {})) {};
+    MMC5983MA_Task_C &operator=(MMC5983MA_Task_C &&other) noexcept {
+        if(this != &other) {
+            if(handle) handle.destroy();
+            handle = std::exchange(other.handle, {});
+        }
+        return *this;
+    };
+    MMC5983MA_Task_C(const MMC5983MA_Task_C &) = delete;
+    MMC5983MA_Task_C &operator=(const MMC5983MA_Task_C &) = delete;
+    ~MMC5983MA_Task_C() { if(handle) handle.destroy(); };
+  private:
+    friend class MMC5983MA_EventLoop_C;
+    explicit MMC5983MA_Task_C(std::coroutine_handle<promise_type> h) : handle(h) {};
+    std::coroutine_handle<promise_type> handle;
+};
+
+/// Runs coroutines (MMC5983MA_Task_C) on one thread. A task suspends on an awaitable, such as
+///   MMC5983MA_Sample_T s = co_await loop.Measure(compass);  // s.Ok(), s.field...  (MMC5983MA_C::Measure)
+///   co_await loop.Sleep_us(1000);
+/// and the loop resumes it when that is done, meanwhile running whatever else is due: other sensors'
+/// measurement steps (MMC5983MA_C::PollMeasurement) or other tasks. The thread sleeps only when
+/// nothing is due. Measure and Sleep_us deadlines are in the sensors' time (TDEVICE::time_us); the
+/// default clock is the steady clock the hardware IO classes use. For virtual-time IO classes (the
+/// simulator) set now_us and sleep_us to that device's time_us and delay_us, and keep every sensor
+/// the loop drives on the same clock.
+/// Not thread-safe: Spawn, Run, and the tasks all belong to one thread.
+class MMC5983MA_EventLoop_C {
+  public:
+    /// What a suspended task waits for: at due_us the loop calls Ready(); if false, again at the new due_us
+    struct Waiter_T {
+        uint64_t due_us = 0;
+        std::coroutine_handle<> handle;
+        virtual bool Ready() { return true; };
+        virtual ~Waiter_T() = default;
+    };
+    struct Statistics_T {
+        uint32_t resumes;  ///< task resumptions
+        uint32_t polls;    ///< Ready() calls that left the task waiting
+        uint64_t idle_us;  ///< time slept with nothing due
+    };
+
+    MMC5983MA_HybridDelay_C delay;  ///< default sleep_us
+    std::function<uint64_t()> now_us = MMC5983MA_HybridDelay_C::Now_us;
+    std::function<void(uint32_t)> sleep_us = [this](uint32_t us) { delay.Delay_us(us); };
+    Statistics_T stats = {};
+
+    MMC5983MA_EventLoop_C() = default;
+    MMC5983MA_EventLoop_C(const MMC5983MA_EventLoop_C &) = delete; // sleep_us refers to this
+    MMC5983MA_EventLoop_C &operator=(const MMC5983MA_EventLoop_C &) = delete;
+
+    /// Add a task; it starts running in Run
+    void Spawn(MMC5983MA_Task_C &&task) {
+        runnable.push_back(task.handle);
+        tasks.push_back(std::move(task));
+    }
+    /// Run until every task has finished (or waits on nothing the loop knows about)
+    void Run() {
+        for(;;) {
+            if(!runnable.empty()) {
+                std::coroutine_handle<> h = runnable.front();
+                runnable.erase(runnable.begin());
+                Resume(h);
+                continue;
+            }
+            if(timers.empty()) return;
+            Timer_T t = timers.top();
+            timers.pop();
+            uint64_t now = now_us();
+            if(t.due_us > now) {
+                stats.idle_us += t.due_us - now;
+                sleep_us((uint32_t)(t.due_us - now));
+            }
+            if(t.waiter->Ready()) {
+                Resume(t.waiter->handle);
+            } else {
+                stats.polls++;
+                Schedule(t.waiter);
+            }
+        }
+    }
+    /// Queue a suspended task's waiter (awaitables call this from await_suspend)
+    void Schedule(Waiter_T *w) { timers.push(Timer_T{ w->due_us, nextSequence++, w }); };
+
+    /// co_await: resume after uSecs
+    struct SleepAwaiter_T : Waiter_T {
+        MMC5983MA_EventLoop_C &loop;
+        SleepAwaiter_T(MMC5983MA_EventLoop_C &loop_, uint64_t due) : loop(loop_) { this->due_us = due; };
+        bool await_ready() const { return false; };
+        void await_suspend(std::coroutine_handle<> h) { handle = h; loop.Schedule(this); };
+        void await_resume() const {};
+    };
+    SleepAwaiter_T Sleep_us(uint32_t uSecs) { return SleepAwaiter_T(*this, now_us() + uSecs); };
+
+    /// co_await: one ResetSet or AutoSR measurement (MMC5983MA_C::StartMeasurement and PollMeasurement),
+    /// resuming with its record (MMC5983MA_C::LastSample)
+    template <typename TDEVICE>
+    struct MeasureAwaiter_T : Waiter_T {
+        MMC5983MA_EventLoop_C &loop;
+        MMC5983MA_C<TDEVICE> &compass;
+        MMC5983MA_MeasurementMode_T mode;
+        MeasureAwaiter_T(MMC5983MA_EventLoop_C &loop_, MMC5983MA_C<TDEVICE> &compass_, MMC5983MA_MeasurementMode_T mode_)
+            : loop(loop_), compass(compass_), mode(mode_) {};
+        bool await_ready() { return compass.StartMeasurement(mode) < 0; }; // performs the first step right away
+        void await_suspend(std::coroutine_handle<> h) {
+            handle = h;
+            due_us = compass.MeasurementDue_us();
+            loop.Schedule(this);
+        };
+        MMC5983MA_Sample_T await_resume() const { return compass.LastSample(); };
+        bool Ready() override {
+            if(compass.PollMeasurement() != 0) return true; // complete or failed
+            due_us = compass.MeasurementDue_us();
+            return false;
+        };
+    };
+    template <typename TDEVICE>
+    MeasureAwaiter_T<TDEVICE> Measure(MMC5983MA_C<TDEVICE> &compass,
+        MMC5983MA_MeasurementMode_T mode = MMC5983MA_MeasurementMode_T::ResetSet) {
+        return MeasureAwaiter_T<TDEVICE>(*this, compass, mode);
+    }
+
+  protected:
+    struct Timer_T {
+        uint64_t due_us;
+        uint64_t sequence; ///< equal deadlines in Schedule order
+        Waiter_T *waiter;
+        bool operator>(const Timer_T &other) const {
+            return due_us != other.due_us ? due_us > other.due_us : sequence > other.sequence;
+        };
+    };
+    std::priority_queue<Timer_T, std::vector<Timer_T>, std::greater<Timer_T>> timers;
+    std::vector<std::coroutine_handle<>> runnable; ///< spawned, not yet started
+    std::vector<MMC5983MA_Task_C> tasks;
+    uint64_t nextSequence = 0;
+
+    void Resume(std::coroutine_handle<> h) {
+        stats.resumes++;
+        h.resume();
+        if(!h.done()) return;
+        // That task finished: destroy it, and rethrow what escaped it
+        for(size_t i = 0; i < tasks.size(); i++) {
+            if(tasks[i].handle.address() != h.address()) continue;
+            std::exception_ptr e = tasks[i].handle.promise().exception;
+            tasks.erase(tasks.begin() + i);
+            if(e) std::rethrow_exception(e);
+            return;
+        }
+    }
+};
+
+#endif // MMC5983MA_ASYNC_HPP_INCLUDED
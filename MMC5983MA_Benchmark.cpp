@@ -0,0 +1,696 @@
+// MMC5983MA_Benchmark.cpp - command-line throughput/latency benchmark for MMC5983MA_C and its IO backends
+
+/*
+MIT License
+
+Copyright (c) 2023-2025 Dave Nadler
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+// Runs every one-shot measurement mode (RESET/SET, Auto-SR, cached offset,
+// motion-compensated RESET-SET-RESET and rolling alternation) at every Bandwidth_T against one IO backend:
+//   sim      MMC5983MA_IO_Simulator_C (I2C), virtual time
+//   sim-spi  MMC5983MA_IO_Simulator_C (SPI), virtual time
+//   emu      libMPSSE + FT232H_Emulator_C, virtual time
+//   ft232h   real FT232H adapter and sensor
+//   mcp2221  real MCP2221 adapter and sensor (Windows only)
+// and reports samples/second, per-sample latency percentiles, bus traffic, and where the time went
+// (sleeping while the sensor converts vs. waiting on the bus). --csv/--json write the same results
+// for scripts; --baseline compares against an earlier --csv file and exits 1 on a regression.
+// --fleet N instead runs N sensors (adapters 0..N-1) in parallel with MMC5983MA_Fleet_C and reports
+// per-sensor and merged throughput.
+// --mux N measures N sensors behind one adapter's I2C mux (channels 0..N-1), first one after another,
+// then interleaved by MMC5983MA_BusScheduler_C, then by one coroutine per sensor (MMC5983MA_EventLoop_C),
+// and compares their throughput.
+// --allan FILE keeps every sample's field and writes the overlapping Allan deviation of each mode/bandwidth
+// (per axis, log-spaced tau) as CSV, printing each noise floor; use --samples in the millions.
+// --capture FILE records every timed measurement in the binary capture format (MMC5983MA_Capture.hpp).
+// --transfers N (emu, ft232h) times N unbatched register reads and writes with libMPSSE's per-channel arena
+// and purge-after-failure, then with its old allocate-and-purge path, and compares them per transfer.
+// See BuildNotes.txt for build commands.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "MMC5983MA.hpp"
+#include "MMC5983MA_IO_Simulator.hpp"
+#include "MMC5983MA_IO_EmulatedFT232H.hpp"
+#include "MMC5983MA_Fleet.hpp"
+#include "MMC5983MA_BusScheduler.hpp"
+#include "MMC5983MA_Async.hpp"
+#include "MMC5983MA_AllanDeviation.hpp"
+#include "MMC5983MA_Capture.hpp"
+#ifdef _WIN32
+  #include "MMC5983MA_IO_WindowsQwiic_MCP2221.hpp"
+#endif
+
+static bool verbose = false;
+int MMC5983MA_IO_base_C::DiagPrintf(const char* format, ...) {
+    if(!verbose) return 0;
+    va_list args;
+    va_start(args, format);
+    int n = vfprintf(stderr, format, args);
+    va_end(args);
+    return n;
+}
+
+/// Wraps any TDEVICE, charging the time spent in each call to either 'sleep' (delay_us, and delays
+/// queued in a batch) or 'wire' (read, write, and the rest of FlushBatch). Times come from the
+/// device's own time_us(), so simulated and emulated backends report virtual time.
+template <typename TDEVICE>
+class MMC5983MA_IO_Timed_C : public TDEVICE {
+  public:
+    uint64_t sleep_us = 0; ///< Time in delay_us plus delays queued in batches
+    uint64_t wire_us = 0;  ///< Time in read/write/FlushBatch, less queued delays
+    void ResetTimes() { sleep_us = wire_us = queuedDelay_us = 0; };
+
+    void read(uint8_t reg_addr, uint8_t (&read_data)[], uint32_t len) {
+        uint64_t t0 = this->time_us();
+        TDEVICE::read(reg_addr, read_data, len);
+        wire_us += this->time_us() - t0;
+    };
+    void write(uint8_t reg_addr, const uint8_t (&write_data)[], uint32_t len) {
+        uint64_t t0 = this->time_us();
+        TDEVICE::write(reg_addr, write_data, len);
+        wire_us += this->time_us() - t0;
+    };
+    void delay_us(uint32_t uSecs) {
+        uint64_t t0 = this->time_us();
+        TDEVICE::delay_us(uSecs);
+        sleep_us += this->time_us() - t0;
+    };
+    // Only instantiated if TDEVICE::SupportsBatching (MMC5983MA_C uses these under 'if constexpr')
+    void QueueDelay_us(uint32_t uSecs) {
+        queuedDelay_us += uSecs;
+        TDEVICE::QueueDelay_us(uSecs);
+    };
+    bool FlushBatch() {
+        uint64_t t0 = this->time_us();
+        bool ok = TDEVICE::FlushBatch();
+        uint64_t elapsed = this->time_us() - t0;
+        uint64_t slept = std::min<uint64_t>(queuedDelay_us, elapsed);
+        sleep_us += slept;
+        wire_us += elapsed - slept;
+        queuedDelay_us = 0;
+        return ok;
+    };
+  private:
+    uint64_t queuedDelay_us = 0; ///< delays queued since the last FlushBatch
+};
+
+/// MMC5983MA_C with the IO device exposed to the benchmark
+template <typename TDEVICE>
+class MMC5983MA_Benchmark_C : public MMC5983MA_C<MMC5983MA_IO_Timed_C<TDEVICE>> {
+  public:
+    MMC5983MA_IO_Timed_C<TDEVICE> &Dev() { return this->dev; };
+    static const uint8_t ProductID = MMC5983MA_C<MMC5983MA_IO_Timed_C<TDEVICE>>::Product_ID_Assigned; ///< Init checked it
+};
+
+struct Options_T {
+    std::string device = "sim";
+    uint32_t samples = 200;
+    uint32_t warmup = 20;              ///< untimed samples per configuration (lets adaptive timing settle)
+    uint32_t simTransaction_us = 1000; ///< sim/sim-spi only: virtual cost of one bus transaction
+    const char *csvPath = nullptr;
+    const char *jsonPath = nullptr;
+    const char *baselinePath = nullptr;
+    const char *tracePath = nullptr;   ///< register-IO trace file (MMC5983MA_TraceDecode prints it)
+    const char *allanPath = nullptr;   ///< Allan deviation CSV (MMC5983MA_AllanDeviation_C) of each mode/bandwidth
+    const char *capturePath = nullptr; ///< binary capture (MMC5983MA_CaptureWriter_C) of every timed measurement
+    bool dataReady = false;            ///< wait for the sensor's INT pin instead of sleep-and-poll
+    uint32_t fleet = 0;                ///< >0: run this many sensors in parallel (MMC5983MA_Fleet_C) instead
+    uint32_t period_us = 10000;        ///< fleet: acquisition period per sensor
+    double seconds = 2;                ///< fleet: run time
+    uint32_t mux = 0;                  ///< >0: this many sensors behind one adapter's mux (MMC5983MA_BusScheduler_C)
+    uint32_t transfers = 0;            ///< >0: compare libMPSSE transfer paths over this many reads and writes each
+    double tolerance_pct = 10;
+};
+
+/// One benchmark configuration's results (one CSV row)
+struct Result_T {
+    std::string device, mode, bandwidth;
+    uint32_t samples, failures;
+    double samplesPerSecond;
+    uint32_t p50_us, p99_us, max_us;
+    uint32_t transactions;   ///< addressed bus reads + writes (batched or not)
+    uint32_t bytes;          ///< register bytes read + written
+    uint32_t flushes, fallbacks;
+    uint64_t sleep_us, wire_us, other_us;
+    int64_t usbRoundTrips;   ///< -1 unless the backend can count them (emu)
+};
+
+static const char *BandwidthName(uint32_t bw) {
+    static const char *names[4] = { "100Hz", "200Hz", "400Hz", "800Hz" };
+    return names[bw & 3];
+}
+
+/// Nearest-rank percentile of sorted values
+static uint32_t Percentile(const std::vector<uint32_t> &sorted, double p) {
+    if(sorted.empty()) return 0;
+    size_t rank = (size_t)ceil(p * sorted.size());
+    return sorted[std::max<size_t>(rank, 1) - 1];
+}
+
+static MMC5983MA_Trace_C registerTrace;
+static FILE *traceFile;
+static FILE *allanFile;
+static MMC5983MA_CaptureWriter_C capture;
+
+/// --allan: analyse one mode/bandwidth's fields (mG), append its curves to allanFile and print the noise floors
+static void WriteAllan(const Result_T &r, const std::vector<double> (&field_mG)[3], double tau0_s) {
+    MMC5983MA_AllanDeviation_C allan;
+    auto t0 = std::chrono::steady_clock::now();
+    MMC5983MA_AllanDeviation_C::Result_T adev = allan.Compute(field_mG, tau0_s);
+    double elapsed_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    static const char *axisNames[3] = { "X", "Y", "Z" };
+    printf("  Allan %-9s %-5s %zu samples, tau0 %.6fs (%.2fs):", r.mode.c_str(), r.bandwidth.c_str(),
+        adev.samples, tau0_s, elapsed_s);
+    for(int a = 0; a < 3; a++) {
+        for(const MMC5983MA_AllanDeviation_C::Point_T &p : adev.axis[a])
+            fprintf(allanFile, "%s,%s,%s,%s,%.6f,%u,%.6f,%llu\n", r.device.c_str(), r.mode.c_str(), r.bandwidth.c_str(),
+                axisNames[a], p.tau_s, p.m, p.adev, (unsigned long long)p.terms);
+        const MMC5983MA_AllanDeviation_C::Point_T *noiseFloor = adev.Floor(a);
+        if(noiseFloor) printf(" %s floor %.4fmG at %.3gs", axisNames[a], noiseFloor->adev, noiseFloor->tau_s);
+    }
+    printf("\n");
+}
+
+template <typename TDEVICE>
+static void RunDevice(MMC5983MA_Benchmark_C<TDEVICE> &compass, const Options_T &opt, std::vector<Result_T> &results) {
+    typedef typename MMC5983MA_C<MMC5983MA_IO_Timed_C<TDEVICE>>::Bandwidth_T Bandwidth_T;
+    auto &dev = compass.Dev();
+    static const char *modeNames[] = { "ResetSet", "AutoSR", "Cached", "RSR", "Alternate" };
+    for(int mode = 0; mode < 5; mode++) {
+        for(uint32_t bw = 0; bw < 4; bw++) {
+            compass.SetBandwidth((Bandwidth_T)bw);
+            // modeNames order is MMC5983MA_MeasurementMode_T's; Alternate's result is 1 while priming (not a failure)
+            auto measure = [&]() { return compass.Measure((MMC5983MA_MeasurementMode_T)mode); };
+            for(uint32_t i = 0; i < opt.warmup; i++) measure();
+            compass.ResetBusStatistics();
+            dev.ResetTimes();
+            if constexpr (requires { dev.emulator; }) dev.emulator.ResetStatistics();
+            std::vector<uint32_t> latency;
+            latency.reserve(opt.samples);
+            std::vector<double> field_mG[3]; // --allan only
+            if(allanFile) for(auto &f : field_mG) f.reserve(opt.samples);
+            Result_T r = {};
+            uint64_t start_us = dev.time_us();
+            for(uint32_t i = 0; i < opt.samples; i++) {
+                MMC5983MA_Sample_T s = measure();
+                if(s.result < 0) r.failures++;
+                latency.push_back((uint32_t)(s.end_us - s.start_us));
+                if(traceFile) registerTrace.WriteFile(traceFile); // a RESET/SET sample traces 22 records
+                capture.Add(s); // if open: queued for the writer thread
+                if(allanFile && s.Ok())
+                    for(int a = 0; a < 3; a++) field_mG[a].push_back(s.field[a] * (1000.0 / compass.CountsPerGauss));
+            }
+            uint64_t elapsed_us = dev.time_us() - start_us;
+            std::sort(latency.begin(), latency.end());
+            r.device = opt.dataReady ? opt.device + "+int" : opt.device; // separate baseline rows
+            r.mode = modeNames[mode];
+            r.bandwidth = BandwidthName(bw);
+            r.samples = opt.samples;
+            r.samplesPerSecond = elapsed_us ? opt.samples * 1e6 / elapsed_us : 0;
+            r.p50_us = Percentile(latency, 0.50);
+            r.p99_us = Percentile(latency, 0.99);
+            r.max_us = latency.empty() ? 0 : latency.back();
+            r.transactions = compass.busStats.readTransactions + compass.busStats.writeTransactions;
+            r.bytes = compass.busStats.bytesRead + compass.busStats.bytesWritten;
+            r.flushes = compass.busStats.batchFlushes;
+            r.fallbacks = compass.busStats.batchFallbacks;
+            r.sleep_us = dev.sleep_us;
+            r.wire_us = dev.wire_us;
+            r.other_us = elapsed_us > dev.sleep_us + dev.wire_us ? elapsed_us - dev.sleep_us - dev.wire_us : 0;
+            r.usbRoundTrips = -1;
+            if constexpr (requires { dev.emulator; }) {
+                r.usbRoundTrips = dev.emulator.stats.usbReads;
+                if(verbose) {
+                    printf("  emulator, %s %s:\n", r.mode.c_str(), r.bandwidth.c_str());
+                    dev.emulator.PrintStatistics(stdout, opt.samples);
+                }
+            }
+            if(verbose && mode == 2) {
+                const auto &ot = compass.offsetTracking;
+                printf("  offset tracking, %s: %u refreshes, %u cached samples, %u drift events, last drift %u counts, interval %u\n",
+                    r.bandwidth.c_str(), ot.refreshes, ot.cachedSamples, ot.driftEvents, ot.lastDrift, ot.interval);
+            }
+            if(allanFile && field_mG[0].size() > 2) WriteAllan(r, field_mG, elapsed_us * 1e-6 / opt.samples);
+            results.push_back(r);
+        }
+    }
+    if constexpr (requires { dev.delay; }) {
+        if(dev.delay.requested_us) dev.delay.PrintStatistics(stdout); // host delays (not the emulator's virtual ones)
+    }
+    if constexpr (requires { dev.TransferStatistics(); }) {
+        I2C_TransferStatistics s = dev.TransferStatistics();
+        printf("libMPSSE: %u transfers, %u failures, %u purges, %u arena uses, %u heap allocations\n",
+            (unsigned)s.transfers, (unsigned)s.failures, (unsigned)s.purges, (unsigned)s.arenaUses, (unsigned)s.heapAllocations);
+    }
+}
+
+/// --transfers: unbatched register reads (9-byte poll-and-fetch, I2C_DeviceWriteRead) and writes (Status
+/// write-1-to-clear, I2C_DeviceWrite), with libMPSSE's arena and purge-after-failure, then its old path
+/// (I2C_SetLegacyTransfers). Host time is the CPU spent in libMPSSE (and the emulator, if emu); bus time
+/// is the device's time_us (emu: virtual, including the cost of each purge).
+template <typename TDEVICE>
+static void CompareTransfers(MMC5983MA_Benchmark_C<TDEVICE> &compass, const Options_T &opt) {
+    auto &dev = compass.Dev();
+    if constexpr (requires { dev.LegacyTransfers(true); }) {
+        printf("libMPSSE transfers: %u of each\n", opt.transfers);
+        printf("%-22s %-6s %12s %12s %12s %12s\n", "path", "xfer", "allocs/xfer", "purges/xfer", "host us/xfer", "bus us/xfer");
+        uint8_t rawBytes[9];
+        const uint8_t clear = 0x01; // Meas_M_Done
+        for(int legacy = 0; legacy < 2; legacy++) {
+            dev.LegacyTransfers(legacy != 0);
+            for(int write = 0; write < 2; write++) {
+                I2C_TransferStatistics before = dev.TransferStatistics();
+                auto t0 = std::chrono::steady_clock::now();
+                uint64_t bus0_us = dev.time_us();
+                for(uint32_t i = 0; i < opt.transfers; i++) {
+                    if(write) dev.write(0x08, reinterpret_cast<const uint8_t (&)[]>(clear), 1);
+                    else      dev.read(0x00, reinterpret_cast<uint8_t (&)[]>(rawBytes), sizeof(rawBytes));
+                }
+                uint64_t bus_us = dev.time_us() - bus0_us;
+                double host_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+                I2C_TransferStatistics after = dev.TransferStatistics();
+                double n = std::max<double>(after.transfers - before.transfers, 1);
+                printf("%-22s %-6s %12.3f %12.3f %12.2f %12.1f\n", legacy ? "allocate+purge (old)" : "arena+purge-on-error",
+                    write ? "write" : "read", (after.heapAllocations - before.heapAllocations) / n,
+                    (after.purges - before.purges) / n, host_us / n, bus_us / n);
+            }
+        }
+        dev.LegacyTransfers(false);
+    } else {
+        printf("--transfers: device '%s' does not use libMPSSE\n", opt.device.c_str());
+    }
+}
+
+template <typename TDEVICE>
+static int RunBackend(const Options_T &opt, std::vector<Result_T> &results, void (*configure)(TDEVICE &) = nullptr) {
+    auto compass = std::make_unique<MMC5983MA_Benchmark_C<TDEVICE>>(); // emulator state is large; keep it off the stack
+    if(configure) configure(compass->Dev());
+    if constexpr (requires { compass->Dev().dataReadyWiring; }) { // FT232H: INT on ADBUS5 unless configured otherwise
+        if(opt.dataReady && compass->Dev().dataReadyWiring == TDEVICE::DataReady_NotWired)
+            compass->Dev().dataReadyWiring = TDEVICE::DataReady_GPIOL1;
+    }
+    if(traceFile) compass->registerTrace = &registerTrace;
+    if(compass->Init() != 0) {
+        fprintf(stderr, "MMC5983MA Init failed on device '%s'\n", opt.device.c_str());
+        return 2;
+    }
+    if(opt.dataReady && compass->EnableDataReadyInterrupt() != 0) {
+        fprintf(stderr, "Device '%s' can't use the data-ready interrupt\n", opt.device.c_str());
+        return 2;
+    }
+    if(opt.capturePath && !capture.Open(opt.capturePath, opt.device.c_str(), compass->ProductID, compass->CountsPerGauss)) {
+        fprintf(stderr, "Can't write '%s'\n", opt.capturePath);
+        return 2;
+    }
+    RunDevice(*compass, opt, results);
+    if(opt.transfers) CompareTransfers(*compass, opt);
+    if(capture.IsOpen()) {
+        uint64_t dropped = capture.Dropped();
+        if(!capture.Close()) { fprintf(stderr, "Can't write '%s'\n", opt.capturePath); return 2; }
+        if(dropped) fprintf(stderr, "%llu measurements not captured (disk too slow)\n", (unsigned long long)dropped);
+    }
+    return 0;
+}
+
+/// --fleet: sensors on adapters 0..N-1, each measuring every opt.period_us on its own thread,
+/// merged into one time-ordered stream
+template <typename TDEVICE>
+static int RunFleet(const Options_T &opt, void (*select)(TDEVICE &, uint32_t) = nullptr) {
+    MMC5983MA_Fleet_C<TDEVICE> fleet;
+    for(uint32_t i = 0; i < opt.fleet; i++)
+        fleet.Add(opt.device + "#" + std::to_string(i), [i, select](TDEVICE &d) { if(select) select(d, i); });
+    if(fleet.Open() != 0) {
+        for(uint32_t i = 0; i < fleet.Count(); i++)
+            if(!fleet.Sensor(i).error.empty())
+                fprintf(stderr, "%s: %s\n", fleet.Sensor(i).name.c_str(), fleet.Sensor(i).error.c_str());
+        return 2;
+    }
+    if(opt.dataReady)
+        for(uint32_t i = 0; i < fleet.Count(); i++) fleet.Sensor(i).compass.EnableDataReadyInterrupt();
+    fleet.Start(opt.period_us);
+    std::vector<uint32_t> mergeDelay; // sample time to release by Pop
+    uint32_t merged = 0, failures = 0;
+    uint64_t start_us = MMC5983MA_PeriodicScheduler_C::Now_us();
+    uint64_t end_us = start_us + (uint64_t)(opt.seconds * 1e6);
+    MMC5983MA_FleetSample_T s;
+    for(uint64_t now = start_us; now < end_us; now = MMC5983MA_PeriodicScheduler_C::Now_us()) {
+        while(fleet.Pop(s)) {
+            merged++;
+            if(s.sample.result < 0) failures++;
+            mergeDelay.push_back((uint32_t)(MMC5983MA_PeriodicScheduler_C::Now_us() - s.sample.time_us));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    fleet.Stop();
+    double elapsed_s = (MMC5983MA_PeriodicScheduler_C::Now_us() - start_us) / 1e6;
+    printf("%-12s %-18s %9s %9s %9s %9s\n", "sensor", "plan", "samples/s", "merged", "overruns", "skipped");
+    for(uint32_t i = 0; i < fleet.Count(); i++) {
+        auto &f = fleet.Sensor(i);
+        printf("%-12s %-18s %9.1f %9u %9u %9u\n", f.name.c_str(), f.acquisition.ModeName(f.acquisition.GetPlan().mode),
+            f.acquisition.Cycles() / elapsed_s, f.merged, f.acquisition.samples.Overruns(),
+            f.acquisition.ScheduleStatistics().skippedPeriods);
+    }
+    std::sort(mergeDelay.begin(), mergeDelay.end());
+    printf("merged: %.1f samples/s from %u sensors, %u failures, %u out of order, sample-to-merge p50 %uus p99 %uus\n",
+        merged / elapsed_s, fleet.Count(), failures, fleet.outOfOrder,
+        Percentile(mergeDelay, 0.50), Percentile(mergeDelay, 0.99));
+    return 0;
+}
+
+/// --mux coroutines: one task per sensor, each awaiting its measurements in turn...
+template <typename TCOMPASS>
+static MMC5983MA_Task_C MeasureTask(MMC5983MA_EventLoop_C &loop, TCOMPASS &compass,
+    MMC5983MA_MeasurementMode_T mode, uint32_t count, uint32_t &failures, uint32_t &running) {
+    for(uint32_t n = 0; n < count; n++) {
+        MMC5983MA_Sample_T s = co_await loop.Measure(compass, mode);
+        if(!s.Ok()) failures++;
+    }
+    running--;
+}
+/// ...and other work on the same thread meanwhile: a 1kHz tick
+static MMC5983MA_Task_C TickTask(MMC5983MA_EventLoop_C &loop, const uint32_t &running, uint32_t &ticks) {
+    while(running) {
+        co_await loop.Sleep_us(1000);
+        ticks++;
+    }
+}
+
+/// --mux: N sensors sharing one bus, measured one after another (each Measure_XYZ_Field_* waits out
+/// its own conversions), then interleaved by MMC5983MA_BusScheduler_C, then by coroutines
+template <typename TBUS>
+static int RunMux(const Options_T &opt, void (*configure)(TBUS &) = nullptr) {
+    typedef MMC5983MA_BusScheduler_C<TBUS, 1024> Scheduler_T;
+    auto sched = std::make_unique<Scheduler_T>();
+    if(configure) configure(sched->bus.adapter);
+    for(uint32_t ch = 0; ch < opt.mux; ch++) sched->Add((uint8_t)ch);
+    if(sched->Init() != 0) { fprintf(stderr, "%s: sensor initialization failed\n", opt.device.c_str()); return 2; }
+    printf("%-8s %-9s %7s %9s %9s %9s %7s %6s\n", "device", "mode", "sensors", "method", "samples/s", "switch/s", "idle%", "fail");
+    for(MMC5983MA_MeasurementMode_T mode : { MMC5983MA_MeasurementMode_T::ResetSet, MMC5983MA_MeasurementMode_T::AutoSR }) {
+        const char *modeName = mode == MMC5983MA_MeasurementMode_T::ResetSet ? "ResetSet" : "AutoSR";
+        auto measure = [&](uint32_t idx) { return sched->Compass(idx).Measure(mode).result; };
+        // Sequential (also the warmup: conversion timing learned before either is timed)
+        for(uint32_t n = 0; n < opt.warmup; n++)
+            for(uint32_t i = 0; i < sched->Count(); i++) (void)measure(i);
+        uint32_t failures = 0, switches = sched->bus.channelSwitches;
+        uint64_t t0 = sched->bus.adapter.time_us();
+        for(uint32_t n = 0; n < opt.samples; n++)
+            for(uint32_t i = 0; i < sched->Count(); i++)
+                if(measure(i) != 0) failures++;
+        double elapsed_s = (sched->bus.adapter.time_us() - t0) / 1e6;
+        double total = (double)opt.samples * sched->Count();
+        double sequential = total / elapsed_s;
+        printf("%-8s %-9s %7u %9s %9.1f %9.2f %7s %6u\n", opt.device.c_str(), modeName, sched->Count(), "serial",
+            sequential, (sched->bus.channelSwitches - switches) / total, "-", failures);
+        // Interleaved
+        sched->mode = mode;
+        sched->Restart();
+        sched->stats = {};
+        switches = sched->bus.channelSwitches;
+        t0 = sched->bus.adapter.time_us();
+        int8_t rslt = sched->Run(opt.samples);
+        uint64_t elapsed_us = sched->bus.adapter.time_us() - t0;
+        MMC5983MA_BusSample_T s;
+        while(sched->samples.Pop(s)) {}
+        double interleaved = sched->stats.measurements / (elapsed_us / 1e6);
+        printf("%-8s %-9s %7u %9s %9.1f %9.2f %6.1f%% %6u   x%.2f, %.2f steps/sample\n",
+            opt.device.c_str(), modeName, sched->Count(), "scheduled", interleaved,
+            (double)(sched->bus.channelSwitches - switches) / sched->stats.measurements,
+            100.0 * sched->stats.idle_us / elapsed_us, sched->stats.failures, interleaved / sequential,
+            (double)sched->stats.operations / sched->stats.measurements);
+        if(rslt < 0) { fprintf(stderr, "%s: IO failure\n", opt.device.c_str()); return 1; }
+        // Coroutines, on the bus's clock
+        MMC5983MA_EventLoop_C loop;
+        loop.now_us = [&sched]() { return sched->bus.adapter.time_us(); };
+        loop.sleep_us = [&sched](uint32_t us) { sched->bus.adapter.delay_us(us); };
+        uint32_t running = sched->Count(), ticks = 0;
+        failures = 0;
+        switches = sched->bus.channelSwitches;
+        t0 = sched->bus.adapter.time_us();
+        for(uint32_t i = 0; i < sched->Count(); i++)
+            loop.Spawn(MeasureTask(loop, sched->Compass(i), mode, opt.samples, failures, running));
+        loop.Spawn(TickTask(loop, running, ticks));
+        loop.Run();
+        elapsed_us = sched->bus.adapter.time_us() - t0;
+        double coroutines = total / (elapsed_us / 1e6);
+        printf("%-8s %-9s %7u %9s %9.1f %9.2f %6.1f%% %6u   x%.2f, %u ticks (%.0f/s) between\n",
+            opt.device.c_str(), modeName, sched->Count(), "coroutine", coroutines,
+            (sched->bus.channelSwitches - switches) / total, 100.0 * loop.stats.idle_us / elapsed_us, failures,
+            coroutines / sequential, ticks, ticks / (elapsed_us / 1e6));
+    }
+    printf("(switch/s = mux writes per sample, idle%% = bus time with no sensor step due)\n");
+    return 0;
+}
+
+static void PrintTable(const std::vector<Result_T> &results) {
+    printf("%-8s %-9s %-6s %9s %8s %8s %8s %8s %9s %6s %9s %8s %8s %8s\n",
+        "device", "mode", "bw", "samples/s", "p50 us", "p99 us", "max us",
+        "xact/smp", "bytes/smp", "fail", "flush/smp", "sleep%", "wire%", "usb/smp");
+    for(const Result_T &r : results) {
+        double n = r.samples ? r.samples : 1;
+        double total = (double)(r.sleep_us + r.wire_us + r.other_us);
+        if(total == 0) total = 1;
+        char usb[16] = "-";
+        if(r.usbRoundTrips >= 0) snprintf(usb, sizeof(usb), "%.2f", r.usbRoundTrips / n);
+        printf("%-8s %-9s %-6s %9.1f %8u %8u %8u %8.2f %9.1f %6u %9.2f %7.1f%% %7.1f%% %8s\n",
+            r.device.c_str(), r.mode.c_str(), r.bandwidth.c_str(), r.samplesPerSecond,
+            r.p50_us, r.p99_us, r.max_us, r.transactions / n, r.bytes / n, r.failures, r.flushes / n,
+            100.0 * r.sleep_us / total, 100.0 * r.wire_us / total, usb);
+    }
+}
+
+static const char CsvHeader[] =
+    "device,mode,bandwidth,samples,failures,samples_per_s,p50_us,p99_us,max_us,"
+    "transactions,bytes,flushes,fallbacks,sleep_us,wire_us,other_us,usb_round_trips\n";
+
+static bool WriteCSV(const char *path, const std::vector<Result_T> &results) {
+    FILE *f = fopen(path, "w");
+    if(!f) return false;
+    fputs(CsvHeader, f);
+    for(const Result_T &r : results)
+        fprintf(f, "%s,%s,%s,%u,%u,%.3f,%u,%u,%u,%u,%u,%u,%u,%llu,%llu,%llu,%lld\n",
+            r.device.c_str(), r.mode.c_str(), r.bandwidth.c_str(), r.samples, r.failures, r.samplesPerSecond,
+            r.p50_us, r.p99_us, r.max_us, r.transactions, r.bytes, r.flushes, r.fallbacks,
+            (unsigned long long)r.sleep_us, (unsigned long long)r.wire_us, (unsigned long long)r.other_us,
+            (long long)r.usbRoundTrips);
+    fclose(f);
+    return true;
+}
+
+static bool WriteJSON(const char *path, const std::vector<Result_T> &results) {
+    FILE *f = fopen(path, "w");
+    if(!f) return false;
+    fprintf(f, "[\n");
+    for(size_t i = 0; i < results.size(); i++) {
+        const Result_T &r = results[i];
+        fprintf(f, "  {\"device\":\"%s\",\"mode\":\"%s\",\"bandwidth\":\"%s\",\"samples\":%u,\"failures\":%u,"
+                   "\"samples_per_s\":%.3f,\"p50_us\":%u,\"p99_us\":%u,\"max_us\":%u,"
+                   "\"transactions\":%u,\"bytes\":%u,\"flushes\":%u,\"fallbacks\":%u,"
+                   "\"sleep_us\":%llu,\"wire_us\":%llu,\"other_us\":%llu,\"usb_round_trips\":%lld}%s\n",
+            r.device.c_str(), r.mode.c_str(), r.bandwidth.c_str(), r.samples, r.failures, r.samplesPerSecond,
+            r.p50_us, r.p99_us, r.max_us, r.transactions, r.bytes, r.flushes, r.fallbacks,
+            (unsigned long long)r.sleep_us, (unsigned long long)r.wire_us, (unsigned long long)r.other_us,
+            (long long)r.usbRoundTrips, i+1 < results.size() ? "," : "");
+    }
+    fprintf(f, "]\n");
+    fclose(f);
+    return true;
+}
+
+/// Compare against a --csv file from an earlier run. A configuration regresses if its throughput
+/// drops, or its p99 latency or per-sample bus traffic grows, by more than tolerance_pct.
+/// Returns the number of regressions found (configurations missing from the baseline are skipped).
+static int CompareBaseline(const char *path, double tolerance_pct, const std::vector<Result_T> &results) {
+    FILE *f = fopen(path, "r");
+    if(!f) { fprintf(stderr, "Can't open baseline '%s'\n", path); return 1; }
+    const double tol = tolerance_pct / 100;
+    int regressions = 0, compared = 0;
+    char line[512];
+    while(fgets(line, sizeof(line), f)) {
+        char device[32], mode[32], bandwidth[32];
+        Result_T b = {};
+        unsigned long long sleep_us, wire_us, other_us; long long usb;
+        if(sscanf(line, "%31[^,],%31[^,],%31[^,],%u,%u,%lf,%u,%u,%u,%u,%u,%u,%u,%llu,%llu,%llu,%lld",
+                device, mode, bandwidth, &b.samples, &b.failures, &b.samplesPerSecond,
+                &b.p50_us, &b.p99_us, &b.max_us, &b.transactions, &b.bytes, &b.flushes, &b.fallbacks,
+                &sleep_us, &wire_us, &other_us, &usb) != 17) continue; // header or junk
+        for(const Result_T &r : results) {
+            if(r.device != device || r.mode != mode || r.bandwidth != bandwidth) continue;
+            compared++;
+            double bn = b.samples ? b.samples : 1, rn = r.samples ? r.samples : 1;
+            auto check = [&](const char *what, double was, double now, bool higherIsWorse) {
+                bool worse = higherIsWorse ? now > was * (1 + tol) : now < was * (1 - tol);
+                if(!worse) return;
+                regressions++;
+                printf("REGRESSION %s %s %s: %s %.2f -> %.2f\n", device, mode, bandwidth, what, was, now);
+            };
+            check("samples/s", b.samplesPerSecond, r.samplesPerSecond, false);
+            check("p99 latency us", b.p99_us, r.p99_us, true);
+            check("transactions/sample", b.transactions / bn, r.transactions / rn, true);
+            check("bytes/sample", b.bytes / bn, r.bytes / rn, true);
+            if(r.failures > b.failures) {
+                regressions++;
+                printf("REGRESSION %s %s %s: failures %u -> %u\n", device, mode, bandwidth, b.failures, r.failures);
+            }
+        }
+    }
+    fclose(f);
+    printf("Baseline %s: %d configurations compared, %d regressions (tolerance %.1f%%)\n",
+        path, compared, regressions, tolerance_pct);
+    return regressions;
+}
+
+static void Usage() {
+    fprintf(stderr,
+        "usage: MMC5983MA_Benchmark [options]\n"
+        "  --device sim|sim-spi|emu|ft232h"
+#ifdef _WIN32
+        "|mcp2221"
+#endif
+        "  IO backend (default sim)\n"
+        "  --samples N            timed samples per mode/bandwidth (default 200)\n"
+        "  --warmup N             untimed samples first (default 20)\n"
+        "  --sim-transaction-us N simulator cost of one bus transaction (default 1000)\n"
+        "  --csv FILE             write results as CSV\n"
+        "  --json FILE            write results as JSON\n"
+        "  --baseline FILE        compare with an earlier --csv; exit 1 on regression\n"
+        "  --tolerance PCT        allowed change before a regression is reported (default 10)\n"
+        "  --trace FILE           record register IO (decode with MMC5983MA_TraceDecode)\n"
+        "  --allan FILE           write each mode/bandwidth's Allan deviation (CSV); print noise floors\n"
+        "  --capture FILE         record every timed measurement (binary capture, MMC5983MA_Capture.hpp)\n"
+        "  --int                  wait for the sensor's INT pin (FT232H: wired to AD5/GPIOL1)\n"
+        "  --fleet N              N sensors (adapters 0..N-1) in parallel, merged by time\n"
+        "  --period-us N          fleet: acquisition period per sensor (default 10000)\n"
+        "  --seconds S            fleet: run time (default 2)\n"
+        "  --mux N                N sensors behind one adapter's I2C mux: serial vs. interleaved\n"
+        "  --transfers N          emu/ft232h: libMPSSE arena vs. old allocate-and-purge, N reads+writes each\n"
+        "  --verbose              driver/adapter diagnostics and emulator statistics\n");
+}
+
+int main(int argc, char **argv) {
+    Options_T opt;
+    for(int i = 1; i < argc; i++) {
+        const char *a = argv[i];
+        const char *v = i+1 < argc ? argv[i+1] : nullptr;
+        if(!strcmp(a, "--verbose")) { verbose = true; continue; }
+        if(!strcmp(a, "--int"))     { opt.dataReady = true; continue; }
+        if(!v) { Usage(); return 2; }
+        if     (!strcmp(a, "--device"))            opt.device = v;
+        else if(!strcmp(a, "--samples"))           opt.samples = (uint32_t)atoi(v);
+        else if(!strcmp(a, "--warmup"))            opt.warmup = (uint32_t)atoi(v);
+        else if(!strcmp(a, "--sim-transaction-us")) opt.simTransaction_us = (uint32_t)atoi(v);
+        else if(!strcmp(a, "--csv"))               opt.csvPath = v;
+        else if(!strcmp(a, "--json"))              opt.jsonPath = v;
+        else if(!strcmp(a, "--baseline"))          opt.baselinePath = v;
+        else if(!strcmp(a, "--tolerance"))         opt.tolerance_pct = atof(v);
+        else if(!strcmp(a, "--trace"))             opt.tracePath = v;
+        else if(!strcmp(a, "--allan"))             opt.allanPath = v;
+        else if(!strcmp(a, "--capture"))           opt.capturePath = v;
+        else if(!strcmp(a, "--fleet"))             opt.fleet = (uint32_t)atoi(v);
+        else if(!strcmp(a, "--period-us"))         opt.period_us = (uint32_t)atoi(v);
+        else if(!strcmp(a, "--seconds"))           opt.seconds = atof(v);
+        else if(!strcmp(a, "--mux"))               opt.mux = (uint32_t)atoi(v);
+        else if(!strcmp(a, "--transfers"))         opt.transfers = (uint32_t)atoi(v);
+        else { Usage(); return 2; }
+        i++;
+    }
+
+    if(opt.tracePath) {
+        traceFile = fopen(opt.tracePath, "wb");
+        if(!traceFile || !MMC5983MA_Trace_C::WriteFileHeader(traceFile)) { fprintf(stderr, "Can't write '%s'\n", opt.tracePath); return 2; }
+    }
+    if(opt.allanPath) {
+        allanFile = fopen(opt.allanPath, "w");
+        if(!allanFile) { fprintf(stderr, "Can't write '%s'\n", opt.allanPath); return 2; }
+        fprintf(allanFile, "device,mode,bandwidth,axis,tau_s,m,adev_mG,terms\n");
+    }
+    static uint32_t simTransaction_us; // captureless configure functions below
+    simTransaction_us = opt.simTransaction_us;
+    struct SimulatorSPI_C : public MMC5983MA_IO_Simulator_C { SimulatorSPI_C() : MMC5983MA_IO_Simulator_C(SPI) {}; };
+    if(opt.fleet) {
+        if(opt.device == "sim")    return RunFleet<MMC5983MA_IO_Simulator_C>(opt);
+        if(opt.device == "emu" && opt.fleet > FT232H_Emulator_C::MaxDevices) {
+            fprintf(stderr, "At most %d emulated FT232H\n", FT232H_Emulator_C::MaxDevices);
+            return 2;
+        }
+        if(opt.device == "emu")    return RunFleet<MMC5983MA_IO_EmulatedFT232H_C>(opt,
+            [](MMC5983MA_IO_EmulatedFT232H_C &d, uint32_t i) { d.channelIndex = i; }); // installed in Open order
+        if(opt.device == "ft232h") return RunFleet<MMC5983MA_IO_WindowsQwiic_FT232H_C>(opt,
+            [](MMC5983MA_IO_WindowsQwiic_FT232H_C &d, uint32_t i) { d.channelIndex = i; });
+#ifdef _WIN32
+        if(opt.device == "mcp2221") return RunFleet<MMC5983MA_IO_WindowsQwiic_MCP2221_C>(opt,
+            [](MMC5983MA_IO_WindowsQwiic_MCP2221_C &d, uint32_t i) { d.mcp2221.openIndex = i; });
+#endif
+        Usage();
+        return 2;
+    }
+    if(opt.mux) {
+        if(opt.mux > 8) { fprintf(stderr, "A mux has at most 8 channels\n"); return 2; }
+        if(opt.device == "sim")    return RunMux<MMC5983MA_IO_SimulatedMuxBus_C>(opt,
+            [](MMC5983MA_IO_SimulatedMuxBus_C &d) { d.transactionTime_us = simTransaction_us; });
+        if(opt.device == "ft232h") return RunMux<MMC5983MA_IO_WindowsQwiic_FT232H_C>(opt);
+#ifdef _WIN32
+        if(opt.device == "mcp2221") return RunMux<MMC5983MA_IO_WindowsQwiic_MCP2221_C>(opt);
+#endif
+        Usage(); // the emulator has no mux
+        return 2;
+    }
+    std::vector<Result_T> results;
+    int rc;
+    if(opt.device == "sim")
+        rc = RunBackend<MMC5983MA_IO_Simulator_C>(opt, results,
+            [](MMC5983MA_IO_Simulator_C &d) { d.transactionTime_us = simTransaction_us; });
+    else if(opt.device == "sim-spi")
+        rc = RunBackend<SimulatorSPI_C>(opt, results,
+            [](SimulatorSPI_C &d) { d.transactionTime_us = simTransaction_us; });
+    else if(opt.device == "emu")
+        rc = RunBackend<MMC5983MA_IO_EmulatedFT232H_C>(opt, results);
+    else if(opt.device == "ft232h")
+        rc = RunBackend<MMC5983MA_IO_WindowsQwiic_FT232H_C>(opt, results);
+#ifdef _WIN32
+    else if(opt.device == "mcp2221")
+        rc = RunBackend<MMC5983MA_IO_WindowsQwiic_MCP2221_C>(opt, results);
+#endif
+    else { Usage(); return 2; }
+    if(traceFile) {
+        registerTrace.WriteFile(traceFile);
+        fclose(traceFile);
+        if(registerTrace.Dropped()) fprintf(stderr, "%u trace records dropped\n", registerTrace.Dropped());
+    }
+    if(allanFile) fclose(allanFile);
+    if(rc != 0) return rc;
+
+    PrintTable(results);
+    if(opt.csvPath  && !WriteCSV(opt.csvPath, results))   { fprintf(stderr, "Can't write '%s'\n", opt.csvPath);  return 2; }
+    if(opt.jsonPath && !WriteJSON(opt.jsonPath, results)) { fprintf(stderr, "Can't write '%s'\n", opt.jsonPath); return 2; }
+    if(opt.baselinePath && CompareBaseline(opt.baselinePath, opt.tolerance_pct, results) != 0) return 1;
+    return 0;
+}
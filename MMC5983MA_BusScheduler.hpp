@@ -0,0 +1,170 @@
+/// MMC5983MA_BusScheduler.hpp - MMC5983MA_BusScheduler_C class - interleave measurements of several MMC5983MA sharing one I2C bus.
+
+/*
+MIT License
+
+Copyright (c) 2023-2025 Dave Nadler
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#ifndef MMC5983MA_BUSSCHEDULER_HPP_INCLUDED
+#define MMC5983MA_BUSSCHEDULER_HPP_INCLUDED
+
+#include <stdint.h>
+#include <memory>
+#include <vector>
+#include "MMC5983MA.hpp"
+#include "MMC5983MA_IO_Mux.hpp"
+#include "MMC5983MA_Ring.hpp"
+
+/// One measurement completed by MMC5983MA_BusScheduler_C
+struct MMC5983MA_BusSample_T {
+    uint32_t sensor;           ///< which sensor (index in order of MMC5983MA_BusScheduler_C::Add)
+    MMC5983MA_Sample_T sample; ///< times are bus time (TBUS::time_us)
+};
+
+/// Measures several MMC5983MA on one I2C bus (behind a mux, see MMC5983MA_IO_Mux.hpp) by interleaving them.
+/// A conversion takes milliseconds during which its sensor needs no bus traffic; instead of waiting, as
+/// sequential Measure_XYZ_Field_* calls do, the bus serves whichever sensor's next step is due: pulse,
+/// start conversion, or poll-and-fetch (MMC5983MA_C::PollMeasurement, one transaction each).
+/// Each sensor keeps its required spacing (RequiredWaitAfterMagnetizePulse_uSec after a pulse, the learned
+/// conversion time before the first poll); the bus idles only when no sensor has a step due.
+/// Of the steps already due, the connected sensor's goes first (no mux write).
+/// N sensors approach N times the throughput of one, until the bus is busy all the time.
+/// Single-threaded: the sensors and their bus belong to the thread calling Init, Step, and Run.
+template <typename TBUS, size_t CAPACITY = 256>
+class MMC5983MA_BusScheduler_C {
+  public:
+    /// MMC5983MA_C with its IO device reachable, to set bus and channel before Init
+    class Compass_C : public MMC5983MA_C<MMC5983MA_IO_MuxChannel_C<TBUS>> {
+      public:
+        MMC5983MA_IO_MuxChannel_C<TBUS> &Dev() { return this->dev; };
+        const MMC5983MA_IO_MuxChannel_C<TBUS> &Dev() const { return this->dev; };
+    };
+    struct Statistics_T {
+        uint32_t operations;   ///< sensor steps performed (pulse, start conversion, poll)
+        uint32_t measurements; ///< measurements completed, all sensors
+        uint32_t failures;     ///< measurements abandoned on IO failure (restarted)
+        uint64_t idle_us;      ///< time the bus waited with no step due
+    };
+
+    MMC5983MA_MuxedBus_C<TBUS> bus; ///< adapter and mux shared by all sensors
+    MMC5983MA_MeasurementMode_T mode = MMC5983MA_MeasurementMode_T::ResetSet; ///< ResetSet or AutoSR; set before Init or Restart
+    MMC5983MA_Ring_C<MMC5983MA_BusSample_T, CAPACITY> samples; ///< completed measurements, in completion order
+    Statistics_T stats = {};
+
+    /// Add a sensor wired to mux channel (0-7); returns its index. Add all sensors before Init.
+    uint32_t Add(uint8_t channel) {
+        sensors.push_back(std::make_unique<Sensor_T>());
+        Sensor_T &s = *sensors.back();
+        s.compass.Dev().bus = &bus;
+        s.compass.Dev().channel = channel;
+        return (uint32_t)(sensors.size() - 1);
+    }
+    uint32_t Count() const { return (uint32_t)sensors.size(); };
+    Compass_C &Compass(uint32_t idx) { return sensors[idx]->compass; };
+    /// Measurements completed by one sensor
+    uint32_t Completed(uint32_t idx) const { return sensors[idx]->completed; };
+
+    /// Initialize the adapter and each sensor in turn, then Restart. Returns -1 if any sensor failed.
+    int8_t Init() {
+        for(auto &s : sensors)
+            if(s->compass.Init() != 0) return -1;
+        Restart();
+        return 0;
+    }
+    /// Abandon measurements in progress; every sensor starts a new one (in the current mode) when next served
+    void Restart() {
+        for(auto &s : sensors) s->starting = true;
+    }
+
+    /// Perform one sensor's due step, first waiting for it if no step is due yet.
+    /// Returns 1 if that completed a measurement (pushed to samples), 0 if not,
+    /// -1 on IO failure (that sensor's measurement is abandoned and restarted).
+    int8_t Step() {
+        if(sensors.empty()) return 0;
+        uint64_t now = bus.adapter.time_us();
+        // Of the steps already due, prefer the connected sensor's (no mux write); otherwise take the earliest.
+        uint32_t pick = 0;
+        for(uint32_t i = 1; i < sensors.size(); i++) {
+            const Sensor_T &s = *sensors[i], &p = *sensors[pick];
+            bool sDue = Due_us(s) <= now, pDue = Due_us(p) <= now;
+            if(sDue && pDue && Connected(s) != Connected(p)) {
+                if(Connected(s)) pick = i;
+            } else if(Due_us(s) < Due_us(p)) {
+                pick = i;
+            }
+        }
+        Sensor_T &s = *sensors[pick];
+        if(Due_us(s) > now) {
+            uint32_t idle = (uint32_t)(Due_us(s) - now);
+            stats.idle_us += idle;
+            bus.adapter.delay_us(idle);
+        }
+        stats.operations++;
+        Compass_C &c = s.compass;
+        int8_t rslt;
+        if(s.starting) {
+            rslt = c.StartMeasurement(mode);
+            s.starting = false;
+        } else {
+            rslt = c.PollMeasurement();
+        }
+        if(rslt < 0) {
+            stats.failures++;
+            bus.Invalidate();
+            s.starting = true;
+            return -1;
+        }
+        if(rslt == 0) return 0;
+        s.starting = true;
+        s.completed++;
+        samples.Push(MMC5983MA_BusSample_T{ pick, c.LastSample() });
+        stats.measurements++;
+        return 1;
+    }
+    /// Step until every sensor has completed measurementsPerSensor more measurements (sensors that
+    /// finish first keep measuring meanwhile). Returns -1 on IO failure.
+    int8_t Run(uint32_t measurementsPerSensor) {
+        std::vector<uint32_t> target;
+        for(auto &s : sensors) target.push_back(s->completed + measurementsPerSensor);
+        for(;;) {
+            bool done = true;
+            for(size_t i = 0; i < sensors.size(); i++)
+                if(sensors[i]->completed < target[i]) done = false;
+            if(done) return 0;
+            if(Step() < 0) return -1;
+        }
+    }
+
+  protected:
+    struct Sensor_T {
+        Compass_C compass;     ///< its measurement in progress is the scheduler's per-sensor state
+        bool starting = true;  ///< next step starts a new measurement
+        uint32_t completed = 0;
+    };
+    std::vector<std::unique_ptr<Sensor_T>> sensors; ///< stable addresses (each holds its IO device)
+
+    static uint64_t Due_us(const Sensor_T &s) { return s.starting ? 0 : s.compass.MeasurementDue_us(); };
+    bool Connected(const Sensor_T &s) const { return bus.Selected() == (int)s.compass.Dev().channel; };
+};
+
+#endif // MMC5983MA_BUSSCHEDULER_HPP_INCLUDED
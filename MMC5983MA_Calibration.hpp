@@ -0,0 +1,258 @@
+/// MMC5983MA_Calibration.hpp - MMC5983MA_EllipsoidCalibration_C class - streaming hard/soft-iron calibration.
+
+/*
+MIT License
+
+Copyright (c) 2023-2025 Dave Nadler
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#ifndef MMC5983MA_CALIBRATION_HPP_INCLUDED
+#define MMC5983MA_CALIBRATION_HPP_INCLUDED
+
+#include <stdint.h>
+#include <math.h>
+
+/// Hard- and soft-iron calibration by least-squares ellipsoid fit, updated as samples arrive.
+/// Rotated in a constant field, an ideal sensor's readings lie on a sphere centered on zero.
+/// Hard iron (and residual offset) moves the center; soft iron and per-axis gain mismatch stretch and
+/// tilt the sphere into an ellipsoid. The fit finds that ellipsoid,
+///   u'Au + 2v'u = 1   (u = field/scale_mG, A symmetric: 9 unknowns),
+/// from running sums of the normal equations: Add costs a fixed 54 multiply-adds and no sample is kept.
+/// Solve, at any time, turns the sums into a correction (bias, then 3x3 matrix) mapping the ellipsoid
+/// back onto a sphere of the fitted field strength.
+/// Until the samples cover enough orientations for the full fit, Solve falls back to an axis-aligned
+/// ellipsoid (per-axis gain, no cross-axis terms), then to a sphere (bias only). Turning the sensor
+/// only while level is not enough for any of them: it must be tilted too.
+class MMC5983MA_EllipsoidCalibration_C {
+  public:
+    typedef enum : uint8_t {
+        None,        ///< not enough coverage yet: identity correction
+        Sphere,      ///< bias only (hard iron)
+        AxisAligned, ///< bias and per-axis gain
+        Ellipsoid,   ///< bias and full 3x3 soft-iron correction
+    } Model_T;
+    static const char *ModelName(Model_T m) {
+        switch(m) {
+          case Sphere:      return "hard iron";
+          case AxisAligned: return "hard iron + axis gains";
+          case Ellipsoid:   return "hard + soft iron";
+          default:          return "none yet";
+        }
+    }
+    /// Result of Solve: corrected = matrix * (raw - bias_mG)
+    struct Correction_T {
+        Model_T model = None;
+        double matrix[3][3] = { {1,0,0}, {0,1,0}, {0,0,1} };
+        double bias_mG[3] = { 0, 0, 0 };
+        double radius_mG = 0;    ///< field strength the corrected samples have
+        double fitError = 0;     ///< RMS distance of the samples from the fitted ellipsoid, as a fraction of radius
+        uint32_t samples = 0;    ///< samples the fit used
+        void Apply(const double (&raw_mG)[3], double (&corrected_mG)[3]) const {
+            double d[3] = { raw_mG[0] - bias_mG[0], raw_mG[1] - bias_mG[1], raw_mG[2] - bias_mG[2] };
+            for(int i = 0; i < 3; i++)
+                corrected_mG[i] = matrix[i][0]*d[0] + matrix[i][1]*d[1] + matrix[i][2]*d[2];
+        }
+    };
+
+    double scale_mG = 500;      ///< inputs are divided by this (about Earth's field) to keep the sums well conditioned
+    double maxAxisRatio = 2.0;  ///< reject fits whose ellipsoid axes differ more than this (poor coverage, not iron)
+    double maxRadiusToSpread = 3.0; ///< reject fits whose radius exceeds the samples' RMS spread this much
+                                    ///< (samples from too small a range of orientations, for example all level)
+    uint32_t minSamples = 30;   ///< fewer than this: model None
+
+    MMC5983MA_EllipsoidCalibration_C() { Reset(); };
+    void Reset() {
+        for(int i = 0; i < 9; i++) {
+            b[i] = 0;
+            for(int j = 0; j < 9; j++) m[i][j] = 0;
+        }
+        n = 0;
+    }
+    uint32_t Samples() const { return n; };
+    /// Accumulate one sample (field in mG)
+    void Add(const double (&field_mG)[3]) {
+        double x = field_mG[0] / scale_mG, y = field_mG[1] / scale_mG, z = field_mG[2] / scale_mG;
+        const double d[9] = { x*x, y*y, z*z, 2*x*y, 2*x*z, 2*y*z, 2*x, 2*y, 2*z };
+        for(int i = 0; i < 9; i++) {
+            b[i] += d[i];
+            for(int j = i; j < 9; j++) m[i][j] += d[i]*d[j]; // upper triangle
+        }
+        n++;
+    }
+    /// Best correction the samples so far support (the sums are unchanged; keep adding and solve again later)
+    Correction_T Solve() const {
+        Correction_T c;
+        c.samples = n;
+        if(n < minSamples) return c;
+        // Each model constrains the 9 ellipsoid parameters p to p = T'q, q the model's own parameters
+        static const double full[9][9] = {
+            {1,0,0,0,0,0,0,0,0}, {0,1,0,0,0,0,0,0,0}, {0,0,1,0,0,0,0,0,0}, {0,0,0,1,0,0,0,0,0}, {0,0,0,0,1,0,0,0,0},
+            {0,0,0,0,0,1,0,0,0}, {0,0,0,0,0,0,1,0,0}, {0,0,0,0,0,0,0,1,0}, {0,0,0,0,0,0,0,0,1} };
+        static const double axis[6][9] = {
+            {1,0,0,0,0,0,0,0,0}, {0,1,0,0,0,0,0,0,0}, {0,0,1,0,0,0,0,0,0},
+            {0,0,0,0,0,0,1,0,0}, {0,0,0,0,0,0,0,1,0}, {0,0,0,0,0,0,0,0,1} };
+        static const double sphere[4][9] = {
+            {1,1,1,0,0,0,0,0,0}, {0,0,0,0,0,0,1,0,0}, {0,0,0,0,0,0,0,1,0}, {0,0,0,0,0,0,0,0,1} };
+        if(Fit(full, c))   { c.model = Ellipsoid;   return c; }
+        if(Fit(axis, c))   { c.model = AxisAligned; return c; }
+        if(Fit(sphere, c)) { c.model = Sphere;      return c; }
+        return c;
+    }
+
+  protected:
+    double m[9][9]; ///< sum of d d' (upper triangle), d = the sample's row of the design matrix
+    double b[9];    ///< sum of d
+    uint32_t n;
+
+    double M(int i, int j) const { return i <= j ? m[i][j] : m[j][i]; };
+
+    /// Least-squares fit with p = T'q (T is K x 9); on success fill c (except model) and return true
+    template <int K>
+    bool Fit(const double (&T)[K][9], Correction_T &c) const {
+        // Reduced normal equations: (T M T') q = T b
+        double a[9][9], r[9], q[9];
+        for(int i = 0; i < K; i++) {
+            r[i] = 0;
+            for(int s = 0; s < 9; s++) r[i] += T[i][s] * b[s];
+            for(int j = 0; j < K; j++) {
+                double sum = 0;
+                for(int s = 0; s < 9; s++) {
+                    if(T[i][s] == 0) continue;
+                    for(int t = 0; t < 9; t++) if(T[j][t] != 0) sum += T[i][s] * M(s, t) * T[j][t];
+                }
+                a[i][j] = sum;
+            }
+        }
+        if(!SolveCholesky(a, r, q, K)) return false;
+        double p[9] = {0};
+        for(int i = 0; i < K; i++)
+            for(int s = 0; s < 9; s++) p[s] += T[i][s] * q[i];
+        // Ellipsoid u'Au + 2v'u = 1 -> center = -A^-1 v, and (u-center)'A(u-center) = 1 - center'v
+        double A[3][3] = { {p[0], p[3], p[4]}, {p[3], p[1], p[5]}, {p[4], p[5], p[2]} };
+        double lambda[3], V[3][3];
+        EigenSymmetric3(A, lambda, V);
+        for(int i = 0; i < 3; i++) if(!(lambda[i] > 0)) return false; // not an ellipsoid
+        double center[3], w[3];
+        for(int i = 0; i < 3; i++) w[i] = (V[0][i]*p[6] + V[1][i]*p[7] + V[2][i]*p[8]) / lambda[i];
+        for(int i = 0; i < 3; i++) center[i] = -(V[i][0]*w[0] + V[i][1]*w[1] + V[i][2]*w[2]);
+        double scale = 1 - (center[0]*p[6] + center[1]*p[7] + center[2]*p[8]);
+        if(!(scale > 0)) return false;
+        // Semi-axes sqrt(scale/lambda); correct onto a sphere of their geometric mean
+        double axisLen[3], minAxis = 1e300, maxAxis = 0;
+        for(int i = 0; i < 3; i++) {
+            axisLen[i] = sqrt(scale / lambda[i]);
+            if(axisLen[i] < minAxis) minAxis = axisLen[i];
+            if(axisLen[i] > maxAxis) maxAxis = axisLen[i];
+        }
+        if(maxAxis > maxAxisRatio * minAxis) return false;
+        double radius = cbrt(axisLen[0] * axisLen[1] * axisLen[2]);
+        // Spread: RMS distance of the samples from their mean (d holds x^2.. and 2x..)
+        double mean2 = 0;
+        for(int i = 0; i < 3; i++) mean2 += (b[6+i] / (2.0*n)) * (b[6+i] / (2.0*n));
+        double spread2 = (b[0] + b[1] + b[2]) / n - mean2;
+        if(!(spread2 > 0) || radius > maxRadiusToSpread * sqrt(spread2)) return false;
+        for(int i = 0; i < 3; i++)
+            for(int j = 0; j < 3; j++) {
+                double sum = 0;
+                for(int e = 0; e < 3; e++) sum += V[i][e] * (radius / axisLen[e]) * V[j][e];
+                c.matrix[i][j] = sum;
+            }
+        for(int i = 0; i < 3; i++) c.bias_mG[i] = center[i] * scale_mG;
+        c.radius_mG = radius * scale_mG;
+        // Sum of squared residuals (d'p - 1)^2 = p'Mp - 2p'b + n; a residual e is about 2e/scale relative error in radius
+        double ss = n;
+        for(int i = 0; i < 9; i++) {
+            ss -= 2 * p[i] * b[i];
+            for(int j = 0; j < 9; j++) ss += p[i] * M(i, j) * p[j];
+        }
+        c.fitError = ss > 0 ? sqrt(ss / n) / (2 * scale) : 0;
+        return true;
+    }
+
+    /// Solve a x = r (a symmetric positive definite, k x k); false if singular (samples don't determine the model)
+    static bool SolveCholesky(double (&a)[9][9], const double (&r)[9], double (&x)[9], int k) {
+        double maxDiag = 0;
+        for(int i = 0; i < k; i++) if(a[i][i] > maxDiag) maxDiag = a[i][i];
+        for(int j = 0; j < k; j++) {
+            double d = a[j][j];
+            for(int s = 0; s < j; s++) d -= a[j][s] * a[j][s];
+            if(!(d > maxDiag * 1e-12)) return false;
+            a[j][j] = sqrt(d);
+            for(int i = j+1; i < k; i++) {
+                double v = a[i][j];
+                for(int s = 0; s < j; s++) v -= a[i][s] * a[j][s];
+                a[i][j] = v / a[j][j];
+            }
+        }
+        double y[9];
+        for(int i = 0; i < k; i++) {
+            double v = r[i];
+            for(int s = 0; s < i; s++) v -= a[i][s] * y[s];
+            y[i] = v / a[i][i];
+        }
+        for(int i = k-1; i >= 0; i--) {
+            double v = y[i];
+            for(int s = i+1; s < k; s++) v -= a[s][i] * x[s];
+            x[i] = v / a[i][i];
+        }
+        return true;
+    }
+
+    /// Eigenvalues and eigenvectors (columns of V) of symmetric 3x3 A, by Jacobi rotations
+    static void EigenSymmetric3(const double (&A)[3][3], double (&lambda)[3], double (&V)[3][3]) {
+        double a[3][3];
+        for(int i = 0; i < 3; i++)
+            for(int j = 0; j < 3; j++) {
+                a[i][j] = A[i][j];
+                V[i][j] = i == j ? 1 : 0;
+            }
+        for(int sweep = 0; sweep < 50; sweep++) {
+            double off = fabs(a[0][1]) + fabs(a[0][2]) + fabs(a[1][2]);
+            if(off < 1e-15 * (fabs(a[0][0]) + fabs(a[1][1]) + fabs(a[2][2]))) break;
+            for(int p = 0; p < 2; p++)
+                for(int q = p+1; q < 3; q++) {
+                    if(a[p][q] == 0) continue;
+                    double theta = (a[q][q] - a[p][p]) / (2 * a[p][q]);
+                    double t = (theta >= 0 ? 1 : -1) / (fabs(theta) + sqrt(theta*theta + 1));
+                    double cs = 1 / sqrt(t*t + 1), sn = t * cs;
+                    for(int k = 0; k < 3; k++) { // a = J'aJ
+                        double akp = a[k][p], akq = a[k][q];
+                        a[k][p] = cs*akp - sn*akq;
+                        a[k][q] = sn*akp + cs*akq;
+                    }
+                    for(int k = 0; k < 3; k++) {
+                        double apk = a[p][k], aqk = a[q][k];
+                        a[p][k] = cs*apk - sn*aqk;
+                        a[q][k] = sn*apk + cs*aqk;
+                    }
+                    for(int k = 0; k < 3; k++) {
+                        double vkp = V[k][p], vkq = V[k][q];
+                        V[k][p] = cs*vkp - sn*vkq;
+                        V[k][q] = sn*vkp + cs*vkq;
+                    }
+                }
+        }
+        for(int i = 0; i < 3; i++) lambda[i] = a[i][i];
+    }
+};
+
+#endif // MMC5983MA_CALIBRATION_HPP_INCLUDED
@@ -0,0 +1,364 @@
+/// MMC5983MA_Capture.hpp - compact binary capture of raw MMC5983MA measurements: background writer, memory-mapped reader.
+
+/*
+MIT License
+
+Copyright (c) 2023-2025 Dave Nadler
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef MMC5983MA_CAPTURE_HPP_INCLUDED
+#define MMC5983MA_CAPTURE_HPP_INCLUDED
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#ifdef _WIN32
+  #include <windows.h>
+#else
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+#include "MMC5983MA.hpp"
+
+/// Capture file layout, host byte order: MMC5983MA_CaptureHeader_T, then chunks. Each chunk is an
+/// MMC5983MA_CaptureChunk_T followed by 'count' records of one type, so a chunk's records form an array
+/// that can be used in place. A measurement takes 16 bytes, plus 24 when its offset changed (every RESET/SET
+/// measurement measures a new one), against well over 1kB of text log.
+struct MMC5983MA_CaptureHeader_T {
+    char magic[8];           ///< "MMCCAPTR"
+    uint32_t version;        ///< MMC5983MA_CaptureWriter_C::FileVersion
+    uint16_t frameSize;      ///< sizeof(MMC5983MA_CaptureFrame_T)
+    uint16_t offsetSize;     ///< sizeof(MMC5983MA_CaptureOffset_T)
+    char adapter[32];        ///< IO backend / adapter description (NUL-terminated)
+    uint32_t countsPerGauss; ///< MMC5983MA_C::CountsPerGauss
+    uint8_t productID;       ///< sensor's Product_ID register
+    uint8_t reserved[3];
+    uint64_t frames;         ///< frames written, filled in by Close (0 if the writer didn't finish)
+    uint64_t dropped;        ///< measurements not captured because the disk fell behind
+};
+/// One measurement: the field-polarity conversion as the 7 output-register bytes Fetch_XYZ reads
+struct MMC5983MA_CaptureFrame_T {
+    uint64_t time_us;        ///< MMC5983MA_Sample_T::start_us
+    uint8_t xyz[7];          ///< registers X_out_0..XYZ_out_2, as MMC5983MA_C::Fetch_XYZ reads them
+    uint8_t config;          ///< MMC5983MA_MeasurementMode_T in bits 0-3, Bandwidth_T in bits 4-5
+    uint8_t Mode() const { return config & 0x0F; };
+    uint8_t Bandwidth() const { return (config >> 4) & 0x03; };
+};
+/// Offset in effect from a given frame on: field = raw - offset. This is the RESET/SET offset in the
+/// RESET/SET modes, 0x20000 for Auto-SR, and whatever reproduces the field in the motion-compensated modes.
+struct MMC5983MA_CaptureOffset_T {
+    uint64_t frame;          ///< index of the first frame it applies to
+    int32_t offset[3];
+    uint32_t reserved;
+};
+struct MMC5983MA_CaptureChunk_T {
+    typedef enum : uint32_t { Frames = 0x534D5246 /* "FRMS" */, Offsets = 0x5346464F /* "OFFS" */ } Type_T;
+    uint32_t type;           ///< Type_T
+    uint32_t count;          ///< records following
+    uint64_t first;          ///< Frames: capture index of the first frame; Offsets: 0
+};
+static_assert(sizeof(MMC5983MA_CaptureHeader_T) == 72 && sizeof(MMC5983MA_CaptureFrame_T) == 16 &&
+              sizeof(MMC5983MA_CaptureOffset_T) == 24 && sizeof(MMC5983MA_CaptureChunk_T) == 16,
+    "capture records are written to files as-is, and keep 8-byte alignment in a mapped file");
+static_assert(std::is_trivially_copyable_v<MMC5983MA_CaptureFrame_T>, "capture records are written to files as-is");
+
+/// Writes a capture on its own thread. Add (the acquisition thread) only appends to the buffer being filled;
+/// when that holds ChunkFrames frames it is handed to the writer thread, which writes it as one chunk while
+/// the other buffer fills. If the writer still has the previous chunk then (the disk fell behind), the
+/// measurement is dropped and counted instead of waiting: Add never blocks on disk.
+/// One producer thread; Open and Close from the same thread as Add.
+class MMC5983MA_CaptureWriter_C {
+  public:
+    static const uint32_t FileVersion = 1;
+    static const uint32_t ChunkFrames = 4096; ///< frames per chunk (64kB)
+
+    ~MMC5983MA_CaptureWriter_C() { Close(); };
+    bool Open(const char *path, const char *adapter, uint8_t productID, uint32_t countsPerGauss = 16384) {
+        Close();
+        f = fopen(path, "wb");
+        if(!f) return false;
+        header = {};
+        memcpy(header.magic, "MMCCAPTR", 8);
+        header.version = FileVersion;
+        header.frameSize = sizeof(MMC5983MA_CaptureFrame_T);
+        header.offsetSize = sizeof(MMC5983MA_CaptureOffset_T);
+        snprintf(header.adapter, sizeof(header.adapter), "%s", adapter);
+        header.countsPerGauss = countsPerGauss;
+        header.productID = productID;
+        if(fwrite(&header, sizeof(header), 1, f) != 1) { fclose(f); f = nullptr; return false; }
+        for(Buffer_T &b : buffers) {
+            b.frames.clear();   b.frames.reserve(ChunkFrames);
+            b.offsets.clear();  b.offsets.reserve(ChunkFrames);
+        }
+        filling = 0;
+        buffers[0].first = 0;
+        frames = 0;
+        haveOffset = false;
+        writeError = stopping = pending = false;
+        writer = std::thread([this]() { WriterThread(); });
+        return true;
+    }
+    bool IsOpen() const { return f != nullptr; };
+
+    /// Producer: capture one measurement (only those with a field, ie s.Ok()). Never blocks.
+    void Add(const MMC5983MA_Sample_T &s) {
+        if(!f || !s.Ok()) return;
+        Buffer_T *b = &buffers[filling];
+        if(b->frames.size() >= ChunkFrames && !HandOver()) { header.dropped++; return; }
+        b = &buffers[filling];
+        int32_t offset[3];
+        for(int i = 0; i < 3; i++) offset[i] = (int32_t)s.raw[i] - s.field[i];
+        if(!haveOffset || memcmp(offset, lastOffset, sizeof(offset)) != 0) {
+            MMC5983MA_CaptureOffset_T o = { frames, { offset[0], offset[1], offset[2] }, 0 };
+            if(b->offsets.size() >= ChunkFrames && !HandOver()) { header.dropped++; return; }
+            b = &buffers[filling];
+            b->offsets.push_back(o);
+            memcpy(lastOffset, offset, sizeof(offset));
+            haveOffset = true;
+        }
+        MMC5983MA_CaptureFrame_T fr;
+        fr.time_us = s.start_us;
+        EncodeXYZ(s.raw, fr.xyz);
+        fr.config = (uint8_t)((s.mode & 0x0F) | ((s.bandwidth & 0x03) << 4));
+        b->frames.push_back(fr);
+        frames++;
+    }
+    /// Measurements dropped so far because the writer thread fell behind
+    uint64_t Dropped() const { return header.dropped; };
+
+    /// Write what's buffered, fill in the header's totals, and close. Returns false if any write failed.
+    bool Close() {
+        if(!f) return true;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            idle.wait(lock, [this]() { return !pending; });
+        }
+        HandOver();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        work.notify_one();
+        writer.join();
+        header.frames = frames;
+        bool ok = !writeError && fseek(f, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, f) == 1;
+        ok = fclose(f) == 0 && ok;
+        f = nullptr;
+        return ok;
+    }
+
+    /// Inverse of MMC5983MA_C::DecodeXYZ: 3 unsigned 18-bit values to output registers 0x00-0x06
+    static void EncodeXYZ(const uint32_t (&xyz)[3], uint8_t (&rawBytes)[7]) {
+        rawBytes[6] = 0;
+        for(int i = 0; i < 3; i++) {
+            rawBytes[2*i]   = (uint8_t)(xyz[i] >> 10);
+            rawBytes[2*i+1] = (uint8_t)(xyz[i] >> 2);
+            rawBytes[6]    |= (uint8_t)((xyz[i] & 0x03) << (6 - 2*i));
+        }
+    }
+    /// As MMC5983MA_C::DecodeXYZ: output registers 0x00-0x06 to 3 unsigned 18-bit values
+    static void DecodeXYZ(const uint8_t (&rawBytes)[7], uint32_t (&xyz)[3]) {
+        for(int i = 0; i < 3; i++)
+            xyz[i] = ((uint32_t)rawBytes[2*i] << 10) | ((uint32_t)rawBytes[2*i+1] << 2) | ((rawBytes[6] >> (6 - 2*i)) & 0x03u);
+    }
+
+  protected:
+    struct Buffer_T {
+        std::vector<MMC5983MA_CaptureFrame_T> frames;
+        std::vector<MMC5983MA_CaptureOffset_T> offsets;
+        uint64_t first; ///< capture index of frames[0]
+    };
+    FILE *f = nullptr;
+    MMC5983MA_CaptureHeader_T header = {};
+    Buffer_T buffers[2];
+    int filling = 0;             ///< producer's buffer; the other belongs to the writer while pending
+    uint64_t frames = 0;         ///< producer: frames captured
+    int32_t lastOffset[3];
+    bool haveOffset = false;
+    std::thread writer;
+    std::mutex mutex;
+    std::condition_variable work, idle;
+    bool pending = false;        ///< buffers[filling^1] waits for (or is being written by) the writer thread
+    bool stopping = false;
+    bool writeError = false;     ///< writer thread only, until joined
+
+    /// Producer: give the filled buffer to the writer thread and start on the other; false if it's still busy
+    bool HandOver() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if(pending) return false;
+            pending = true;
+            filling ^= 1;
+        }
+        work.notify_one();
+        Buffer_T &next = buffers[filling];
+        next.frames.clear();
+        next.offsets.clear();
+        next.first = frames;
+        return true;
+    }
+    void WriterThread() {
+        std::unique_lock<std::mutex> lock(mutex);
+        for(;;) {
+            work.wait(lock, [this]() { return pending || stopping; });
+            if(pending) {
+                Buffer_T &b = buffers[filling ^ 1];
+                lock.unlock(); // the producer only touches buffers[filling] meanwhile
+                if(!b.offsets.empty()) WriteChunk(MMC5983MA_CaptureChunk_T::Offsets, 0, b.offsets);
+                if(!b.frames.empty()) WriteChunk(MMC5983MA_CaptureChunk_T::Frames, b.first, b.frames);
+                lock.lock();
+                pending = false;
+                idle.notify_all();
+            } else if(stopping) {
+                return;
+            }
+        }
+    }
+    template <typename T>
+    void WriteChunk(uint32_t type, uint64_t first, const std::vector<T> &records) {
+        MMC5983MA_CaptureChunk_T c = { type, (uint32_t)records.size(), first };
+        if(fwrite(&c, sizeof(c), 1, f) != 1 || fwrite(records.data(), sizeof(T), records.size(), f) != records.size())
+            writeError = true;
+    }
+};
+
+/// Read-only view of a capture file, mapped into memory: Frame(i) points into the mapping (nothing is
+/// copied), and any frame can be reached directly. A file whose writer didn't finish is read up to its
+/// last complete record.
+class MMC5983MA_CaptureReader_C {
+  public:
+    ~MMC5983MA_CaptureReader_C() { Close(); };
+    bool Open(const char *path) {
+        Close();
+        if(!Map(path)) return false;
+        if(size < sizeof(MMC5983MA_CaptureHeader_T)) { Close(); return false; }
+        const MMC5983MA_CaptureHeader_T &h = Header();
+        if(memcmp(h.magic, "MMCCAPTR", 8) != 0 || h.version != MMC5983MA_CaptureWriter_C::FileVersion ||
+           h.frameSize != sizeof(MMC5983MA_CaptureFrame_T) || h.offsetSize != sizeof(MMC5983MA_CaptureOffset_T)) {
+            Close();
+            return false;
+        }
+        // Index the chunks
+        size_t pos = sizeof(MMC5983MA_CaptureHeader_T);
+        while(pos + sizeof(MMC5983MA_CaptureChunk_T) <= size) {
+            const MMC5983MA_CaptureChunk_T *c = (const MMC5983MA_CaptureChunk_T *)(base + pos);
+            pos += sizeof(*c);
+            size_t recordSize = c->type == MMC5983MA_CaptureChunk_T::Frames ? sizeof(MMC5983MA_CaptureFrame_T) :
+                                c->type == MMC5983MA_CaptureChunk_T::Offsets ? sizeof(MMC5983MA_CaptureOffset_T) : 0;
+            if(recordSize == 0) break; // not a chunk: damaged file
+            uint32_t count = (uint32_t)std::min<size_t>(c->count, (size - pos) / recordSize);
+            if(c->type == MMC5983MA_CaptureChunk_T::Frames && count)
+                chunks.push_back({ c->first, count, (const MMC5983MA_CaptureFrame_T *)(base + pos) });
+            else
+                for(uint32_t i = 0; i < count; i++) offsets.push_back(((const MMC5983MA_CaptureOffset_T *)(base + pos))[i]);
+            pos += (size_t)count * recordSize;
+        }
+        frames = chunks.empty() ? 0 : chunks.back().first + chunks.back().count;
+        return true;
+    }
+    void Close() {
+        Unmap();
+        chunks.clear();
+        offsets.clear();
+        frames = 0;
+    }
+    bool IsOpen() const { return base != nullptr; };
+    const MMC5983MA_CaptureHeader_T &Header() const { return *(const MMC5983MA_CaptureHeader_T *)base; };
+    uint64_t Frames() const { return frames; };
+
+    /// Frame i (i < Frames()), in place in the mapping
+    const MMC5983MA_CaptureFrame_T &Frame(uint64_t i) const {
+        auto c = std::upper_bound(chunks.begin(), chunks.end(), i,
+            [](uint64_t index, const Chunk_T &chunk) { return index < chunk.first; }) - 1;
+        return c->frames[i - c->first];
+    }
+    /// Offset in effect for frame i (see MMC5983MA_CaptureOffset_T)
+    const int32_t (&Offset(uint64_t i) const)[3] {
+        static const int32_t none[3] = { 0, 0, 0 };
+        auto o = std::upper_bound(offsets.begin(), offsets.end(), i,
+            [](uint64_t index, const MMC5983MA_CaptureOffset_T &off) { return index < off.frame; });
+        return o == offsets.begin() ? none : (o - 1)->offset;
+    }
+    /// Raw conversion and offset-corrected field of frame i, as MMC5983MA_Sample_T::raw and ::field
+    void Decode(uint64_t i, uint32_t (&raw)[3], int32_t (&field)[3]) const {
+        MMC5983MA_CaptureWriter_C::DecodeXYZ(Frame(i).xyz, raw);
+        const int32_t (&offset)[3] = Offset(i);
+        for(int a = 0; a < 3; a++) field[a] = (int32_t)raw[a] - offset[a];
+    }
+
+  protected:
+    struct Chunk_T {
+        uint64_t first;
+        uint32_t count;
+        const MMC5983MA_CaptureFrame_T *frames;
+    };
+    std::vector<Chunk_T> chunks;                     ///< in capture order
+    std::vector<MMC5983MA_CaptureOffset_T> offsets;  ///< in frame order (few: copied)
+    uint64_t frames = 0;
+    const uint8_t *base = nullptr;
+    size_t size = 0;
+    #ifdef _WIN32
+      HANDLE file = INVALID_HANDLE_VALUE, mapping = nullptr;
+      bool Map(const char *path) {
+          file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+          if(file == INVALID_HANDLE_VALUE) return false;
+          LARGE_INTEGER length;
+          if(!GetFileSizeEx(file, &length) || length.QuadPart == 0) { Unmap(); return false; }
+          size = (size_t)length.QuadPart;
+          mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+          if(mapping) base = (const uint8_t *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+          if(!base) { Unmap(); return false; }
+          return true;
+      }
+      void Unmap() {
+          if(base) UnmapViewOfFile(base);
+          if(mapping) CloseHandle(mapping);
+          if(file != INVALID_HANDLE_VALUE) CloseHandle(file);
+          base = nullptr; mapping = nullptr; file = INVALID_HANDLE_VALUE; size = 0;
+      }
+    #else
+      bool Map(const char *path) {
+          int fd = open(path, O_RDONLY);
+          if(fd < 0) return false;
+          struct stat st;
+          if(fstat(fd, &st) == 0 && st.st_size > 0) {
+              void *p = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+              if(p != MAP_FAILED) { base = (const uint8_t *)p; size = (size_t)st.st_size; }
+          }
+          close(fd); // the mapping stays valid
+          return base != nullptr;
+      }
+      void Unmap() {
+          if(base) munmap((void *)base, size);
+          base = nullptr; size = 0;
+      }
+    #endif
+};
+
+#endif // MMC5983MA_CAPTURE_HPP_INCLUDED
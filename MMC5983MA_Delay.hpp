@@ -0,0 +1,156 @@
+/// MMC5983MA_Delay.hpp - MMC5983MA_HybridDelay_C class - accurate microsecond delays for host-side IO classes.
+
+/*
+MIT License
+
+Copyright (c) 2023-2025 Dave Nadler
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef MMC5983MA_DELAY_HPP_INCLUDED
+#define MMC5983MA_DELAY_HPP_INCLUDED
+
+#include <stdint.h>
+#include <stdio.h>
+#include <chrono>
+#include <thread>
+#ifdef _WIN32
+  #include <windows.h>
+  #include <timeapi.h> // timeBeginPeriod
+  #pragma comment(lib, "winmm.lib")
+#endif
+
+/// Power-of-2 bucketed histogram of microsecond values: bucket 0 counts 0us, bucket n counts [2^(n-1), 2^n) us
+struct MMC5983MA_Histogram_us_T {
+    static const int Buckets = 18; ///< last bucket collects everything >= 65536us
+    uint32_t bucket[Buckets];
+    uint32_t count;
+    uint64_t total_us;
+    uint32_t max_us;
+    void Add(uint32_t us) {
+        int b = 0;
+        while(b < Buckets-1 && us >= (1u << b)) b++;
+        bucket[b]++;
+        count++;
+        total_us += us;
+        if(us > max_us) max_us = us;
+    }
+    /// Largest value in the bucket containing the given quantile (0..1), ie "p99 <= N us"
+    uint32_t QuantileBound_us(double q) const {
+        if(count == 0) return 0;
+        uint64_t target = (uint64_t)(q * count), seen = 0;
+        for(int b = 0; b < Buckets-1; b++) {
+            seen += bucket[b];
+            if(seen > target) return b == 0 ? 0 : (1u << b) - 1;
+        }
+        return max_us;
+    }
+    void Print(FILE *f, const char *title) const {
+        fprintf(f, "%s: %u delays, mean %.1fus, max %uus, p50 <= %uus, p99 <= %uus\n", title, count,
+            count ? (double)total_us/count : 0.0, max_us, QuantileBound_us(0.50), QuantileBound_us(0.99));
+        for(int b = 0; b < Buckets; b++) {
+            if(!bucket[b]) continue;
+            if(b == 0) fprintf(f, "  %6s    0us: %u\n", "", bucket[b]);
+            else       fprintf(f, "  %6u..%5uus: %u\n", 1u << (b-1), (1u << b) - 1, bucket[b]);
+        }
+    }
+};
+
+/// Delay primitive shared by the host IO classes (delay_us). std::this_thread::sleep_for alone is only as
+/// good as the OS timer: a 500us wait (RESET/SET pulse, 800Hz conversion) can become several milliseconds.
+/// Instead, sleep until shortly before the deadline, then spin on the steady clock until it.
+/// "Shortly" is the learned wake-up overshoot: it tracks roughly the TargetLateWakeRatio quantile of how late
+/// sleep_for actually returns (each on-time wake shortens it a little, each late one lengthens it
+/// TargetLateWakeRatio-1 times as much), so nearly every delay ends by spinning, on time, while
+/// spinning costs no more CPU than the OS makes necessary.
+/// Not thread-safe: one instance per IO object (used by one thread at a time).
+class MMC5983MA_HybridDelay_C {
+  public:
+    static const uint32_t TargetLateWakeRatio = 64; ///< aim for 1 in 64 sleeps to wake after the deadline
+    uint32_t wakeMargin_us = 2000;  ///< Current learned margin: sleep ends this long before the deadline
+    uint32_t maxWakeMargin_us = 20000; ///< Never spin longer than this (coarse OS timers)
+    bool enabled = true;            ///< false: plain sleep_for (for comparison)
+
+    MMC5983MA_Histogram_us_T wakeOvershoot = {}; ///< how late sleep_for returned, vs. what was asked
+    MMC5983MA_Histogram_us_T lateness = {};      ///< how late each delay returned, vs. its deadline
+    uint64_t requested_us = 0;  ///< total delay requested
+    uint64_t spun_us = 0;       ///< total time spent spinning
+    uint32_t lateWakes = 0;     ///< sleeps that woke after the deadline (margin too small)
+
+    MMC5983MA_HybridDelay_C() {
+        #ifdef _WIN32
+            static bool fineTimer = (timeBeginPeriod(1) == TIMERR_NOERROR); // 1ms scheduler tick for this process
+            (void)fineTimer;
+        #endif
+    }
+    static uint64_t Now_us() {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+    void Delay_us(uint32_t uSecs) {
+        uint64_t start = Now_us();
+        uint64_t deadline = start + uSecs;
+        requested_us += uSecs;
+        if(!enabled) {
+            std::this_thread::sleep_for(std::chrono::microseconds(uSecs));
+            lateness.Add((uint32_t)(Now_us() - deadline));
+            return;
+        }
+        if(uSecs > wakeMargin_us) {
+            uint32_t sleep_us = uSecs - wakeMargin_us;
+            std::this_thread::sleep_for(std::chrono::microseconds(sleep_us));
+            uint64_t woke = Now_us();
+            uint32_t overshoot = woke > start + sleep_us ? (uint32_t)(woke - start - sleep_us) : 0;
+            wakeOvershoot.Add(overshoot);
+            LearnWakeMargin(overshoot);
+        }
+        uint64_t spinStart = Now_us();
+        uint64_t now = spinStart;
+        while(now < deadline) now = Now_us();
+        spun_us += now - spinStart;
+        lateness.Add((uint32_t)(now - deadline));
+    }
+    void ResetStatistics() {
+        wakeOvershoot = {};
+        lateness = {};
+        requested_us = spun_us = 0;
+        lateWakes = 0;
+    }
+    void PrintStatistics(FILE *f) const {
+        fprintf(f, "Delays: %llu us requested, %llu us spinning, %u late wakes, wake margin now %u us\n",
+            (unsigned long long)requested_us, (unsigned long long)spun_us, lateWakes, wakeMargin_us);
+        wakeOvershoot.Print(f, "Sleep wake-up overshoot");
+        lateness.Print(f, "Delay lateness (past deadline)");
+    }
+
+  protected:
+    void LearnWakeMargin(uint32_t overshoot_us) {
+        uint32_t step = 1 + wakeMargin_us/256;
+        if(overshoot_us > wakeMargin_us) {
+            lateWakes++;
+            wakeMargin_us += step*(TargetLateWakeRatio-1);
+        } else if(wakeMargin_us > step) {
+            wakeMargin_us -= step;
+        }
+        if(wakeMargin_us > maxWakeMargin_us) wakeMargin_us = maxWakeMargin_us;
+    }
+};
+
+#endif // MMC5983MA_DELAY_HPP_INCLUDED
@@ -0,0 +1,170 @@
+/// MMC5983MA_Fleet.hpp - MMC5983MA_Fleet_C class - several MMC5983MA sensors measured in parallel, merged into one time-ordered stream.
+
+/*
+MIT License
+
+Copyright (c) 2023-2025 Dave Nadler
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#ifndef MMC5983MA_FLEET_HPP_INCLUDED
+#define MMC5983MA_FLEET_HPP_INCLUDED
+
+#include <stdint.h>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "MMC5983MA.hpp"
+#include "MMC5983MA_Acquisition.hpp"
+
+/// One sample of the merged stream
+struct MMC5983MA_FleetSample_T {
+    uint32_t sensor;                    ///< which sensor (index in order of MMC5983MA_Fleet_C::Add)
+    MMC5983MA_AcquiredSample_T sample;  ///< as queued by that sensor's acquisition thread
+};
+
+/// Several MMC5983MA sensors, each on its own adapter (FT232H channel or MCP2221), measured in parallel:
+/// one MMC5983MA_C and one MMC5983MA_Acquisition_C worker thread per sensor, so a USB round-trip on one
+/// adapter never waits for another, and aggregate throughput grows with the number of adapters.
+/// Pop() merges the per-sensor queues into one stream ordered by sample time (steady clock). A sample is
+/// released once every running sensor has queued a sample at least as new (so nothing earlier can still
+/// arrive), or after maxHold_us, so a stalled sensor delays the stream by at most that long.
+/// Add, Open, Start, and Stop from one thread; adapter enumeration and the libMPSSE channel list are not
+/// thread-safe, so Open initializes the sensors one after another before any worker starts. For example:
+///     Init_libMPSSE(); // loads D2XX, so the channels can be listed
+///     MMC5983MA_Fleet_C<MMC5983MA_IO_WindowsQwiic_FT232H_C> fleet;
+///     for(const std::string &sn : MMC5983MA_IO_WindowsQwiic_FT232H_C::ChannelSerialNumbers())
+///         fleet.Add(sn, [sn](MMC5983MA_IO_WindowsQwiic_FT232H_C &dev) { dev.channelSerialNumber = sn; });
+///     fleet.Open(); fleet.Start(10000); ... while(fleet.Pop(s)) ...
+template <typename TDEVICE, size_t CAPACITY = 256>
+class MMC5983MA_Fleet_C {
+  public:
+    /// MMC5983MA_C with its IO device reachable, to select the adapter before Init
+    class Compass_C : public MMC5983MA_C<TDEVICE> {
+      public:
+        TDEVICE &Dev() { return this->dev; };
+    };
+    typedef MMC5983MA_Acquisition_C<Compass_C, CAPACITY> Acquisition_T;
+    struct Sensor_T {
+        std::string name;               ///< for messages, for example the adapter's serial number
+        Compass_C compass;              ///< owned by the acquisition thread while it runs
+        Acquisition_T acquisition { compass };
+        std::string error;              ///< why Open failed (empty if it succeeded)
+        std::deque<MMC5983MA_AcquiredSample_T> pending; ///< taken from acquisition.samples, not yet merged
+        uint64_t newest_us = 0;         ///< time of the newest sample taken from acquisition.samples
+        uint32_t merged = 0;            ///< samples released by Pop
+    };
+
+    uint32_t maxHold_us = 100000; ///< longest Pop holds a sample waiting for other sensors (make it at least one cycle's duration)
+    uint32_t outOfOrder = 0;      ///< samples released earlier than one already released (a sensor was held past maxHold_us)
+
+    ~MMC5983MA_Fleet_C() { Stop(); };
+
+    /// Add a sensor; select (if given) picks its adapter on the IO device, for example by index or
+    /// serial number. Returns the sensor's index.
+    uint32_t Add(const std::string &name, std::function<void(TDEVICE &)> select = nullptr) {
+        sensors.push_back(std::make_unique<Sensor_T>()); // compass and IO state can be large; keep it off the stack
+        Sensor_T &s = *sensors.back();
+        s.name = name;
+        if(select) select(s.compass.Dev());
+        return (uint32_t)(sensors.size() - 1);
+    }
+    uint32_t Count() const { return (uint32_t)sensors.size(); };
+    Sensor_T &Sensor(uint32_t idx) { return *sensors[idx]; };
+
+    /// Initialize every sensor not yet initialized, one at a time on this thread (some adapters throw).
+    /// Returns how many failed (see Sensor_T::error); Start leaves those out.
+    uint32_t Open() {
+        uint32_t failed = 0;
+        for(auto &s : sensors) {
+            if(s->compass.initialized) continue;
+            s->error.clear();
+            try {
+                if(s->compass.Init() != 0) s->error = "Compass initialization failed (wrong Product ID or bus error)";
+            } catch(const std::exception &e) {
+                s->error = e.what();
+            }
+            if(!s->error.empty()) failed++;
+        }
+        return failed;
+    }
+    /// Start each initialized sensor measuring once per period_us on its own thread
+    /// (each chooses its plan, see MMC5983MA_Acquisition_C::ChoosePlan)
+    void Start(uint32_t period_us) {
+        Stop();
+        lastReleased_us = 0;
+        outOfOrder = 0;
+        for(auto &s : sensors) {
+            s->pending.clear();
+            s->newest_us = 0;
+            s->merged = 0;
+            if(s->compass.initialized) s->acquisition.Start(period_us);
+        }
+    }
+    /// Stop all sensors (each finishes its current cycle, in parallel)
+    void Stop() {
+        for(auto &s : sensors) s->acquisition.RequestStop();
+        for(auto &s : sensors) s->acquisition.Stop();
+    }
+    /// Earliest sample of the merged stream; false if none can be released yet. Call often
+    /// (each sensor's queue holds CAPACITY samples).
+    bool Pop(MMC5983MA_FleetSample_T &out) {
+        Sensor_T *earliest = nullptr;
+        uint32_t earliestIdx = 0;
+        for(uint32_t idx = 0; idx < sensors.size(); idx++) {
+            Sensor_T &s = *sensors[idx];
+            MMC5983MA_AcquiredSample_T a;
+            while(s.acquisition.samples.Pop(a)) {
+                s.newest_us = a.time_us;
+                s.pending.push_back(a);
+            }
+            if(!s.pending.empty() && (!earliest || s.pending.front().time_us < earliest->pending.front().time_us)) {
+                earliest = &s;
+                earliestIdx = idx;
+            }
+        }
+        if(!earliest) return false;
+        uint64_t t = earliest->pending.front().time_us;
+        if(MMC5983MA_PeriodicScheduler_C::Now_us() < t + maxHold_us) {
+            for(auto &s : sensors) { // could a sensor still queue a sample taken before t?
+                typename Acquisition_T::State_T state = s->acquisition.GetState();
+                if(state != Acquisition_T::Running && state != Acquisition_T::Starting) continue;
+                if(s->pending.empty() && s->newest_us < t) return false;
+            }
+        }
+        if(t < lastReleased_us) outOfOrder++;
+        lastReleased_us = t;
+        out.sensor = earliestIdx;
+        out.sample = earliest->pending.front();
+        earliest->pending.pop_front();
+        earliest->merged++;
+        return true;
+    }
+
+  protected:
+    std::vector<std::unique_ptr<Sensor_T>> sensors;
+    uint64_t lastReleased_us = 0;
+};
+
+#endif // MMC5983MA_FLEET_HPP_INCLUDED
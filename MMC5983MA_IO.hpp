@@ -47,9 +47,45 @@ class MMC5983MA_IO_base_C {
     void write(uint8_t reg_addr, const uint8_t (&write_data)[], uint32_t len);
     /// Platform-specific delay before return
     void delay_us(uint32_t uSecs);
+    /// Platform-specific monotonic time in microseconds (used to timestamp samples)
+    uint64_t time_us();
     /// Did last IO operation succeed?
     bool IO_OK();
-    /// Application must implement printf-analog if MMC5983MA_PRINT_DETAILED_LOG is defined in MMC5983MA_C
+
+    /// Optional transaction batching: a TDEVICE that can send a sequence of reads, writes,
+    /// and delays to the sensor in one host transfer (ie one USB round-trip) sets this true
+    /// and implements the functions below. MMC5983MA_C then batches multi-step operations
+    /// (RESET/measure/SET/measure) via 'if constexpr', so non-batching devices pay nothing.
+    static const bool SupportsBatching = false;
+    /// Start queuing (only if SupportsBatching)
+    void BeginBatch();
+    /// Queue a register write; write_data is copied immediately
+    void QueueWrite(uint8_t reg_addr, const uint8_t (&write_data)[], uint32_t len);
+    /// Queue a register read; read_data is filled in by FlushBatch (must stay valid until then)
+    void QueueRead(uint8_t reg_addr, uint8_t (&read_data)[], uint32_t len);
+    /// Queue a delay between bus operations, timed by the device where possible
+    void QueueDelay_us(uint32_t uSecs);
+    /// Execute everything queued since BeginBatch; returns false if any operation failed
+    bool FlushBatch();
+
+    /// Optional data-ready input: a TDEVICE that can see the sensor's INT pin (high when a measurement
+    /// completes, once MMC5983MA_C::EnableDataReadyInterrupt has enabled it) sets this true and implements
+    /// the functions below, so MMC5983MA_C waits for INT instead of sleeping and polling the Status register.
+    static const bool SupportsDataReady = false;
+    /// Prepare the INT input; returns false if INT is not wired to this adapter
+    bool DataReadyInit();
+    /// Wait until INT is high, at most timeout_us; returns true if INT was seen high
+    bool WaitDataReady(uint32_t timeout_us);
+    /// Queue the same wait in a batch (only if SupportsBatching); returns false if this device
+    /// cannot wait for INT inside a batch (the caller then queues a delay instead)
+    bool QueueWaitDataReady(uint32_t timeout_us);
+
+    /// Optional I2C mux control, for several sensors (all at address 0x30) behind a TCA9548A-style mux
+    /// on one adapter (see MMC5983MA_IO_Mux.hpp): write the mux's channel-select byte (bit n connects channel n)
+    void WriteMux(uint8_t muxAddress, uint8_t channelMask);
+    /// Queue the same write in a batch (only if SupportsBatching)
+    void QueueWriteMux(uint8_t muxAddress, uint8_t channelMask);
+    /// Application must implement printf-analog (IO classes report diagnostics here; register IO is traced by MMC5983MA_Trace_C)
     static int DiagPrintf(const char* format, ...)
     #ifdef __GNUG__
         __attribute__((format(printf, 1, 2))); // help GCC do DiagPrintf format string checking
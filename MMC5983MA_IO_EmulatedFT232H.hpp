@@ -0,0 +1,48 @@
+// MMC5983MA_IO_EmulatedFT232H.hpp - IO class for MMC5983MA via libMPSSE and an emulated FT232H (no hardware)
+
+/*
+MIT License
+
+Copyright (c) 2023-2025 Dave Nadler
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef MMC5983MA_IO_EmulatedFT232H_HPP_INCLUDED
+#define MMC5983MA_IO_EmulatedFT232H_HPP_INCLUDED
+
+#include "MMC5983MA_IO_WindowsQwiic_FT232H.hpp"
+#include "FT232H_Emulator.hpp"
+
+/// MMC5983MA_IO_WindowsQwiic_FT232H_C running the real libMPSSE I2C code against FT232H_Emulator_C:
+/// no adapter or sensor required, and delays take virtual time (runs are fast and repeatable).
+/// emulator.stats shows what each measurement costs on the USB.
+class MMC5983MA_IO_EmulatedFT232H_C : public MMC5983MA_IO_WindowsQwiic_FT232H_C {
+public:
+    FT232H_Emulator_C emulator;
+    void Init() { // not invoked by ctor
+        emulator.Install(); // instead of Init_libMPSSE()
+        OpenChannel();
+        if(emulator.intPinMask == 0x20) dataReadyWiring = DataReady_GPIOL1; // emulated INT is on ADBUS5
+    };
+    void delay_us(uint32_t uSecs) { emulator.Delay_us(uSecs); };
+    uint64_t time_us() { return emulator.Now_us(); };
+};
+
+#endif // MMC5983MA_IO_EmulatedFT232H_HPP_INCLUDED
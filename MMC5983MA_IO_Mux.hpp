@@ -0,0 +1,114 @@
+/// MMC5983MA_IO_Mux.hpp - MMC5983MA_MuxedBus_C, MMC5983MA_IO_MuxChannel_C classes - several MMC5983MA on one I2C adapter via a TCA9548A-style mux.
+
+/*
+MIT License
+
+Copyright (c) 2023-2025 Dave Nadler
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#ifndef MMC5983MA_IO_MUX_HPP_INCLUDED
+#define MMC5983MA_IO_MUX_HPP_INCLUDED
+
+#include <stdint.h>
+#include <assert.h>
+#include "MMC5983MA_IO.hpp"
+
+/// One I2C adapter (TBUS, any TDEVICE that implements WriteMux) with several MMC5983MA behind a
+/// TCA9548A-style mux, such as the SparkFun Qwiic Mux. Every MMC5983MA has the same fixed address,
+/// so only one channel is connected at a time; Select writes the mux only when the channel changes.
+template <typename TBUS>
+class MMC5983MA_MuxedBus_C {
+  public:
+    TBUS adapter;                  ///< the real (or simulated) bus
+    uint8_t muxAddress = 0x70;     ///< TCA9548A default (A0-A2 low)
+    uint32_t channelSwitches = 0;  ///< mux writes so far
+    /// Initialize the adapter once, however many sensors share it
+    void Init() {
+        if(initialized) return;
+        adapter.Init();
+        initialized = true;
+        selected = -1;
+    };
+    /// Connect channel (0-7), if not already connected
+    void Select(uint8_t channel) {
+        assert(channel < 8);
+        if(selected == channel) return;
+        adapter.WriteMux(muxAddress, (uint8_t)(1u << channel));
+        selected = adapter.IO_OK() ? channel : -1;
+        channelSwitches++;
+    };
+    /// Queue the channel switch, if needed, in the adapter's open batch
+    void QueueSelect(uint8_t channel) {
+        assert(channel < 8);
+        if(selected == channel) return;
+        adapter.QueueWriteMux(muxAddress, (uint8_t)(1u << channel));
+        selected = channel; // FlushBatch failure resets this (Invalidate)
+        channelSwitches++;
+    };
+    /// Channel unknown (after an IO failure): the next Select writes the mux
+    void Invalidate() { selected = -1; };
+    int Selected() const { return selected; };
+  protected:
+    bool initialized = false;
+    int selected = -1; ///< connected channel, -1 if unknown
+};
+
+/// TDEVICE for one MMC5983MA behind the mux: forwards register IO to the shared adapter,
+/// connecting this sensor's channel first. Set bus and channel before MMC5983MA_C::Init.
+/// Not thread-safe: all sensors on one bus must be driven from one thread (see MMC5983MA_BusScheduler_C).
+template <typename TBUS>
+class MMC5983MA_IO_MuxChannel_C : public MMC5983MA_IO_base_C {
+  public:
+    MMC5983MA_IO_MuxChannel_C() : MMC5983MA_IO_base_C(I2C) {};
+    MMC5983MA_MuxedBus_C<TBUS> *bus = nullptr; ///< shared bus (set before Init)
+    uint8_t channel = 0;                        ///< mux channel (0-7) this sensor is wired to
+
+    void Init() { assert(bus); bus->Init(); };
+    void read(uint8_t reg_addr, uint8_t (&read_data)[], uint32_t len) {
+        bus->Select(channel);
+        bus->adapter.read(reg_addr, read_data, len);
+    };
+    void write(uint8_t reg_addr, const uint8_t (&write_data)[], uint32_t len) {
+        bus->Select(channel);
+        bus->adapter.write(reg_addr, write_data, len);
+    };
+    void delay_us(uint32_t uSecs) { bus->adapter.delay_us(uSecs); };
+    uint64_t time_us() { return bus->adapter.time_us(); };
+    bool IO_OK(void) { return bus->adapter.IO_OK(); };
+
+    // Batching, if the adapter batches: the channel switch goes into the same batch
+    static const bool SupportsBatching = TBUS::SupportsBatching;
+    void BeginBatch() {
+        bus->adapter.BeginBatch();
+        bus->QueueSelect(channel);
+    };
+    void QueueWrite(uint8_t reg_addr, const uint8_t (&write_data)[], uint32_t len) { bus->adapter.QueueWrite(reg_addr, write_data, len); };
+    void QueueRead(uint8_t reg_addr, uint8_t (&read_data)[], uint32_t len) { bus->adapter.QueueRead(reg_addr, read_data, len); };
+    void QueueDelay_us(uint32_t uSecs) { bus->adapter.QueueDelay_us(uSecs); };
+    bool FlushBatch() {
+        bool ok = bus->adapter.FlushBatch();
+        if(!ok) bus->Invalidate();
+        return ok;
+    };
+};
+
+#endif // MMC5983MA_IO_MUX_HPP_INCLUDED
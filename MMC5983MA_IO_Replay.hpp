@@ -0,0 +1,234 @@
+// MMC5983MA_IO_Replay.hpp - IO classes that replay a recorded session to MMC5983MA_C (no sensor needed)
+
+/*
+MIT License
+
+Copyright (c) 2023-2025 Dave Nadler
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef MMC5983MA_IO_Replay_HPP_INCLUDED
+#define MMC5983MA_IO_Replay_HPP_INCLUDED
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+#include "MMC5983MA_IO.hpp"
+#include "MMC5983MA_IO_Simulator.hpp"
+#include "MMC5983MA_Trace.hpp"
+#include "MMC5983MA_Capture.hpp"
+#include "MMC5983MA_Delay.hpp"
+
+/// Replays a register-IO recording: reads are answered with the recorded values, and each write is checked
+/// against the recording. The recording is a binary trace file (MMC5983MA_Trace_C::WriteFile) or a text log
+/// with one "get_reg 08 Device status => 11" / "set_reg 09 Control register 0 <= 08" line per register byte
+/// (ExampleMagnitudeProblemLog.txt, MMC5983MA_C::FormatTraceRecord output); other lines are ignored.
+/// The driver replaying need not be the one that recorded: each operation is matched with the next
+/// recorded operation of the same kind and register within 'lookahead' records. A read only looks ahead
+/// as far as the next recorded write (it must not consume the writes that are there to be checked).
+/// Recorded operations passed over are counted, and recorded reads among them still update the register
+/// values, so a read with no recorded match (ie an extra Status poll, or a register a fused read includes)
+/// returns the register's most recent recorded value.
+/// A write with no match is counted as a mismatch (the first is described in firstMismatch) and the
+/// position stays put. IO_OK() fails for a recorded failure, and once the recording is used up (for a read,
+/// used up before it started).
+/// Delays are real unless 'fast' (then time is virtual and the replay runs as fast as possible).
+class MMC5983MA_IO_Replay_C : public MMC5983MA_IO_base_C {
+  public:
+    MMC5983MA_IO_Replay_C(InterfaceType_T interfaceType_ = I2C) : MMC5983MA_IO_base_C(interfaceType_) { Rewind(); };
+
+    std::vector<MMC5983MA_TraceRecord_T> recording;
+    bool fast = false;         ///< true: delay_us advances virtual time instead of waiting
+    uint32_t lookahead = 32;   ///< how far ahead of the position an operation may be matched
+
+    struct Statistics_T {
+        uint32_t readsReplayed;    ///< register bytes read from the recording
+        uint32_t readsUnrecorded;  ///< ...with no recorded match, answered with the register's last value
+        uint32_t writesMatched;
+        uint32_t writesMismatched; ///< writes not found in the recording
+        uint32_t recordsSkipped;   ///< recorded operations passed over to stay in step
+    };
+    Statistics_T stats = {};
+    char firstMismatch[128] = "";
+
+    /// Load a binary trace or text log (told apart by the trace file header); false if unreadable or empty
+    bool Load(const char *path) {
+        recording.clear();
+        FILE *f = fopen(path, "rb");
+        if(!f) return false;
+        if(MMC5983MA_Trace_C::ReadFileHeader(f)) {
+            MMC5983MA_TraceRecord_T r;
+            while(fread(&r, sizeof(r), 1, f) == 1) recording.push_back(r);
+        } else {
+            rewind(f);
+            char line[256];
+            while(fgets(line, sizeof(line), f)) ParseLine(line);
+        }
+        fclose(f);
+        Rewind();
+        return !recording.empty();
+    }
+    /// Start over from the first recorded operation
+    void Rewind() {
+        cursor = 0;
+        ok = true;
+        stats = {};
+        firstMismatch[0] = 0;
+        memset(regs, 0, sizeof(regs));
+        regs[0x08] = 0x10;                        // Status: OTP read done
+        regs[0x2f] = 0x30;                        // Product ID
+        start_us = MMC5983MA_HybridDelay_C::Now_us();
+        now_us = 0;
+    }
+    size_t Position() const { return cursor; };
+    bool Finished() const { return cursor >= recording.size(); };
+
+    // Implement the base class IO function suggestions in this derived class
+    void Init() {};
+    void read(uint8_t registerAddress, uint8_t(&read_data)[], uint32_t len) {
+        ok = true;
+        bool exhausted = Finished(); // a read the recording ends within is still answered from the register values
+        for(uint32_t i = 0; i < len; i++) {
+            uint8_t reg = (uint8_t)(registerAddress + i);
+            const MMC5983MA_TraceRecord_T *r = Match(MMC5983MA_TraceRecord_T::Read, reg, -1);
+            if(r) {
+                stats.readsReplayed++;
+                if(r->status & MMC5983MA_TraceRecord_T::Failed) ok = false;
+            } else {
+                stats.readsUnrecorded++;
+                if(exhausted) ok = false; // nothing left to replay
+            }
+            read_data[i] = reg < sizeof(regs) ? regs[reg] : 0;
+        }
+    };
+    void write(uint8_t registerAddress, const uint8_t(&write_data)[], uint32_t len) {
+        ok = true;
+        for(uint32_t i = 0; i < len; i++) {
+            uint8_t reg = (uint8_t)(registerAddress + i);
+            const MMC5983MA_TraceRecord_T *r = Match(MMC5983MA_TraceRecord_T::Write, reg, write_data[i]);
+            if(r) {
+                stats.writesMatched++;
+                if(r->status & MMC5983MA_TraceRecord_T::Failed) ok = false;
+                continue;
+            }
+            if(stats.writesMismatched++ == 0) {
+                const MMC5983MA_TraceRecord_T *next = Finished() ? nullptr : &recording[cursor];
+                bool nextWrite = next && next->dir == MMC5983MA_TraceRecord_T::Write;
+                if(next) snprintf(firstMismatch, sizeof(firstMismatch), "set_reg %02x <= %02x at record %zu; recorded: %s %02x %s %02x",
+                    reg, write_data[i], cursor, nextWrite ? "set_reg" : "get_reg", next->reg, nextWrite ? "<=" : "=>", next->value);
+                else snprintf(firstMismatch, sizeof(firstMismatch), "set_reg %02x <= %02x after the end of the recording",
+                    reg, write_data[i]);
+            }
+            if(Finished()) ok = false;
+        }
+    };
+    void delay_us(uint32_t uSecs) {
+        if(fast) now_us += uSecs;
+        else delay.Delay_us(uSecs);
+    };
+    uint64_t time_us() { return fast ? now_us : MMC5983MA_HybridDelay_C::Now_us() - start_us; };
+    bool IO_OK(void) { return ok; };
+
+  protected:
+    size_t cursor = 0;      ///< next recorded operation
+    bool ok = true;         ///< last read/write
+    uint8_t regs[0x30];     ///< most recent recorded value of each register
+    uint64_t start_us = 0, now_us = 0;
+    MMC5983MA_HybridDelay_C delay;
+
+    /// Next recorded operation of this kind and register (and value, unless -1) within lookahead, and for a
+    /// read before the next recorded write; passes over (and applies the reads among) the records before it.
+    /// nullptr if there is none.
+    const MMC5983MA_TraceRecord_T *Match(MMC5983MA_TraceRecord_T::Direction_T dir, uint8_t reg, int value) {
+        size_t end = std::min(recording.size(), cursor + lookahead);
+        for(size_t i = cursor; i < end; i++) {
+            const MMC5983MA_TraceRecord_T &r = recording[i];
+            if(dir == MMC5983MA_TraceRecord_T::Read && r.dir == MMC5983MA_TraceRecord_T::Write) break;
+            if(r.dir != dir || r.reg != reg || (value >= 0 && r.value != value)) continue;
+            stats.recordsSkipped += (uint32_t)(i - cursor);
+            for(; cursor <= i; cursor++) Apply(recording[cursor]);
+            return &r;
+        }
+        return nullptr;
+    }
+    void Apply(const MMC5983MA_TraceRecord_T &r) {
+        if(r.dir == MMC5983MA_TraceRecord_T::Read && r.reg < sizeof(regs)) regs[r.reg] = r.value;
+    }
+    /// "...get_reg 08 Device status => 11 @1234 FAILED": register and value in hex; time and status optional
+    void ParseLine(const char *line) {
+        const char *get = strstr(line, "get_reg "), *set = strstr(line, "set_reg ");
+        const char *op = get ? get : set;
+        const char *arrow = op ? strstr(op, get ? "=>" : "<=") : nullptr;
+        unsigned reg, value;
+        if(!arrow || sscanf(op + 8, "%x", &reg) != 1 || sscanf(arrow + 2, "%x", &value) != 1) return;
+        MMC5983MA_TraceRecord_T r = {};
+        const char *at = strstr(arrow, " @");
+        unsigned long long t;
+        if(at && sscanf(at + 2, "%llu", &t) == 1) r.time_us = t;
+        r.sequence = (uint32_t)recording.size();
+        r.reg = (uint8_t)reg;
+        r.value = (uint8_t)value;
+        r.dir = get ? MMC5983MA_TraceRecord_T::Read : MMC5983MA_TraceRecord_T::Write;
+        r.status = strstr(arrow, "FAILED") ? MMC5983MA_TraceRecord_T::Failed : MMC5983MA_TraceRecord_T::OK;
+        recording.push_back(r);
+    }
+};
+
+/// Replays a binary capture (MMC5983MA_Capture.hpp) through the simulator's register model: each conversion
+/// latches the recorded raw output of the selected frame (SelectFrame), or the matching RESET-polarity
+/// output (2*offset - raw), so MMC5983MA_C computes the recorded field exactly, in any measurement mode.
+/// The frame is selected explicitly rather than by the time a conversion completes, since back-to-back
+/// measurements' later conversions complete after the next frame's time. Measuring each frame at
+/// FrameTime_us(i) (Origin_us() + its time - the first frame's time) also reproduces the capture's pacing.
+class MMC5983MA_IO_CaptureReplay_C : public MMC5983MA_IO_Simulator_C {
+  public:
+    MMC5983MA_IO_CaptureReplay_C(InterfaceType_T interfaceType_ = I2C) : MMC5983MA_IO_Simulator_C(interfaceType_) {};
+    MMC5983MA_CaptureReader_C capture;
+    bool Open(const char *path) { return capture.Open(path) && capture.Frames() > 0; };
+    /// Replay frame 0 from now on (virtual time)
+    void Start() { origin_us = time_us(); };
+    uint64_t Origin_us() const { return origin_us; };
+    uint64_t FrameTime_us(uint64_t i) const { return origin_us + (capture.Frame(i).time_us - capture.Frame(0).time_us); };
+    /// Latch frame i in every following conversion (select it before measuring it)
+    void SelectFrame(uint64_t i) { selected = i < capture.Frames() ? i : capture.Frames() - 1; };
+    uint64_t framesLatched = 0;
+
+  protected:
+    uint64_t origin_us = 0;
+    uint64_t selected = 0; ///< frame conversions latch
+    void CompleteConversion(uint64_t, bool autoSR) override {
+        uint32_t raw[3];
+        int32_t field[3];
+        capture.Decode(selected, raw, field);
+        for(int chIdx = 0; chIdx < 3; chIdx++) {
+            int64_t out = raw[chIdx];
+            if(!autoSR && polarity[chIdx] < 0) out = 2*((int64_t)raw[chIdx] - field[chIdx]) - raw[chIdx];
+            StoreOutput(chIdx, out < 0 ? 0 : (uint32_t)out);
+        }
+        regs[Status] |= Meas_M_Done;
+        conversionsCompleted++;
+        framesLatched++;
+    }
+};
+
+#endif // MMC5983MA_IO_Replay_HPP_INCLUDED
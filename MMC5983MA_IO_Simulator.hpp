@@ -0,0 +1,427 @@
+// MMC5983MA_IO_Simulator.hpp - IO class simulating an MMC5983MA at register level (no hardware required)
+
+/*
+MIT License
+
+Copyright (c) 2023-2025 Dave Nadler
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef MMC5983MA_IO_Simulator_HPP_INCLUDED
+#define MMC5983MA_IO_Simulator_HPP_INCLUDED
+
+#include <stdint.h>
+#include <string.h> // memset
+#include <assert.h>
+#include <math.h>
+#include <functional>
+#include <algorithm> // std::min, std::max
+
+#include "MMC5983MA_IO.hpp"
+
+/// Simulated MMC5983MA behind the TDEVICE IO interface, so MMC5983MA_C can run on any host.
+/// Time is virtual: delay_us() advances the simulated clock instantly, and each bus
+/// transaction costs transactionTime_us, so runs are deterministic and faster than real time.
+/// Modeled: register map (control registers write-only), Product ID, TM_M and TM_T one-shot conversions,
+/// Meas_M_Done/Meas_T_Done status (write 1 to clear), INT output, SET/RESET polarity including the SPI bug
+/// (RESET only reverses X when the part is wired for SPI), AutoSR output, continuous mode rates and
+/// periodic SET, bandwidth-dependent conversion time and noise, X/YZ inhibit, saturation-test coils,
+/// and +/-8G saturation. Noise comes from a seeded generator, so runs are repeatable.
+/// Supports transaction batching: a flushed batch costs one transactionTime_us plus its queued delays.
+class MMC5983MA_IO_Simulator_C : public MMC5983MA_IO_base_C {
+public:
+    MMC5983MA_IO_Simulator_C(InterfaceType_T interfaceType_ = I2C) : MMC5983MA_IO_base_C(interfaceType_) { PowerOn(); };
+
+    // Implement the base class IO function suggestions in this derived class
+    void Init() {};
+    void read(uint8_t registerAddress, uint8_t(&read_data)[], uint32_t len) {
+        BusTransaction();
+        ReadRegisters(registerAddress, read_data, len);
+    };
+    void write(uint8_t registerAddress, const uint8_t(&write_data)[], uint32_t len) {
+        BusTransaction();
+        WriteRegisters(registerAddress, write_data, len);
+    };
+    void delay_us(uint32_t uSecs) { now_us += uSecs; };
+    uint64_t time_us() { Advance(); return now_us; };
+    bool IO_OK(void) { return true; };
+
+    // Transaction batching (see MMC5983MA_IO_base_C)
+    static const bool SupportsBatching = true;
+    void BeginBatch() { batchCount = 0; };
+    void QueueWrite(uint8_t registerAddress, const uint8_t(&write_data)[], uint32_t len) {
+        BatchOp_T &op = NewBatchOp(BatchOp_T::Write, registerAddress, len);
+        assert(len <= sizeof(op.data));
+        memcpy(op.data, write_data, len);
+    };
+    void QueueRead(uint8_t registerAddress, uint8_t(&read_data)[], uint32_t len) {
+        NewBatchOp(BatchOp_T::Read, registerAddress, len).readBuffer = read_data;
+    };
+    void QueueDelay_us(uint32_t uSecs) {
+        NewBatchOp(BatchOp_T::Delay, 0, uSecs);
+    };
+    bool FlushBatch() {
+        BusTransaction(); // one round-trip for the whole batch
+        for(uint32_t opIdx=0; opIdx<batchCount; opIdx++) {
+            BatchOp_T &op = batch[opIdx];
+            switch(op.kind) {
+              case BatchOp_T::Write: WriteRegisters(op.registerAddress, op.data, op.len); break;
+              case BatchOp_T::Read:  ReadRegisters(op.registerAddress, op.readBuffer, op.len); break;
+              case BatchOp_T::Delay: now_us += op.len; Advance(); break;
+              case BatchOp_T::WaitINT: WaitInterruptPin(op.len); break;
+            }
+        }
+        batchCount = 0;
+        batchFlushes++;
+        return true;
+    };
+
+    // Data-ready interrupt (see MMC5983MA_IO_base_C): the host sees the INT pin, and can wait for it within a batch
+    static const bool SupportsDataReady = true;
+    bool DataReadyInit() { return intWired; };
+    bool WaitDataReady(uint32_t timeout_us) {
+        BusTransaction(); // the host learns the result in one round-trip
+        return WaitInterruptPin(timeout_us);
+    };
+    bool QueueWaitDataReady(uint32_t timeout_us) {
+        if(!intWired) return false;
+        NewBatchOp(BatchOp_T::WaitINT, 0, timeout_us);
+        return true;
+    };
+
+    // ==========  Simulation controls  ==========
+    double field_mG[3] = { 200.0, -50.0, 460.0 }; ///< Ambient field seen by the sensor (X,Y,Z), change at will
+    /// Optional time-varying field (rotation, vibration...): called with virtual time when a conversion samples
+    /// the field, overrides field_mG.
+    std::function<void(uint64_t time_us, double (&field_mG)[3])> fieldAt;
+    /// RMS noise per axis in mG for each bandwidth setting (100/200/400/800Hz); AutoSR averages two samples.
+    /// Datasheet specifies 0.4mG at 100Hz; others assume noise grows with sqrt(bandwidth). All 0 for exact outputs.
+    double noise_mG[4] = { 0.4, 0.57, 0.8, 1.13 };
+    uint64_t noiseSeed = 0x5EED5983; ///< Restart the noise sequence by assigning a new seed
+    double temperature_C = 25.0;  ///< Reported by TM_T measurements (T_out = (T+75)/0.8)
+    bool spiSetResetBug = true;   ///< With SPI interface, RESET reverses X only (see MMC5983MA.hpp notes)
+    uint32_t zeroFieldOutput[3] = { 0x20000, 0x20000, 0x20000 }; ///< Sensor bridge offset (output with zero field)
+    uint32_t transactionTime_us = 0; ///< Virtual time consumed per bus transaction (USB round-trip + I2C bits)
+    uint32_t readTransactions = 0;   ///< Bus read transactions so far
+    uint32_t writeTransactions = 0;  ///< Bus write transactions so far
+    uint32_t conversionsCompleted = 0; ///< Magnetic measurements completed by the simulated sensor
+    uint32_t temperatureConversions = 0; ///< Temperature measurements completed
+    uint32_t batchFlushes = 0;       ///< Batches executed (each costs one transactionTime_us)
+    bool intWired = true;            ///< INT pin visible to the host (false: DataReadyInit fails)
+    uint32_t intWaits = 0;           ///< Waits for the INT pin (WaitDataReady and queued)
+    uint32_t intWaitTimeouts = 0;    ///< ...that timed out with INT low
+
+    /// Simulated conversion time for the current settings (datasheet values; AutoSR does two plus SET/RESET)
+    uint32_t ConversionTime_us() const {
+        static const uint32_t usecGivenBandwidth[4] = { 8000, 4000, 2000, 500 };
+        uint32_t usec = usecGivenBandwidth[regs[Control_1] & 0x03];
+        if(regs[Control_0] & Auto_SR_en) usec = usec*2 + 1000;
+        return usec;
+    }
+
+    // ==========  Register access for an emulated bus (see FT232H_Emulator.hpp)  ==========
+    /// One byte of a bus transfer as seen by the sensor; caller counts transactions and spends virtual time
+    uint8_t BusReadRegister(uint8_t reg) { Advance(); return ReadRegister(reg); };
+    void BusWriteRegister(uint8_t reg, uint8_t value) { Advance(); WriteRegister(reg, value); };
+    /// Advance virtual time to t_us (if later), for a bus model that keeps several sensors on one clock
+    void AdvanceTo_us(uint64_t t_us) {
+        if(t_us > now_us) now_us = t_us;
+        Advance();
+    }
+    /// INT pin (active high): a magnetic measurement completed (Meas_M_Done) while INT_meas_done_en is set
+    bool InterruptPin() {
+        Advance();
+        return (regs[Control_0] & INT_meas_done_en) && (regs[Status] & Meas_M_Done);
+    }
+
+protected:
+    enum : uint8_t { // register addresses and bits as documented in MMC5983MA datasheet
+        T_out = 0x07, Status = 0x08, Control_0 = 0x09, Control_1 = 0x0a, Control_2 = 0x0b, Control_3 = 0x0c, Product_ID = 0x2f,
+        Meas_M_Done = 0x01, Meas_T_Done = 0x02, OTP_read_done = 0x10,
+        TM_M = 0x01, TM_T = 0x02, INT_meas_done_en = 0x04, SET = 0x08, RESET = 0x10, Auto_SR_en = 0x20,
+        X_inhibit = 0x04, YZ_inhibit = 0x18, SW_RST = 0x80,
+        Cmm_en = 0x08, CM_freq = 0x07, Prd_set = 0x70, En_prd_set = 0x80,
+        St_enp = 0x02, St_enm = 0x04,
+    };
+    static constexpr double CountsPerMilliGauss = 16.384; // 16384 counts/G, 18-bit output
+    static constexpr double FullScale_mG = 8000.0;
+    uint8_t regs[0x30];           ///< Register contents (control registers hold settings only)
+    uint64_t now_us = 0;          ///< Virtual time
+    bool converting = false;      ///< One-shot conversion in progress
+    uint64_t conversionDone_us = 0;
+    bool convertingTemperature = false;
+    uint64_t temperatureDone_us = 0;
+    uint64_t nextContinuous_us = 0; ///< Completion time of next continuous-mode conversion
+    uint32_t sincePeriodicSET = 0;  ///< Continuous-mode conversions since the last periodic SET
+    int polarity[3] = { +1, +1, +1 }; ///< Per axis: +1 after SET (power-on default), -1 after RESET
+    uint64_t noiseState = 0;      ///< xorshift state, 0 until first use of noiseSeed
+    uint64_t noiseSeedInUse = 0;
+
+    struct BatchOp_T {
+        enum : uint8_t { Write, Read, Delay, WaitINT } kind;
+        uint8_t registerAddress;
+        uint32_t len;          ///< bytes, or microseconds for Delay and WaitINT (timeout)
+        uint8_t data[4];       ///< copy of write data
+        uint8_t *readBuffer;   ///< destination of read data
+    };
+    static const uint32_t MaxBatchOps = 32;
+    BatchOp_T batch[MaxBatchOps];
+    uint32_t batchCount = 0;
+    BatchOp_T &NewBatchOp(decltype(BatchOp_T::kind) kind, uint8_t registerAddress, uint32_t len) {
+        assert(batchCount < MaxBatchOps);
+        BatchOp_T &op = batch[batchCount++];
+        op.kind = kind;
+        op.registerAddress = registerAddress;
+        op.len = len;
+        return op;
+    }
+    void ReadRegisters(uint8_t registerAddress, uint8_t *read_data, uint32_t len) {
+        for(uint32_t idx=0; idx<len; idx++) {
+            read_data[idx] = ReadRegister((uint8_t)(registerAddress+idx)); // MMC5983MA auto-increments address
+        }
+        readTransactions++;
+    }
+    void WriteRegisters(uint8_t registerAddress, const uint8_t *write_data, uint32_t len) {
+        for(uint32_t idx=0; idx<len; idx++) {
+            WriteRegister((uint8_t)(registerAddress+idx), write_data[idx]);
+        }
+        writeTransactions++;
+    }
+
+    void PowerOn() {
+        memset(regs, 0, sizeof(regs));
+        regs[Status] = OTP_read_done;
+        regs[Product_ID] = 0x30;
+        polarity[0] = polarity[1] = polarity[2] = +1; // power-on/reset does a SET
+        converting = convertingTemperature = false;
+        sincePeriodicSET = 0;
+    }
+    void BusTransaction() {
+        now_us += transactionTime_us;
+        Advance();
+    }
+    uint32_t ContinuousPeriod_us() const {
+        static const uint32_t usecGivenRate[8] = { 0, 1000000, 100000, 50000, 20000, 10000, 5000, 1000 };
+        return usecGivenRate[regs[Control_2] & CM_freq];
+    }
+    bool InContinuousMode() const {
+        return (regs[Control_2] & Cmm_en) && (regs[Control_2] & CM_freq);
+    }
+    /// Bring sensor state up to the current virtual time
+    void Advance() {
+        if(convertingTemperature && now_us >= temperatureDone_us) {
+            convertingTemperature = false;
+            double t_out = (temperature_C + 75.0) / 0.8;
+            regs[T_out] = (uint8_t)(t_out < 0 ? 0 : t_out > 255 ? 255 : t_out);
+            regs[Status] |= Meas_T_Done;
+            temperatureConversions++;
+        }
+        if(converting && now_us >= conversionDone_us) {
+            converting = false;
+            CompleteConversion(conversionDone_us, (regs[Control_0] & Auto_SR_en) != 0);
+        }
+        if(InContinuousMode()) {
+            uint32_t period = ContinuousPeriod_us();
+            while(now_us >= nextContinuous_us) { // only the latest result survives in output registers
+                bool autoSR = (regs[Control_0] & Auto_SR_en) != 0;
+                if(autoSR && (regs[Control_2] & En_prd_set)) {
+                    // Periodic SET (assumed behavior, datasheet is unclear): SET every Prd_set conversions,
+                    // and conversions in between are plain single-polarity measurements.
+                    static const uint32_t measurementsBetweenSET[8] = { 1, 25, 75, 100, 250, 500, 1000, 2000 };
+                    if(sincePeriodicSET == 0) DoSET();
+                    if(++sincePeriodicSET >= measurementsBetweenSET[(regs[Control_2] & Prd_set) >> 4]) sincePeriodicSET = 0;
+                    autoSR = false;
+                }
+                CompleteConversion(nextContinuous_us, autoSR);
+                nextContinuous_us += period;
+            }
+        }
+    }
+    /// Advance virtual time until INT is high (the conversion that raises it completes) or timeout_us passes
+    bool WaitInterruptPin(uint32_t timeout_us) {
+        intWaits++;
+        uint64_t end = now_us + timeout_us;
+        while(!InterruptPin() && now_us < end) {
+            uint64_t next = end; // jump to the next event that could raise INT
+            if(converting) next = std::min(next, conversionDone_us);
+            if(InContinuousMode()) next = std::min(next, nextContinuous_us);
+            now_us = std::max(next, now_us + 1);
+        }
+        if(InterruptPin()) return true;
+        intWaitTimeouts++;
+        return false;
+    }
+    void DoSET()   { polarity[0] = polarity[1] = polarity[2] = +1; };
+    void DoRESET() {
+        polarity[0] = -1;
+        if(!(UsesSPI() && spiSetResetBug)) polarity[1] = polarity[2] = -1; // SPI bug: YZ not reversed
+    }
+    /// Field the sensor sees at virtual time t_us, including saturation-test coil contribution
+    void FieldAt(uint64_t t_us, double (&mG)[3]) {
+        memcpy(mG, field_mG, sizeof(mG));
+        if(fieldAt) fieldAt(t_us, mG);
+        static const double coil_mG[3] = { 1000.0, 300.0, 200.0 }; // measured, see MMC5983MA.hpp notes
+        for(int chIdx=0; chIdx<3; chIdx++) {
+            if(regs[Control_3] & St_enp) mG[chIdx] += coil_mG[chIdx];
+            if(regs[Control_3] & St_enm) mG[chIdx] -= coil_mG[chIdx];
+        }
+    }
+    /// Standard normal deviate from a seeded xorshift64* generator (Box-Muller)
+    double Gaussian() {
+        if(noiseSeedInUse != noiseSeed || noiseState == 0) {
+            noiseSeedInUse = noiseSeed;
+            noiseState = noiseSeed ? noiseSeed : 1;
+        }
+        auto uniform = [this]() {
+            noiseState ^= noiseState >> 12; noiseState ^= noiseState << 25; noiseState ^= noiseState >> 27;
+            return ((noiseState * 0x2545F4914F6CDD1DULL) >> 11) * (1.0/9007199254740992.0); // [0,1)
+        };
+        double u1 = uniform(), u2 = uniform();
+        if(u1 < 1e-300) u1 = 1e-300;
+        return sqrt(-2.0*log(u1)) * cos(6.283185307179586*u2);
+    }
+    /// Latch a new XYZ result into the output registers and flag Meas_M_Done
+    virtual void CompleteConversion(uint64_t t_us, bool autoSR) {
+        double mG[3];
+        FieldAt(t_us, mG);
+        double sigma_mG = noise_mG[regs[Control_1] & 0x03];
+        for(int chIdx=0; chIdx<3; chIdx++) {
+            if(chIdx == 0 && (regs[Control_1] & X_inhibit)) continue; // inhibited channel keeps old output
+            if(chIdx >  0 && (regs[Control_1] & YZ_inhibit) == YZ_inhibit) continue;
+            double h = mG[chIdx];
+            if(h >  FullScale_mG) h =  FullScale_mG; // bridge saturates
+            if(h < -FullScale_mG) h = -FullScale_mG;
+            double out;
+            if(autoSR) {
+                // AutoSR: SET sample minus RESET sample, halved: offset cancels (and with the SPI bug, so does YZ field)
+                bool reverses = chIdx == 0 || !(UsesSPI() && spiSetResetBug);
+                out = 0x20000 + (reverses ? h*CountsPerMilliGauss : 0) + Gaussian()*sigma_mG*CountsPerMilliGauss/1.4142135623730951;
+                polarity[0] = polarity[1] = polarity[2] = +1; // sequence ends with a SET
+            } else {
+                out = zeroFieldOutput[chIdx] + polarity[chIdx]*h*CountsPerMilliGauss + Gaussian()*sigma_mG*CountsPerMilliGauss;
+            }
+            StoreOutput(chIdx, out < 0 ? 0 : (uint32_t)(out + 0.5));
+        }
+        regs[Status] |= Meas_M_Done;
+        conversionsCompleted++;
+    }
+    void StoreOutput(int chIdx, uint32_t out18) {
+        if(out18 > 0x3FFFF) out18 = 0x3FFFF; // saturate to 18 bits
+        regs[2*chIdx  ] = (uint8_t)(out18 >> 10);
+        regs[2*chIdx+1] = (uint8_t)(out18 >>  2);
+        int shift = 6 - 2*chIdx; // XYZ_out_2 holds X[1:0] in bits 7:6, Y in 5:4, Z in 3:2
+        regs[6] = (uint8_t)((regs[6] & ~(0x03 << shift)) | ((out18 & 0x03) << shift));
+    }
+    uint8_t ReadRegister(uint8_t reg) {
+        if(reg >= Control_0 && reg <= Control_3) return 0; // write-only registers
+        if(reg >= sizeof(regs)) return 0;
+        return regs[reg];
+    }
+    void WriteRegister(uint8_t reg, uint8_t value) {
+        switch(reg) {
+          case Status:
+            regs[Status] &= ~(value & (Meas_M_Done|Meas_T_Done)); // write-1-to-clear
+            break;
+          case Control_0:
+            if(value & SET)   DoSET();
+            if(value & RESET) DoRESET();
+            regs[Control_0] = value & ~(TM_M|TM_T|SET|RESET|0x40); // keep settings, action bits self-clear
+            if((value & TM_M) && !converting) {
+                regs[Status] &= ~Meas_M_Done; // a new measurement command resets Meas_M_Done
+                converting = true;
+                conversionDone_us = now_us + ConversionTime_us();
+            }
+            if((value & TM_T) && !convertingTemperature) {
+                regs[Status] &= ~Meas_T_Done;
+                convertingTemperature = true;
+                temperatureDone_us = now_us + ConversionTime_us();
+            }
+            break;
+          case Control_1:
+            if(value & SW_RST) { PowerOn(); break; }
+            regs[Control_1] = value;
+            break;
+          case Control_2: {
+            bool wasContinuous = InContinuousMode();
+            regs[Control_2] = value;
+            if(InContinuousMode() && !wasContinuous) { nextContinuous_us = now_us + ContinuousPeriod_us(); sincePeriodicSET = 0; }
+            } break;
+          case Control_3:
+            regs[Control_3] = value;
+            break;
+          default:
+            break; // writes to read-only registers are ignored
+        }
+    }
+};
+
+/// Several simulated MMC5983MA behind a simulated TCA9548A-style I2C mux on one bus (TBUS for
+/// MMC5983MA_MuxedBus_C, see MMC5983MA_IO_Mux.hpp). All share one virtual clock, so sensors keep
+/// converting while the bus talks to another. Each transaction (register read or write, or mux write)
+/// costs transactionTime_us; register IO with no single channel connected fails.
+class MMC5983MA_IO_SimulatedMuxBus_C : public MMC5983MA_IO_base_C {
+public:
+    static const int Channels = 8;
+    MMC5983MA_IO_Simulator_C sensor[Channels]; ///< sensor on each channel (set field_mG etc. here)
+    uint32_t transactionTime_us = 0; ///< Virtual time consumed per bus transaction
+    uint32_t transactions = 0;       ///< Bus transactions so far, including mux writes
+    MMC5983MA_IO_SimulatedMuxBus_C() : MMC5983MA_IO_base_C(I2C) {
+        for(int ch=0; ch<Channels; ch++) sensor[ch].noiseSeed += (uint64_t)ch; // independent noise per sensor
+    };
+
+    void Init() {};
+    void read(uint8_t registerAddress, uint8_t(&read_data)[], uint32_t len) {
+        MMC5983MA_IO_Simulator_C *s = Connected();
+        for(uint32_t idx=0; idx<len; idx++) read_data[idx] = s ? s->BusReadRegister((uint8_t)(registerAddress+idx)) : 0xFF;
+    };
+    void write(uint8_t registerAddress, const uint8_t(&write_data)[], uint32_t len) {
+        MMC5983MA_IO_Simulator_C *s = Connected();
+        for(uint32_t idx=0; s && idx<len; idx++) s->BusWriteRegister((uint8_t)(registerAddress+idx), write_data[idx]);
+    };
+    void WriteMux(uint8_t, uint8_t channelMask_) {
+        Transaction();
+        channelMask = channelMask_;
+        ioOK = true;
+    };
+    void delay_us(uint32_t uSecs) { now_us += uSecs; };
+    uint64_t time_us() { return now_us; };
+    bool IO_OK(void) { return ioOK; };
+
+protected:
+    uint64_t now_us = 0;     ///< Virtual time shared by all sensors
+    uint8_t channelMask = 0; ///< mux control register
+    bool ioOK = true;
+    void Transaction() {
+        now_us += transactionTime_us;
+        transactions++;
+    }
+    /// One register transaction: the connected sensor, brought up to the bus's time (nullptr if none or several)
+    MMC5983MA_IO_Simulator_C *Connected() {
+        Transaction();
+        ioOK = channelMask && !(channelMask & (channelMask-1));
+        if(!ioOK) return nullptr;
+        int ch = 0;
+        while(!(channelMask & (1u << ch))) ch++;
+        sensor[ch].AdvanceTo_us(now_us);
+        return &sensor[ch];
+    }
+};
+
+#endif // MMC5983MA_IO_Simulator_HPP_INCLUDED
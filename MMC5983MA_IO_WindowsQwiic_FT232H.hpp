@@ -27,15 +27,22 @@ SOFTWARE.
 #ifndef MMC5983MA_IO_WindowsQwiic_FT232H_HPP_INCLUDED
 #define MMC5983MA_IO_WindowsQwiic_FT232H_HPP_INCLUDED
 
+#include <assert.h>
+#include <string.h> // memcpy
 #include <thread>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <vector>
 
 #include "MMC5983MA_IO.hpp"
+#include "MMC5983MA_Delay.hpp"
 extern "C" { // antique FTDI headers lack this
     #include "ftdi_infra.h"  /*Common portable infrastructure (datatypes, libraries, etc)*/
     #include "ftdi_common.h" /*Common across I2C, SPI, JTAG modules*/
     // Set up to use MPSSE library etc, cribbed from simple-static.c example
     #include "ftd2xx.h"
-    #include "libMPSSE_i2c.h" // Bizarrely, redefines stuff from ftdi_i2c.h
+    #include "libmpsse_i2c.h" // Bizarrely, redefines stuff from ftdi_i2c.h
 }
 
 // Provide IO primitives for MMC5983MA IO wrapping FT232H API
@@ -44,32 +51,27 @@ public:
     MMC5983MA_IO_WindowsQwiic_FT232H_C() : MMC5983MA_IO_base_C(I2C) {}; // Warning: no communications initialization in ctor
     // Implement the base class IO function suggestions in this derived class
     void read(uint8_t registerAddress, uint8_t(&read_data)[], uint32_t len) {
-        DWORD bytesTransferred;
-        // 4,5) write start-bit/slave address, then register address (should wait for ACK)
-        // int ret1 = mcp2221.Mcp2221_I2cWrite(1, slave7bitAddress, true, &registerAddress);
-        bytesTransferred = 0;
-        ftStatus = I2C_DeviceWrite(ftHandle, slave7bitAddress, 1, &registerAddress, \
-            & bytesTransferred, I2C_TRANSFER_OPTIONS_START_BIT);
+        // START, address, register address, repeated START, address+read, len bytes (last nAcked), STOP:
+        // all in one MPSSE command buffer with a single read-back (one USB round-trip).
+        // Previously I2C_DeviceWrite then I2C_DeviceRead, which cost a round-trip per byte.
+        DWORD bytesTransferred = 0;
+        UCHAR reg = registerAddress;
+        ftStatus = I2C_DeviceWriteRead(ftHandle, slave7bitAddress, 1, &reg, len, read_data, &bytesTransferred);
         if (ftStatus == FT_DEVICE_NOT_FOUND) {
             DiagPrintf("Ooops, device 0x%x not found!\n", slave7bitAddress);
-            DiagPrintf("...failed to read an ACK after sending device address in I2C_Write8bitsAndGetAck\n");
+            DiagPrintf("...failed to read an ACK after sending device address in I2C_DeviceWriteRead\n");
         }
         assert(ftStatus == FT_OK);
-        assert(bytesTransferred == 1);
-        // 6,7) another start bit, sensor address with 'read' bit set, then start reading
-        // int ret2 = mcp2221.Mcp2221_I2cRead(len, slave7bitAddress, true, read_data);
-        bytesTransferred = 0;
-        ftStatus = I2C_DeviceRead(ftHandle, slave7bitAddress, len, read_data, \
-            & bytesTransferred, I2C_TRANSFER_OPTIONS_START_BIT | I2C_TRANSFER_OPTIONS_NACK_LAST_BYTE);
-        assert(ftStatus == FT_OK);
         assert(bytesTransferred == len);
     };
     void write(uint8_t registerAddress, const uint8_t(&write_data)[], uint32_t len) {
-        assert(len == 1);
-        UCHAR buf[2] = { registerAddress, write_data[0] };
+        UCHAR buf[8];
+        assert(len < sizeof(buf));
+        buf[0] = registerAddress;
+        memcpy(&buf[1], write_data, len);
         // int ret1 = mcp2221.Mcp2221_I2cWrite(2, slave7bitAddress, true, buf);
         DWORD bytesTransferred = 0;
-        ftStatus = I2C_DeviceWrite(ftHandle, slave7bitAddress, 2, buf, \
+        ftStatus = I2C_DeviceWrite(ftHandle, slave7bitAddress, len+1, buf, \
             & bytesTransferred, I2C_TRANSFER_OPTIONS_START_BIT);
         if (ftStatus == FT_DEVICE_NOT_FOUND) {
             DiagPrintf("Ooops, device 0x%x not found!\n", slave7bitAddress);
@@ -77,16 +79,51 @@ public:
         }
         assert(ftStatus == FT_OK);
     };
+    /// I2C mux channel select (see MMC5983MA_IO_Mux.hpp)
+    void WriteMux(uint8_t muxAddress, uint8_t channelMask) {
+        DWORD bytesTransferred = 0;
+        UCHAR buf[1] = { channelMask };
+        ftStatus = I2C_DeviceWrite(ftHandle, muxAddress, 1, buf, &bytesTransferred, I2C_TRANSFER_OPTIONS_START_BIT);
+        if (ftStatus == FT_DEVICE_NOT_FOUND) DiagPrintf("Ooops, I2C mux 0x%x not found!\n", muxAddress);
+        assert(ftStatus == FT_OK);
+    };
+    MMC5983MA_HybridDelay_C delay; ///< sleep-then-spin delays; see delay.PrintStatistics
     void delay_us(uint32_t uSecs) {
-        std::this_thread::sleep_for(std::chrono::microseconds(uSecs));
+        delay.Delay_us(uSecs);
+    };
+    uint64_t time_us() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
     };
     void Init() { // not invoked by ctor; do this before using IO functions!
         Init_libMPSSE(); // This application builds MPSSE components into EXE; so Init_lib is not automatically called on DLL load.
         DiagPrintf("ftd2xx.dll loaded OK!\n");
-        DWORD numChannels;
+        OpenChannel();
+    };
+    // Which adapter Init opens, when several are attached (see MMC5983MA_Fleet_C)
+    uint32_t channelIndex = 0;       ///< channel number (I2C_GetChannelInfo order), unless channelSerialNumber is set
+    std::string channelSerialNumber; ///< open the channel with this USB serial number (see ChannelSerialNumbers)
+    /// Serial numbers of the attached MPSSE channels, in channel-number order
+    /// (D2XX function table must already be loaded: Init_libMPSSE or FT232H_Emulator_C::Install)
+    static std::vector<std::string> ChannelSerialNumbers() {
+        std::vector<std::string> serials;
+        DWORD numChannels = 0;
+        if (I2C_GetNumChannels(&numChannels) != FT_OK) return serials;
+        for (uint32 i = 0; i < numChannels; i++) {
+            FT_DEVICE_LIST_INFO_NODE devList;
+            if (I2C_GetChannelInfo(i, &devList) == FT_OK) serials.push_back(devList.SerialNumber);
+        }
+        return serials;
+    };
+    /// Find, open, and configure the selected FT232H I2C channel (D2XX function table must already be loaded).
+    /// Throws std::runtime_error if there is no such channel.
+    void OpenChannel() {
+        DWORD numChannels = 0;
         ftStatus = I2C_GetNumChannels(&numChannels);
-        assert(numChannels >= 1);
-        DiagPrintf("Found at least one channel on FT232H\n");
+        if (ftStatus != FT_OK || numChannels < 1)
+            throw std::runtime_error("No FT232H connected to this PC");
+        DiagPrintf("Found %u channel(s) on FT232H\n", (unsigned)numChannels);
+        uint32 channel = channelIndex;
+        bool found = channelSerialNumber.empty() && channelIndex < numChannels;
         for (uint32 i = 0; i < numChannels; i++)
         {
             FT_DEVICE_LIST_INFO_NODE devList;
@@ -101,14 +138,23 @@ public:
             DiagPrintf("		SerialNumber=%s\n", devList.SerialNumber);
             DiagPrintf("		Description=%s\n", devList.Description);
             DiagPrintf("		ftHandle=0x%p (0 unless channel is open)\n", (void*)devList.ftHandle);
+            if (!channelSerialNumber.empty() && channelSerialNumber == devList.SerialNumber) {
+                channel = i;
+                found = true;
+            }
+        }
+        if (!found) {
+            throw std::runtime_error(channelSerialNumber.empty() ?
+                "No FT232H channel " + std::to_string(channelIndex) + " (" + std::to_string(numChannels) + " found)" :
+                "No FT232H with serial number " + channelSerialNumber);
         }
         DiagPrintf("\nVersion Check\n");
         DWORD verMPSSE, verD2XX;
         ftStatus = Ver_libMPSSE(&verMPSSE, &verD2XX);
         // Never set for non-DLL build: DiagPrintf("libmpsse: %08x\n", verMPSSE);
         DiagPrintf("libftd2xx: %08x\n", verD2XX);
-        /* Open the first available channel */
-        ftStatus = I2C_OpenChannel(/*channel=*/0, &ftHandle);
+        /* Open the selected channel (default: the first) */
+        ftStatus = I2C_OpenChannel(channel, &ftHandle);
         assert(ftStatus == FT_OK);
         ChannelConfig channelConf = {
             .ClockRate = I2C_CLOCK_STANDARD_MODE,
@@ -120,7 +166,7 @@ public:
             .Pin = 0,
             .currentPinState = 0,
             };
-        channelConf.ClockRate = I2C_CLOCK_STANDARD_MODE;
+        channelConf.ClockRate = clockRate;
         channelConf.LatencyTimer = 100;
         channelConf.Options = 0
             | I2C_DISABLE_3PHASE_CLOCKING
@@ -132,10 +178,103 @@ public:
         DiagPrintf("MMC5983MA_IO_WindowsQwiic_FT232H_C::init opened and initialized channel AOK\n");
     };
     bool IO_OK(void) { return ftStatus == 0; };
+    /// libMPSSE per-channel counters: transfers, failures, purges, arena uses vs. heap allocations
+    I2C_TransferStatistics TransferStatistics() {
+        I2C_TransferStatistics stats = {};
+        I2C_GetTransferStatistics(ftHandle, &stats);
+        return stats;
+    };
+    /// true: libMPSSE allocates every command buffer and purges before every write, as it used to (for comparison)
+    void LegacyTransfers(bool legacy) { I2C_SetLegacyTransfers(ftHandle, legacy); };
+
+    // Transaction batching: the whole sequence is compiled into one MPSSE command buffer
+    // (delays become MPSSE clock cycles) and executed with one USB write and one USB read.
+    static const bool SupportsBatching = true;
+    void BeginBatch() {
+        ftStatus = I2C_BatchBegin(&batch, batchCommands, sizeof(batchCommands), clockRate);
+    };
+    void QueueWrite(uint8_t registerAddress, const uint8_t(&write_data)[], uint32_t len) {
+        UCHAR buf[8];
+        assert(len < sizeof(buf));
+        buf[0] = registerAddress;
+        memcpy(&buf[1], write_data, len);
+        ftStatus = I2C_BatchQueueWrite(&batch, slave7bitAddress, len+1, buf);
+        assert(ftStatus == FT_OK);
+    };
+    void QueueRead(uint8_t registerAddress, uint8_t(&read_data)[], uint32_t len) {
+        UCHAR reg = registerAddress;
+        ftStatus = I2C_BatchQueueWriteRead(&batch, slave7bitAddress, 1, &reg, len, read_data); // repeated start, last byte nAcked
+        assert(ftStatus == FT_OK);
+    };
+    void QueueDelay_us(uint32_t uSecs) {
+        ftStatus = I2C_BatchQueueDelay(&batch, uSecs);
+        assert(ftStatus == FT_OK);
+    };
+    void QueueWriteMux(uint8_t muxAddress, uint8_t channelMask) {
+        UCHAR buf[1] = { channelMask };
+        ftStatus = I2C_BatchQueueWrite(&batch, muxAddress, 1, buf);
+        assert(ftStatus == FT_OK);
+    };
+    bool FlushBatch() {
+        ftStatus = I2C_BatchFlush(ftHandle, &batch);
+        if (ftStatus == FT_DEVICE_NOT_FOUND) {
+            DiagPrintf("Ooops, device 0x%x not found!\n", slave7bitAddress);
+            DiagPrintf("...failed to read an ACK after sending device address in I2C_BatchFlush\n");
+        }
+        return ftStatus == FT_OK;
+    };
+
+    // Data-ready: the MMC5983MA INT output (active high) wired to an FT232H input, see
+    // MMC5983MA_C::EnableDataReadyInterrupt. On ADBUS5 (GPIOL1) the MPSSE itself clocks until INT
+    // goes high, so the wait and the result read share one batch (one USB round-trip); on an ACBUS
+    // line INT is polled with FT_ReadGPIO (a USB round-trip per poll, but no I2C traffic).
+    typedef enum { DataReady_NotWired, DataReady_GPIOL1, DataReady_ACBUS } DataReadyWiring_T;
+    DataReadyWiring_T dataReadyWiring = DataReady_NotWired; ///< set before MMC5983MA_C::EnableDataReadyInterrupt
+    UCHAR dataReadyACBUSMask = 0x01; ///< DataReady_ACBUS: the line wired to INT (0x01 = ACBUS0)
+    static const bool SupportsDataReady = true;
+    bool DataReadyInit() {
+        if (dataReadyWiring == DataReady_ACBUS) {
+            ftStatus = FT_WriteGPIO(ftHandle, 0x00, 0x00); // all ACBUS lines inputs
+            return ftStatus == FT_OK;
+        }
+        return dataReadyWiring == DataReady_GPIOL1;
+    };
+    bool WaitDataReady(uint32_t timeout_us) {
+        if (dataReadyWiring == DataReady_GPIOL1) {
+            I2C_Batch waitBatch;
+            UCHAR waitCommands[128];
+            UCHAR pins = 0;
+            I2C_BatchBegin(&waitBatch, waitCommands, sizeof(waitCommands), clockRate);
+            ftStatus = I2C_BatchQueueWaitGPIOL1(&waitBatch, TRUE, timeout_us, &pins);
+            if (ftStatus == FT_OK) ftStatus = I2C_BatchFlush(ftHandle, &waitBatch);
+            return ftStatus == FT_OK && (pins & 0x20) != 0;
+        }
+        if (dataReadyWiring == DataReady_ACBUS) {
+            uint64_t start = time_us();
+            for (;;) { // each FT_ReadGPIO is a USB round-trip, so no delay between polls
+                UCHAR pins = 0;
+                ftStatus = FT_ReadGPIO(ftHandle, &pins);
+                if (ftStatus != FT_OK) return false;
+                if (pins & dataReadyACBUSMask) return true;
+                if (time_us() - start >= timeout_us) return false;
+            }
+        }
+        return false;
+    };
+    bool QueueWaitDataReady(uint32_t timeout_us) {
+        if (dataReadyWiring != DataReady_GPIOL1) return false; // ACBUS can't be read inside an MPSSE batch
+        ftStatus = I2C_BatchQueueWaitGPIOL1(&batch, TRUE, timeout_us, NULL);
+        assert(ftStatus == FT_OK);
+        return true;
+    };
+
     const static uint8_t slave7bitAddress = (0b0110000); /// The MEMSIC device 7 - bit device WRITE address is[0110000] (left-shifted, then optional OR'd with read-bit 1)
     // FTDI-specific stuff
     FT_HANDLE ftHandle = 0;
     FT_STATUS ftStatus = 0;
+    I2C_CLOCKRATE clockRate = I2C_CLOCK_STANDARD_MODE;
+    I2C_Batch batch;
+    UCHAR batchCommands[8192]; ///< MPSSE commands for one batch (RESET/measure/SET/measure needs about 2KB, RESET/SET/RESET with INT waits about 4KB)
 };
 
 #endif // MMC5983MA_IO_WindowsQwiic_FT232H_HPP_INCLUDED
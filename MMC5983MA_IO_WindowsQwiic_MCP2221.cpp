@@ -25,7 +25,9 @@ SOFTWARE.
 */
 
 #include <assert.h>
+#include <string.h> // memcpy
 #include <thread>
+#include <chrono>
 
 #include "MCP2221.hpp"
 #include "MMC5983MA_IO_WindowsQwiic_MCP2221.hpp"
@@ -39,21 +41,29 @@ void MMC5983MA_IO_WindowsQwiic_MCP2221_C::Init() {
 void  MMC5983MA_IO_WindowsQwiic_MCP2221_C::read(uint8_t registerAddress, uint8_t(&read_data)[], uint32_t len) {
     assert(mcp2221.IsOpen());
     // 4,5) write start-bit/slave address, then register address (should wait for ACK)
-    int ret1 = mcp2221.Mcp2221_I2cWrite(1, slave7bitAddress, true, &registerAddress);
-    assert(ret1 == 0);
+    // Failures are reported by IO_OK (last_IO_status), not asserted: the driver counts them and fails the measurement.
+    last_IO_status = mcp2221.Mcp2221_I2cWrite(1, slave7bitAddress, true, &registerAddress);
+    if(last_IO_status != 0) return;
     // 6,7) another start bit, sensor address with 'read' bit set, then start reading
-    int ret2 = mcp2221.Mcp2221_I2cRead(len, slave7bitAddress, true, read_data);
-    assert(ret2 == 0);
+    last_IO_status = mcp2221.Mcp2221_I2cRead(len, slave7bitAddress, true, read_data);
 }
 void MMC5983MA_IO_WindowsQwiic_MCP2221_C::write(uint8_t registerAddress, const uint8_t(&write_data)[], uint32_t len) {
     assert(mcp2221.IsOpen());
     // Note: MMC5983MA DOES auto-increment write address
-    // Anyway, API only ever writes 1 byte here.
-    assert(len == 1);
-    uint8_t buf[2] = { registerAddress, write_data[0] };
-    int ret1 = mcp2221.Mcp2221_I2cWrite(2, slave7bitAddress, true, buf);
-    assert(ret1 == 0);
+    // (the driver writes Status and Control 0 together to start a conversion waiting for INT).
+    uint8_t buf[8];
+    assert(len < sizeof(buf));
+    buf[0] = registerAddress;
+    memcpy(&buf[1], write_data, len);
+    last_IO_status = mcp2221.Mcp2221_I2cWrite(len+1, slave7bitAddress, true, buf);
+}
+void MMC5983MA_IO_WindowsQwiic_MCP2221_C::WriteMux(uint8_t muxAddress, uint8_t channelMask) {
+    assert(mcp2221.IsOpen());
+    last_IO_status = mcp2221.Mcp2221_I2cWrite(1, muxAddress, true, &channelMask);
 }
 void MMC5983MA_IO_WindowsQwiic_MCP2221_C::delay_us(uint32_t uSecs) {
-    std::this_thread::sleep_for(std::chrono::microseconds(uSecs));
+    delay.Delay_us(uSecs);
+}
+uint64_t MMC5983MA_IO_WindowsQwiic_MCP2221_C::time_us() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
 }
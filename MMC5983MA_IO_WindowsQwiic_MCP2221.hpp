@@ -28,6 +28,7 @@ SOFTWARE.
 #define MMC5983MA_IO_WindowsQwiic_MCP2221_HPP_INCLUDED
 
 #include "MMC5983MA_IO.hpp"
+#include "MMC5983MA_Delay.hpp"
 #include "MCP2221.hpp"
 
 // Provide IO primitives for MMC5983MA API
@@ -39,7 +40,10 @@ public:
     void Init(); // not invoked by ctors; do this before using MMC5983MA_IO_WindowsQwiic_C!
     void read(uint8_t reg_addr, uint8_t(&read_data)[], uint32_t len);
     void write(uint8_t reg_addr, const uint8_t(&write_data)[], uint32_t len);
+    void WriteMux(uint8_t muxAddress, uint8_t channelMask); // I2C mux channel select (see MMC5983MA_IO_Mux.hpp)
     void delay_us(uint32_t period);
+    MMC5983MA_HybridDelay_C delay; ///< sleep-then-spin delays; see delay.PrintStatistics
+    uint64_t time_us();
     int last_IO_status = 0;
     bool IO_OK(void) { return last_IO_status == 0; };
     // const uint8_t slave7bitAddress = 0x77; // kludge try DSP310
@@ -0,0 +1,200 @@
+// MMC5983MA_Replay.cpp - run MMC5983MA_C against a recorded session (register trace, text log, or capture)
+
+/*
+MIT License
+
+Copyright (c) 2023-2025 Dave Nadler
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+// usage: MMC5983MA_Replay [--fast] [--mode M] [--verbose] recording
+// The recording is one of:
+//   - a binary register trace (MMC5983MA_Benchmark --trace) or a text log of "get_reg xx Name => yy" lines
+//     (ExampleMagnitudeProblemLog.txt): MMC5983MA_IO_Replay_C answers the driver's reads from it and checks
+//     its writes; the driver measures in mode M (default ResetSet) until the recording runs out.
+//   - a binary capture (MMC5983MA_Benchmark --capture): MMC5983MA_IO_CaptureReplay_C; each frame is measured
+//     again in its recorded mode and bandwidth, and the field is checked against the recorded one (exact for
+//     ResetSet, AutoSR and RSR; Cached and Alternate combine conversions from several measurements, whose
+//     offset refreshes and pairings the replay needn't repeat, so they differ by about the noise).
+// Every field is fed to the calibration (MMC5983MA_Calibration.hpp) and noise statistics (MMC5983MA_Statistics.hpp)
+// that CompassTest uses, and the results are printed with the replay's throughput, so changes to them can be
+// checked and timed against real data. --fast runs on virtual time instead of waiting out the recorded delays
+// (capture replay always does).
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <chrono>
+#include <memory>
+
+#include "MMC5983MA.hpp"
+#include "MMC5983MA_IO_Replay.hpp"
+#include "MMC5983MA_Calibration.hpp"
+#include "MMC5983MA_Statistics.hpp"
+
+static bool verbose = false;
+int MMC5983MA_IO_base_C::DiagPrintf(const char* format, ...) {
+    if(!verbose) return 0;
+    va_list args;
+    va_start(args, format);
+    int n = vfprintf(stderr, format, args);
+    va_end(args);
+    return n;
+}
+
+/// MMC5983MA_C with the IO device exposed
+template <typename TDEVICE>
+class MMC5983MA_Replayed_C : public MMC5983MA_C<TDEVICE> {
+  public:
+    TDEVICE &Dev() { return this->dev; };
+};
+
+static const char *modeNames[] = { "ResetSet", "AutoSR", "Cached", "RSR", "Alternate" }; // MMC5983MA_MeasurementMode_T order
+
+/// Calibration and noise statistics over every replayed field
+struct Analysis_T {
+    MMC5983MA_EllipsoidCalibration_C calibration;
+    MMC5983MA_FieldStatistics_C<> statistics;
+    uint32_t samples = 0;
+    void Add(const MMC5983MA_Sample_T &s) {
+        double field_mG[3];
+        for(int i = 0; i < 3; i++) field_mG[i] = s.field[i] * (1000.0 / MMC5983MA_C<MMC5983MA_IO_Replay_C>::CountsPerGauss);
+        if(verbose) printf("%8u %-9s field %7d %7d %7d  mG %8.2f %8.2f %8.2f\n", s.sequence, modeNames[s.mode % 5],
+            s.field[0], s.field[1], s.field[2], field_mG[0], field_mG[1], field_mG[2]);
+        calibration.Add(field_mG);
+        statistics.Add(field_mG);
+        samples++;
+    }
+    void Print() const {
+        typedef MMC5983MA_FieldStatistics_C<> Stats_C;
+        const Stats_C::View_T &v = statistics.Session();
+        if(v.Count()) {
+            printf("Field mG: ");
+            for(int c = 0; c < Stats_C::Channels; c++)
+                printf("%s mean %.2f sd %.3f [%.2f, %.2f]%s", Stats_C::ChannelName(c), v.channel[c].mean, v.channel[c].StdDev(),
+                    v.channel[c].min, v.channel[c].max, c + 1 < Stats_C::Channels ? "; " : "\n");
+        }
+        MMC5983MA_EllipsoidCalibration_C::Correction_T k = calibration.Solve();
+        printf("Calibration: %s from %u samples, bias mG %.2f, %.2f, %.2f, field %.2fmG, fit error %.2f%%\n",
+            MMC5983MA_EllipsoidCalibration_C::ModelName(k.model), k.samples, k.bias_mG[0], k.bias_mG[1], k.bias_mG[2],
+            k.radius_mG, 100.0 * k.fitError);
+    }
+};
+
+static int ReplayRegisters(const char *path, bool fast, MMC5983MA_MeasurementMode_T mode) {
+    auto compass = std::make_unique<MMC5983MA_Replayed_C<MMC5983MA_IO_Replay_C>>();
+    MMC5983MA_IO_Replay_C &dev = compass->Dev();
+    if(!dev.Load(path)) { fprintf(stderr, "'%s' has no register IO to replay\n", path); return 2; }
+    dev.fast = fast;
+    size_t records = dev.recording.size();
+    auto t0 = std::chrono::steady_clock::now();
+    if(compass->Init() != 0) fprintf(stderr, "Init failed (record %zu)\n", dev.Position());
+    Analysis_T analysis;
+    uint32_t failures = 0;
+    while(!dev.Finished()) {
+        size_t before = dev.Position();
+        MMC5983MA_Sample_T s = compass->Measure(mode);
+        if(s.Ok()) analysis.Add(s);
+        else if(!dev.Finished()) failures++;
+        if(dev.Position() == before) break; // nothing more this mode's measurements can use
+    }
+    double elapsed_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    const MMC5983MA_IO_Replay_C::Statistics_T &st = dev.stats;
+    printf("%s: %zu records, %zu used; %u measurements (%s), %u failed, in %.3fs (%.0f/s)\n", path, records, dev.Position(),
+        analysis.samples, modeNames[(int)mode], failures, elapsed_s, elapsed_s > 0 ? analysis.samples / elapsed_s : 0.0);
+    printf("Reads: %u replayed, %u not in the recording; writes: %u matched, %u not in the recording; %u records skipped\n",
+        st.readsReplayed, st.readsUnrecorded, st.writesMatched, st.writesMismatched, st.recordsSkipped);
+    if(st.writesMismatched) printf("First write mismatch: %s\n", dev.firstMismatch);
+    analysis.Print();
+    return st.writesMismatched ? 1 : 0;
+}
+
+static int ReplayCapture(const char *path) {
+    auto compass = std::make_unique<MMC5983MA_Replayed_C<MMC5983MA_IO_CaptureReplay_C>>();
+    MMC5983MA_IO_CaptureReplay_C &dev = compass->Dev();
+    if(!dev.Open(path)) { fprintf(stderr, "Can't read capture '%s'\n", path); return 2; }
+    const MMC5983MA_CaptureReader_C &capture = dev.capture;
+    auto t0 = std::chrono::steady_clock::now();
+    if(compass->Init() != 0) { fprintf(stderr, "Init failed\n"); return 2; }
+    dev.Start();
+    typedef MMC5983MA_C<MMC5983MA_IO_CaptureReplay_C>::Bandwidth_T Bandwidth_T;
+    Analysis_T analysis;
+    uint32_t mismatches = 0, failures = 0, exactMismatches = 0;
+    uint32_t measured[5] = {}, differ[5] = {}; // per mode
+    for(uint64_t i = 0; i < capture.Frames(); i++) {
+        const MMC5983MA_CaptureFrame_T &frame = capture.Frame(i);
+        uint64_t now = dev.time_us(), due = dev.FrameTime_us(i);
+        if(due > now) dev.delay_us((uint32_t)std::min<uint64_t>(due - now, UINT32_MAX));
+        compass->SetBandwidth((Bandwidth_T)frame.Bandwidth());
+        dev.SelectFrame(i);
+        MMC5983MA_Sample_T s = compass->Measure((MMC5983MA_MeasurementMode_T)frame.Mode());
+        if(!s.Ok()) { failures++; continue; } // ie Alternate priming
+        uint32_t raw[3];
+        int32_t field[3];
+        capture.Decode(i, raw, field);
+        measured[s.mode % 5]++;
+        if(memcmp(field, s.field, sizeof(field)) != 0) {
+            differ[s.mode % 5]++;
+            if(s.mode != (uint8_t)MMC5983MA_MeasurementMode_T::CachedOffset && s.mode != (uint8_t)MMC5983MA_MeasurementMode_T::Alternating)
+                exactMismatches++;
+            if(mismatches++ == 0 || verbose)
+                printf("Frame %llu (%s): field %d, %d, %d replayed as %d, %d, %d\n", (unsigned long long)i, modeNames[s.mode % 5],
+                    field[0], field[1], field[2], s.field[0], s.field[1], s.field[2]);
+        }
+        analysis.Add(s);
+    }
+    double elapsed_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    const MMC5983MA_CaptureHeader_T &h = capture.Header();
+    printf("%s: %llu frames from '%s' (%llu dropped while capturing); %u measured, %u failed, %u differ from the capture, in %.3fs (%.0f/s)\n",
+        path, (unsigned long long)capture.Frames(), h.adapter, (unsigned long long)h.dropped, analysis.samples, failures, mismatches,
+        elapsed_s, elapsed_s > 0 ? analysis.samples / elapsed_s : 0.0);
+    for(int m = 0; m < 5; m++)
+        if(measured[m]) printf("  %-9s %u measured, %u differ\n", modeNames[m], measured[m], differ[m]);
+    analysis.Print();
+    return exactMismatches ? 1 : 0;
+}
+
+int main(int argc, char **argv) {
+    bool fast = false;
+    int mode = 0;
+    const char *path = nullptr;
+    for(int i = 1; i < argc; i++) {
+        if(!strcmp(argv[i], "--fast")) fast = true;
+        else if(!strcmp(argv[i], "--verbose")) verbose = true;
+        else if(!strcmp(argv[i], "--mode") && i+1 < argc) {
+            const char *m = argv[++i];
+            for(mode = 0; mode < 5 && strcmp(m, modeNames[mode]); mode++) {} // 5: unknown
+        }
+        else if(!path && argv[i][0] != '-') path = argv[i];
+        else { path = nullptr; break; }
+    }
+    if(!path || mode == 5) {
+        fprintf(stderr, "usage: MMC5983MA_Replay [--fast] [--mode ResetSet|AutoSR|Cached|RSR|Alternate] [--verbose] recording\n"
+                        "  recording: MMC5983MA_Benchmark --trace or --capture file, or a text log of get_reg/set_reg lines\n");
+        return 2;
+    }
+    FILE *f = fopen(path, "rb");
+    if(!f) { fprintf(stderr, "Can't open '%s'\n", path); return 2; }
+    char magic[8] = {};
+    bool isCapture = fread(magic, sizeof(magic), 1, f) == 1 && memcmp(magic, "MMCCAPTR", 8) == 0;
+    fclose(f);
+    return isCapture ? ReplayCapture(path) : ReplayRegisters(path, fast, (MMC5983MA_MeasurementMode_T)mode);
+}
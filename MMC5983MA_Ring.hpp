@@ -0,0 +1,81 @@
+/// MMC5983MA_Ring.hpp - MMC5983MA_Ring_C class - fixed-capacity single-producer/single-consumer ring.
+
+/*
+MIT License
+
+Copyright (c) 2023-2025 Dave Nadler
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef MMC5983MA_RING_HPP_INCLUDED
+#define MMC5983MA_RING_HPP_INCLUDED
+
+#include <stdint.h>
+#include <stddef.h> // size_t
+#include <atomic>
+
+/// Fixed-capacity ring buffer, no heap allocation. <BR>
+/// Safe without locks for exactly one producer thread (Push) and one consumer thread (Pop),
+/// for example the continuous-mode acquisition loop and the application reading samples.
+/// When full, Push refuses the new element and counts it in 'overruns'
+/// (already-queued samples are never overwritten under the consumer's feet).
+template <typename T, size_t CAPACITY>
+class MMC5983MA_Ring_C {
+    static_assert(CAPACITY >= 2 && (CAPACITY & (CAPACITY-1)) == 0, "CAPACITY must be a power of 2");
+  public:
+    /// Producer: append one element; returns false (and counts an overrun) if the ring is full.
+    bool Push(const T &item) {
+        size_t head_ = head.load(std::memory_order_relaxed);
+        if(head_ - tail.load(std::memory_order_acquire) >= CAPACITY) {
+            overruns.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        items[head_ & (CAPACITY-1)] = item;
+        head.store(head_+1, std::memory_order_release);
+        return true;
+    }
+    /// Consumer: remove the oldest element; returns false if the ring is empty.
+    bool Pop(T &item) {
+        size_t tail_ = tail.load(std::memory_order_relaxed);
+        if(tail_ == head.load(std::memory_order_acquire))
+            return false;
+        item = items[tail_ & (CAPACITY-1)];
+        tail.store(tail_+1, std::memory_order_release);
+        return true;
+    }
+    /// Number of elements currently queued (exact only when called from producer or consumer)
+    size_t Count() const {
+        return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+    }
+    bool IsEmpty() const { return Count() == 0; };
+    /// Consumer: discard everything queued
+    void Clear() { tail.store(head.load(std::memory_order_acquire), std::memory_order_release); };
+    static constexpr size_t Capacity() { return CAPACITY; };
+    /// Elements refused by Push because the consumer did not keep up
+    uint32_t Overruns() const { return overruns.load(std::memory_order_relaxed); };
+
+  private:
+    T items[CAPACITY];
+    std::atomic<size_t> head {0}; ///< next slot to write, only modified by producer
+    std::atomic<size_t> tail {0}; ///< next slot to read, only modified by consumer
+    std::atomic<uint32_t> overruns {0};
+};
+
+#endif // MMC5983MA_RING_HPP_INCLUDED
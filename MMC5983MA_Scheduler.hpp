@@ -0,0 +1,115 @@
+/// MMC5983MA_Scheduler.hpp - MMC5983MA_PeriodicScheduler_C class - drift-free periodic deadlines with jitter statistics.
+
+/*
+MIT License
+
+Copyright (c) 2023-2025 Dave Nadler
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef MMC5983MA_SCHEDULER_HPP_INCLUDED
+#define MMC5983MA_SCHEDULER_HPP_INCLUDED
+
+#include <stdint.h>
+#include <math.h>
+#include <algorithm> // std::min
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include "MMC5983MA_Delay.hpp"
+
+/// Periodic deadlines on the monotonic (steady) clock. Deadline k is start + k*period, computed
+/// from the start time rather than from the previous wakeup, so sleep overshoot and time spent
+/// measuring never accumulate as drift. A cycle that runs past the following deadline is an
+/// overrun: the next cycle starts late, and any whole periods missed are skipped (not run
+/// back-to-back), keeping the original phase.
+class MMC5983MA_PeriodicScheduler_C {
+  public:
+    /// Lateness is how long after its deadline each cycle actually started
+    struct Statistics_T {
+        uint32_t cycles;          ///< WaitNext calls that returned a deadline
+        uint32_t overruns;        ///< cycles that ran past the following deadline
+        uint32_t skippedPeriods;  ///< deadlines skipped because of overruns
+        int64_t minLateness_us, maxLateness_us;
+        double sumLateness_us, sumSqLateness_us;
+        double MeanLateness_us() const { return cycles ? sumLateness_us/cycles : 0; };
+        /// Standard deviation of lateness, ie period jitter
+        double Jitter_us() const {
+            if(cycles < 2) return 0;
+            double mean = MeanLateness_us();
+            double var = sumSqLateness_us/cycles - mean*mean;
+            return var > 0 ? sqrt(var) : 0;
+        };
+    };
+    Statistics_T stats = {};
+
+    static uint64_t Now_us() {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+    /// First deadline is start_us (default: now)
+    void Start(uint32_t period_us_, uint64_t start_us = Now_us()) {
+        period_us = period_us_ ? period_us_ : 1;
+        start = start_us;
+        index = 0;
+        stats = {};
+    }
+    uint32_t Period_us() const { return period_us; };
+    MMC5983MA_HybridDelay_C delay; ///< final approach to each deadline
+    /// Sleep until the next deadline and return it (Now_us() is then the actual start time).
+    /// Returns 0 without waiting for the deadline if *abort becomes true.
+    uint64_t WaitNext(const std::atomic<bool> *abort = nullptr) {
+        uint64_t now = Now_us();
+        uint64_t deadline = start + index*period_us;
+        if(index > 0 && now > deadline) { // previous cycle ran past this deadline
+            stats.overruns++;
+            if(now >= deadline + period_us) { // ...and past the one after: skip those missed entirely
+                uint64_t missed = (now - deadline) / period_us;
+                stats.skippedPeriods += (uint32_t)missed;
+                index += missed;
+                deadline += missed*period_us;
+            }
+        }
+        // Sleep in steps of at most 50ms, so an abort request is seen promptly even with long periods;
+        // the last step sleeps-then-spins (MMC5983MA_HybridDelay_C) to start close to the deadline.
+        while(now < deadline) {
+            if(abort && abort->load()) return 0;
+            uint64_t step_us = std::min<uint64_t>(deadline - now, 50000);
+            if(now + step_us >= deadline) delay.Delay_us((uint32_t)step_us);
+            else std::this_thread::sleep_for(std::chrono::microseconds(step_us));
+            now = Now_us();
+        }
+        int64_t lateness = (int64_t)(now - deadline);
+        if(stats.cycles == 0 || lateness < stats.minLateness_us) stats.minLateness_us = lateness;
+        if(stats.cycles == 0 || lateness > stats.maxLateness_us) stats.maxLateness_us = lateness;
+        stats.sumLateness_us += (double)lateness;
+        stats.sumSqLateness_us += (double)lateness*(double)lateness;
+        stats.cycles++;
+        index++;
+        return deadline;
+    }
+
+  private:
+    uint32_t period_us = 1000000;
+    uint64_t start = 0;
+    uint64_t index = 0; ///< number of the next deadline
+};
+
+#endif // MMC5983MA_SCHEDULER_HPP_INCLUDED
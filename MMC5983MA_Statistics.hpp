@@ -0,0 +1,140 @@
+/// MMC5983MA_Statistics.hpp - MMC5983MA_FieldStatistics_C class - running per-axis and magnitude mean/noise, session and windowed.
+
+/*
+MIT License
+
+Copyright (c) 2023-2025 Dave Nadler
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef MMC5983MA_STATISTICS_HPP_INCLUDED
+#define MMC5983MA_STATISTICS_HPP_INCLUDED
+
+#include <stdint.h>
+#include <math.h>
+
+/// Running count, mean and variance (Welford's update; no cancellation trouble with a large mean like
+/// an axis sitting at 400mG with 1mG of noise). Merge combines two disjoint runs exactly (Chan et al.).
+struct MMC5983MA_Welford_T {
+    uint32_t n;
+    double mean;
+    double m2;    ///< sum of squared deviations from the mean
+    double min, max;
+    void Add(double x) {
+        if(n == 0) min = max = x;
+        else if(x < min) min = x;
+        else if(x > max) max = x;
+        n++;
+        double d = x - mean;
+        mean += d / n;
+        m2 += d * (x - mean);
+    }
+    void Merge(const MMC5983MA_Welford_T &o) {
+        if(o.n == 0) return;
+        if(n == 0) { *this = o; return; }
+        uint32_t total = n + o.n;
+        double d = o.mean - mean;
+        mean += d * o.n / total;
+        m2 += o.m2 + d * d * ((double)n * o.n / total);
+        if(o.min < min) min = o.min;
+        if(o.max > max) max = o.max;
+        n = total;
+    }
+    /// Sample variance (n-1)
+    double Variance() const { return n > 1 ? m2 / (n - 1) : 0.0; };
+    /// Standard deviation, ie RMS noise about the mean
+    double StdDev() const { return sqrt(Variance()); };
+};
+
+/// Mean and noise of the X, Y, Z field and its magnitude, over the whole session and over sliding windows
+/// of the most recent samples. Add is O(1) and nothing is allocated: each window is kept as WINDOW_BLOCKS
+/// block summaries (the oldest block is dropped as a new one starts) rather than as a history of samples,
+/// so a window covers its most recent length samples to within one block (length/WINDOW_BLOCKS).
+/// Not thread-safe: update and read from one thread.
+template <int WINDOWS = 2, int WINDOW_BLOCKS = 8>
+class MMC5983MA_FieldStatistics_C {
+  public:
+    typedef enum { X, Y, Z, Magnitude, Channels } Channel_T;
+    static const int Windows = WINDOWS;
+    /// One set of per-channel statistics
+    struct View_T {
+        MMC5983MA_Welford_T channel[Channels];
+        uint32_t Count() const { return channel[X].n; };
+    };
+    static const char *ChannelName(int c) {
+        static const char *names[] = { "X", "Y", "Z", "|B|" };
+        return c >= 0 && c < Channels ? names[c] : "?";
+    }
+
+    MMC5983MA_FieldStatistics_C() {
+        for(int w = 0; w < WINDOWS; w++) SetWindowLength(w, 64u << (4*w)); // 64, 1024, ... samples
+    }
+    /// Length of window w in samples (rounded up to a multiple of WINDOW_BLOCKS); restarts that window
+    void SetWindowLength(int w, uint32_t samples) {
+        Window_T &win = windows[w];
+        win.blockLength = samples / WINDOW_BLOCKS + (samples % WINDOW_BLOCKS != 0);
+        if(win.blockLength == 0) win.blockLength = 1;
+        for(int b = 0; b < WINDOW_BLOCKS; b++) win.block[b] = {};
+        win.current = 0;
+    }
+    uint32_t WindowLength(int w) const { return windows[w].blockLength * WINDOW_BLOCKS; };
+    void Reset() {
+        session = {};
+        for(int w = 0; w < WINDOWS; w++) SetWindowLength(w, WindowLength(w));
+    }
+
+    void Add(const double (&field_mG)[3]) {
+        double x[Channels] = { field_mG[0], field_mG[1], field_mG[2],
+            sqrt(field_mG[0]*field_mG[0] + field_mG[1]*field_mG[1] + field_mG[2]*field_mG[2]) };
+        for(int c = 0; c < Channels; c++) session.channel[c].Add(x[c]);
+        for(int w = 0; w < WINDOWS; w++) {
+            Window_T &win = windows[w];
+            if(win.block[win.current].Count() >= win.blockLength) { // start a new block, dropping the oldest
+                win.current = (win.current + 1) % WINDOW_BLOCKS;
+                win.block[win.current] = {};
+            }
+            for(int c = 0; c < Channels; c++) win.block[win.current].channel[c].Add(x[c]);
+        }
+    }
+
+    /// Everything since construction or Reset
+    const View_T &Session() const { return session; };
+    /// The most recent WindowLength(w) samples (fewer until that many have been added)
+    View_T Window(int w) const {
+        const Window_T &win = windows[w];
+        View_T v = {};
+        for(int b = 1; b <= WINDOW_BLOCKS; b++) { // oldest first
+            const View_T &block = win.block[(win.current + b) % WINDOW_BLOCKS];
+            for(int c = 0; c < Channels; c++) v.channel[c].Merge(block.channel[c]);
+        }
+        return v;
+    }
+
+  protected:
+    struct Window_T {
+        View_T block[WINDOW_BLOCKS];
+        uint32_t blockLength;
+        int current;         ///< block being filled
+    };
+    View_T session = {};
+    Window_T windows[WINDOWS];
+};
+
+#endif // MMC5983MA_STATISTICS_HPP_INCLUDED
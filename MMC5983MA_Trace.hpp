@@ -0,0 +1,119 @@
+/// MMC5983MA_Trace.hpp - MMC5983MA_Trace_C class - binary register-IO trace for MMC5983MA_C.
+
+/*
+MIT License
+
+Copyright (c) 2023-2025 Dave Nadler
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef MMC5983MA_TRACE_HPP_INCLUDED
+#define MMC5983MA_TRACE_HPP_INCLUDED
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <type_traits>
+#include "MMC5983MA_Ring.hpp"
+
+/// One register byte read from or written to the sensor
+struct MMC5983MA_TraceRecord_T {
+    typedef enum : uint8_t { Read = 0, Write = 1 } Direction_T;
+    typedef enum : uint8_t { OK = 0, Failed = 1, Batched = 2 } Status_T; ///< Status bits
+    uint64_t time_us;   ///< TDEVICE::time_us() when the transaction (or batch) completed
+    uint32_t sequence;  ///< Increments per record, including records dropped because the ring was full
+    uint8_t reg;        ///< Register address
+    uint8_t value;      ///< Byte read or written
+    Direction_T dir;
+    uint8_t status;     ///< Status_T bits: Failed if the IO (or its batch) failed, Batched if sent in a batch
+};
+static_assert(sizeof(MMC5983MA_TraceRecord_T) == 16 && std::is_trivially_copyable<MMC5983MA_TraceRecord_T>::value,
+    "trace records are written to files as-is");
+
+/// Register-IO trace: MMC5983MA_C records each register byte it reads or writes here (see
+/// MMC5983MA_C::registerTrace). Recording is a timestamp plus a store into a lock-free ring,
+/// cheap enough to leave on in production; formatting happens later, on the consumer's thread
+/// (Drain/Format), or offline from a file written by WriteFile (see MMC5983MA_TraceDecode.cpp).
+/// One producer (the thread using the driver) and one consumer, as for MMC5983MA_Ring_C.
+/// If the consumer falls behind, new records are dropped and counted, and the decoder reports the
+/// gap in sequence numbers.
+class MMC5983MA_Trace_C {
+  public:
+    static const size_t Capacity = 4096; ///< Records (64kB); ~180 RESET/SET measurements
+    bool enabled = true;                 ///< false: Record does nothing (leave attached, pause tracing)
+
+    /// Producer: append one record
+    void Record(uint64_t time_us, uint8_t reg, uint8_t value, MMC5983MA_TraceRecord_T::Direction_T dir, uint8_t status) {
+        if(!enabled) return;
+        ring.Push({ time_us, sequence++, reg, value, dir, status });
+    }
+    /// Consumer: pass each queued record to fn(const MMC5983MA_TraceRecord_T&); returns number drained
+    template <typename F>
+    size_t Drain(F fn) {
+        MMC5983MA_TraceRecord_T r;
+        size_t n = 0;
+        while(ring.Pop(r)) { fn(r); n++; }
+        return n;
+    }
+    /// Records dropped because the ring was full
+    uint32_t Dropped() const { return ring.Overruns(); };
+
+    /// Trace file: FileHeader_T followed by records, in host byte order
+    struct FileHeader_T {
+        char magic[8];       ///< "MMCTRACE"
+        uint32_t version;    ///< FileVersion
+        uint32_t recordSize; ///< sizeof(MMC5983MA_TraceRecord_T)
+    };
+    static const uint32_t FileVersion = 1;
+    static bool WriteFileHeader(FILE *f) {
+        FileHeader_T h = { {'M','M','C','T','R','A','C','E'}, FileVersion, sizeof(MMC5983MA_TraceRecord_T) };
+        return fwrite(&h, sizeof(h), 1, f) == 1;
+    }
+    static bool ReadFileHeader(FILE *f) {
+        FileHeader_T h;
+        return fread(&h, sizeof(h), 1, f) == 1 && memcmp(h.magic, "MMCTRACE", 8) == 0 &&
+               h.version == FileVersion && h.recordSize == sizeof(MMC5983MA_TraceRecord_T);
+    }
+    /// Consumer: append all queued records to a file (after WriteFileHeader); returns false on write error
+    bool WriteFile(FILE *f) {
+        bool ok = true;
+        Drain([&](const MMC5983MA_TraceRecord_T &r) { ok = ok && fwrite(&r, sizeof(r), 1, f) == 1; });
+        return ok;
+    }
+
+    /// Render one record like the former printf trace ("get_reg 08 Device status => 11"),
+    /// followed by its timestamp. registerName(uint8_t reg) is normally MMC5983MA_C<>::RegisterName
+    /// (MMC5983MA_C::FormatTraceRecord supplies it). Returns snprintf's result.
+    template <typename NameF>
+    static int Format(char *buf, size_t size, const MMC5983MA_TraceRecord_T &r, NameF registerName) {
+        bool write = r.dir == MMC5983MA_TraceRecord_T::Write;
+        return snprintf(buf, size, "%s %02x %s %s %02x @%llu%s%s",
+            write ? "set_reg" : "get_reg", r.reg, registerName(r.reg), write ? "<=" : "=>", r.value,
+            (unsigned long long)r.time_us,
+            (r.status & MMC5983MA_TraceRecord_T::Batched) ? " batched" : "",
+            (r.status & MMC5983MA_TraceRecord_T::Failed) ? " FAILED" : "");
+    }
+
+  private:
+    MMC5983MA_Ring_C<MMC5983MA_TraceRecord_T, Capacity> ring;
+    uint32_t sequence = 0; ///< producer only
+};
+
+#endif // MMC5983MA_TRACE_HPP_INCLUDED
@@ -0,0 +1,83 @@
+// MMC5983MA_TraceDecode.cpp - print a binary MMC5983MA register-IO trace file (MMC5983MA_Trace_C::WriteFile)
+
+/*
+MIT License
+
+Copyright (c) 2023-2025 Dave Nadler
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+// usage: MMC5983MA_TraceDecode tracefile [tracefile...]
+// Prints one line per register byte in the format of the former MMC5983MA_PRINT_DETAILED_LOG trace,
+// with timestamps, and notes where records were dropped (gaps in sequence numbers).
+
+#include <stdio.h>
+#include <stdarg.h>
+
+#include "MMC5983MA.hpp"
+#include "MMC5983MA_IO.hpp"
+
+// Only RegisterName/FormatTraceRecord are used; no IO happens here.
+typedef MMC5983MA_C<MMC5983MA_IO_base_C> MMC5983MA_Decoder_C;
+int MMC5983MA_IO_base_C::DiagPrintf(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    int n = vfprintf(stderr, format, args);
+    va_end(args);
+    return n;
+}
+
+static int DecodeFile(const char *path) {
+    FILE *f = fopen(path, "rb");
+    if(!f) { fprintf(stderr, "Can't open '%s'\n", path); return 1; }
+    if(!MMC5983MA_Trace_C::ReadFileHeader(f)) {
+        fprintf(stderr, "'%s' is not an MMC5983MA trace file (or is a different version)\n", path);
+        fclose(f);
+        return 1;
+    }
+    MMC5983MA_TraceRecord_T r;
+    uint32_t records = 0, dropped = 0, failed = 0;
+    uint32_t expected = 0;
+    char line[120];
+    while(fread(&r, sizeof(r), 1, f) == 1) {
+        if(records && r.sequence != expected) {
+            printf("... %u records dropped\n", r.sequence - expected);
+            dropped += r.sequence - expected;
+        }
+        expected = r.sequence + 1;
+        records++;
+        if(r.status & MMC5983MA_TraceRecord_T::Failed) failed++;
+        MMC5983MA_Decoder_C::FormatTraceRecord(line, sizeof(line), r);
+        puts(line);
+    }
+    fclose(f);
+    fprintf(stderr, "%s: %u records, %u dropped, %u failed\n", path, records, dropped, failed);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    if(argc < 2) {
+        fprintf(stderr, "usage: MMC5983MA_TraceDecode tracefile [tracefile...]\n");
+        return 2;
+    }
+    int rc = 0;
+    for(int i = 1; i < argc; i++) rc |= DecodeFile(argv[i]);
+    return rc;
+}